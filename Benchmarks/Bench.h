@@ -0,0 +1,142 @@
+/*
+ * Benchmark harness
+ *
+ * A kernel is a function running n operations and returning something computed from them (summed into a
+ * volatile so the work can't be optimized away). The harness doubles n until one run takes at least
+ * minTime, then times repeats runs of that n and reports the median and the fastest ns per operation
+ * and the throughput. Results are written as Google Benchmark style JSON (benchmarks[] with name,
+ * iterations, real_time, cpu_time, time_unit and items_per_second), so the usual comparison tools read
+ * them, with the compiler and flags in the context to tell builds apart.
+ */
+
+#ifndef _BENCH_HEADER_
+#define _BENCH_HEADER_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef BENCH_FLAGS
+#define BENCH_FLAGS "unknown"
+#endif
+
+namespace Bench {
+
+  struct Options {
+    double      minTime = 0.2; // seconds of one run
+    int         repeats = 5;
+    std::string filter;        // only kernels with this in their name
+  };
+
+  struct Result {
+    std::string name;
+    uint64_t    iterations;  // operations per run
+    int         repeats;
+    double      nsPerOp;     // median of the runs
+    double      minNsPerOp;
+    double      cpuNsPerOp;  // median process cpu time
+    double      opsPerSec;   // at the median
+  };
+
+  static volatile double sink = 0.0;
+
+  inline bool selected(const std::string &name , const Options &options) {
+    return( options.filter.empty() || name.find( options.filter ) != std::string::npos );
+  };
+
+  // wall and cpu seconds of n operations
+  template< class Kernel >
+  void time(Kernel &kernel , uint64_t n , double &wall , double &cpu) {
+    std::clock_t cpuStart = std::clock();
+    auto         start    = std::chrono::steady_clock::now();
+    sink = sink + kernel( n );
+    wall = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    cpu  = double( std::clock() - cpuStart ) / CLOCKS_PER_SEC;
+  };
+
+  template< class Kernel >
+  Result measure(const std::string &name , Kernel kernel , const Options &options) {
+    // calibrate, a warm up on the way
+    uint64_t n = 1;
+    double   wall , cpu;
+    while( true ) {
+      time( kernel , n , wall , cpu );
+      if( wall >= options.minTime || n >= ( uint64_t(1) << 40 ) ) { break; }
+      double grow = wall > 0.0 ? 1.4 * options.minTime / wall : 100.0;
+      n = static_cast< uint64_t >( n * std::max( 2.0 , std::min( grow , 100.0 ) ) );
+    }
+
+    std::vector< double > walls , cpus;
+    for( int r = 0; r < options.repeats; r++ ) {
+      time( kernel , n , wall , cpu );
+      walls.push_back( 1.0e9 * wall / n );
+      cpus.push_back( 1.0e9 * cpu / n );
+    }
+    std::sort( walls.begin() , walls.end() );
+    std::sort( cpus.begin() , cpus.end() );
+
+    Result result;
+    result.name       = name;
+    result.iterations = n;
+    result.repeats    = options.repeats;
+    result.nsPerOp    = walls[ walls.size() / 2 ];
+    result.minNsPerOp = walls.front();
+    result.cpuNsPerOp = cpus[ cpus.size() / 2 ];
+    result.opsPerSec  = result.nsPerOp > 0.0 ? 1.0e9 / result.nsPerOp : 0.0;
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << result.nsPerOp << " ns/op" << std::setw(14) << result.minNsPerOp << " min"
+              << std::setprecision(0) << std::setw(16) << result.opsPerSec << " /s" << std::endl;
+    return( result );
+  };
+
+  inline std::string quoted(const std::string &s) {
+    std::string q = "\"";
+    for( char c : s ) {
+      if( c == '"' || c == '\\' ) { q += '\\'; }
+      q += c;
+    }
+    return( q + "\"" );
+  };
+
+  // the machine and build the results are of
+  inline void writeContext(std::ostream &out) {
+    char host[256] = "unknown";
+    gethostname( host , sizeof(host) - 1 );
+    std::time_t now = std::time( nullptr );
+    char date[32];
+    std::strftime( date , sizeof(date) , "%Y-%m-%dT%H:%M:%S" , std::localtime( &now ) );
+
+    out << "  \"context\": {\n"
+        << "    \"date\": " << quoted( date ) << ",\n"
+        << "    \"host_name\": " << quoted( host ) << ",\n"
+        << "    \"num_cpus\": " << sysconf( _SC_NPROCESSORS_ONLN ) << ",\n"
+        << "    \"compiler\": " << quoted( __VERSION__ ) << ",\n"
+        << "    \"flags\": " << quoted( BENCH_FLAGS ) << "\n"
+        << "  },\n";
+  };
+
+  inline void writeJSON(const std::string &filename , const std::vector< Result > &results) {
+    std::ofstream out( filename );
+    out << std::setprecision(6) << "{\n";
+    writeContext( out );
+    out << "  \"benchmarks\": [\n";
+    for( size_t i = 0; i < results.size(); i++ ) {
+      const Result &r = results[i];
+      out << "    {\"name\": " << quoted( r.name ) << ", \"iterations\": " << r.iterations << ", \"repetitions\": " << r.repeats
+          << ", \"real_time\": " << r.nsPerOp << ", \"min_real_time\": " << r.minNsPerOp << ", \"cpu_time\": " << r.cpuNsPerOp
+          << ", \"time_unit\": \"ns\", \"items_per_second\": " << r.opsPerSec << "}" << ( i + 1 < results.size() ? ",\n" : "\n" );
+    }
+    out << "  ]\n}\n";
+    std::cout << "Results written to " << filename << std::endl;
+  };
+}
+
+#endif
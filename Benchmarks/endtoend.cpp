@@ -0,0 +1,275 @@
+/*
+ * End to end benchmark
+ *
+ *   endtoend [--exec ./a.out] [--input berpinpolyinair.xml] [--meshes coarse,medium,berpinpolyinair]
+ *            [--histories 1000,4000] [--workers 1,2] [--json file] [--baseline file] [--make-baseline histories]
+ *
+ * Runs the reference problem (inputfiles/berpinpolyinair.xml) with every mesh, history count and number of
+ * worker processes of the sweep through --set overrides, and reads back the --summary each run writes: setup,
+ * transport and output seconds, histories per second and peak resident memory (of the parent, and of the
+ * largest worker). Parallel efficiency is the rate with N workers over N times the rate with one, for the same
+ * mesh and history count. Every history seeds its random numbers from its index, so a run is repeatable.
+ *
+ * Each run's cell and surface tallies are checked against a stored baseline, within statistics: a bin fails
+ * if its mean is more than 4 combined standard errors from the baseline's. The baseline only holds the bins
+ * that scored with some spread, a bin with no standard error (never scored in the reference, or the same
+ * score every history) has no statistics to check against and is left out. Tet and mesh tallies depend on the
+ * mesh and aren't compared, the cell tallies are the same whatever the mesh. --make-baseline runs a long
+ * reference (on the coarse mesh, the quickest) and writes the baseline file instead of the sweep. The
+ * baseline's first histories are the runs' histories, so the check is lenient: it catches a build that
+ * gets the physics or the tallies wrong, not a small bias.
+ *
+ * Run from the top of the repository, after make.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "ResultFile.h"
+
+namespace {
+
+  const std::string resultName  = "endtoend.bin";   // in outfiles/
+  const std::string summaryName = "outfiles/endtoend.json";
+  const std::string logName     = "outfiles/endtoend.log";
+  const double      maxSigma    = 4.0;
+
+  struct Run {
+    std::string mesh;
+    int         histories;
+    int         workers;
+    double      setup , transport , output , rate;
+    uint64_t    peakMemory , peakWorkerMemory;
+    double      efficiency;  // negative without a one worker run to compare with
+    std::string check;       // "pass", "fail" or "no baseline"
+    double      maxZ;        // largest difference from the baseline in standard errors
+    int         binsChecked;
+  };
+
+  struct BaselineBin {
+    double mean;
+    double stdErr;
+  };
+
+  std::vector< std::string > split(const std::string &list) {
+    std::vector< std::string > items;
+    std::istringstream in( list );
+    for( std::string item; std::getline( in , item , ',' ); ) {
+      if( ! item.empty() ) { items.push_back( item ); }
+    }
+    return( items );
+  }
+
+  // a number from a flat JSON object, 0 if it isn't there
+  double field(const std::string &json , const std::string &key) {
+    size_t at = json.find( "\"" + key + "\"" );
+    if( at == std::string::npos ) { return( 0.0 ); }
+    at = json.find( ':' , at );
+    return( std::strtod( json.c_str() + at + 1 , nullptr ) );
+  }
+
+  bool compared(const std::string &appliedTo) {
+    return( appliedTo.compare( 0 , 5 , "cell " ) == 0 || appliedTo.compare( 0 , 8 , "surface " ) == 0 );
+  }
+
+  // tally \t applied to \t bin , mean and standard error of each bin, # lines are comments
+  std::map< std::string , BaselineBin > readBaseline(const std::string &filename) {
+    std::map< std::string , BaselineBin > bins;
+    std::ifstream in( filename );
+    for( std::string line; std::getline( in , line ); ) {
+      if( line.empty() || line[0] == '#' ) { continue; }
+      std::istringstream fields( line );
+      std::string name , appliedTo , bin;
+      BaselineBin b;
+      std::getline( fields , name , '\t' );
+      std::getline( fields , appliedTo , '\t' );
+      std::getline( fields , bin , '\t' );
+      fields >> b.mean >> b.stdErr;
+      bins[ name + "\t" + appliedTo + "\t" + bin ] = b;
+    }
+    return( bins );
+  }
+
+  void writeBaseline(const std::string &filename , const std::string &input , ResultReader &results) {
+    std::ofstream out( filename );
+    out << "# cell and surface tally bins of " << input << " with a standard error, " << results.getNumHistories() << " histories" << std::endl;
+    out << "# tally\tapplied to\tbin\tmean\tstandard error" << std::endl;
+    out << std::setprecision(17);
+    for( int t = 0; t < results.getNumTallies(); t++ ) {
+      const TallyIndex &tally = results.getTally(t);
+      if( ! compared( tally.appliedTo ) ) { continue; }
+      for( uint64_t j = 0; j < tally.numBins; j++ ) {
+        if( results.getStdErr(t)[j] <= 0.0 ) { continue; }
+        out << tally.name << '\t' << tally.appliedTo << '\t' << j << '\t'
+            << results.getMean(t)[j] << '\t' << results.getStdErr(t)[j] << std::endl;
+      }
+    }
+    std::cout << "Baseline of " << results.getNumHistories() << " histories written to " << filename << std::endl;
+  }
+
+  void check(Run &run , ResultReader &results , const std::map< std::string , BaselineBin > &baseline) {
+    run.maxZ        = 0.0;
+    run.binsChecked = 0;
+    run.check       = "no baseline";
+    if( baseline.empty() ) { return; }
+    for( int t = 0; t < results.getNumTallies(); t++ ) {
+      const TallyIndex &tally = results.getTally(t);
+      if( ! compared( tally.appliedTo ) ) { continue; }
+      for( uint64_t j = 0; j < tally.numBins; j++ ) {
+        auto b = baseline.find( tally.name + "\t" + tally.appliedTo + "\t" + std::to_string(j) );
+        if( b == baseline.end() || b->second.stdErr <= 0.0 ) { continue; }
+        double diff  = std::fabs( results.getMean(t)[j] - b->second.mean );
+        double sigma = std::sqrt( std::pow( results.getStdErr(t)[j] , 2 ) + std::pow( b->second.stdErr , 2 ) );
+        double z     = sigma > 0.0 ? diff / sigma : ( diff > 0.0 ? INFINITY : 0.0 );
+        run.maxZ = std::fmax( run.maxZ , z );
+        run.binsChecked++;
+      }
+    }
+    run.check = run.binsChecked == 0 ? "no baseline" : ( run.maxZ <= maxSigma ? "pass" : "fail" );
+  }
+
+  std::string readFile(const std::string &filename) {
+    std::ifstream in( filename );
+    std::stringstream text;
+    text << in.rdbuf();
+    return( text.str() );
+  }
+
+  // one run of the executable, false if it failed
+  bool execute(const std::string &exec , const std::string &input , const std::string &mesh , int histories , int workers) {
+    std::remove( summaryName.c_str() );
+    std::string command = exec + " " + input
+                        + " --set setup.meshfile=" + mesh + ".thrm"
+                        + " --set setup.nhistories=" + std::to_string( histories )
+                        + " --set outfiles.resultfile=" + resultName
+                        + " --set outfiles.progressevery=0"
+                        + " --summary " + summaryName
+                        + ( workers > 1 ? " --workers " + std::to_string( workers ) : "" )
+                        + " > " + logName + " 2>&1";
+    if( std::system( command.c_str() ) != 0 || readFile( summaryName ).empty() ) {
+      std::cout << " " << command << " failed, see " << logName << std::endl;
+      return( false );
+    }
+    return( true );
+  }
+}
+
+int main(int argc , char *argv[])
+{
+    std::string exec         = "./a.out";
+    std::string input        = "berpinpolyinair.xml";
+    std::string meshList     = "coarse,medium,berpinpolyinair";
+    std::string historyList  = "1000,4000";
+    std::string workerList   = "1,2";
+    std::string jsonFilename = "Benchmarks/endtoend.json";
+    std::string baselineName = "Benchmarks/baseline.txt";
+    int         baselineHistories = 0;
+    for ( int i = 1; i < argc; i++ ) {
+        std::string arg = argv[i];
+        if      ( arg == "--exec"          && i + 1 < argc ) { exec         = argv[++i]; }
+        else if ( arg == "--input"         && i + 1 < argc ) { input        = argv[++i]; }
+        else if ( arg == "--meshes"        && i + 1 < argc ) { meshList     = argv[++i]; }
+        else if ( arg == "--histories"     && i + 1 < argc ) { historyList  = argv[++i]; }
+        else if ( arg == "--workers"       && i + 1 < argc ) { workerList   = argv[++i]; }
+        else if ( arg == "--json"          && i + 1 < argc ) { jsonFilename = argv[++i]; }
+        else if ( arg == "--baseline"      && i + 1 < argc ) { baselineName = argv[++i]; }
+        else if ( arg == "--make-baseline" && i + 1 < argc ) { baselineHistories = std::stoi( argv[++i] ); }
+        else {
+            std::cout << "usage: endtoend [--exec ./a.out] [--input file.xml] [--meshes a,b] [--histories n,m] [--workers 1,2]"
+                      << " [--json file] [--baseline file] [--make-baseline histories]" << std::endl;
+            return 1;
+        }
+    }
+
+    if ( baselineHistories > 0 ) {
+        if ( ! execute( exec , input , "coarse" , baselineHistories , 1 ) ) { return 1; }
+        ResultReader results( "outfiles/" + resultName );
+        writeBaseline( baselineName , input , results );
+        return 0;
+    }
+
+    std::map< std::string , BaselineBin > baseline = readBaseline( baselineName );
+    if ( baseline.empty() ) {
+        std::cout << "No baseline in " << baselineName << ", tallies won't be checked." << std::endl;
+    }
+
+    std::cout << std::left << std::setw(18) << "mesh" << std::right << std::setw(10) << "histories" << std::setw(8) << "workers"
+              << std::setw(10) << "setup s" << std::setw(12) << "transport s" << std::setw(10) << "output s"
+              << std::setw(12) << "hist/s" << std::setw(12) << "peak MB" << std::setw(12) << "efficiency" << std::setw(14) << "tallies" << std::endl;
+
+    std::vector< Run > runs;
+    std::map< std::string , double > serialRate; // of mesh and histories
+    bool failed = false;
+    for ( auto mesh : split( meshList ) ) {
+        for ( auto h : split( historyList ) ) {
+            for ( auto w : split( workerList ) ) {
+                Run run;
+                run.mesh      = mesh;
+                run.histories = std::stoi( h );
+                run.workers   = std::stoi( w );
+                if ( ! execute( exec , input , mesh , run.histories , run.workers ) ) {
+                    failed = true;
+                    continue;
+                }
+
+                std::string summary  = readFile( summaryName );
+                run.setup            = field( summary , "setup_seconds" );
+                run.transport        = field( summary , "transport_seconds" );
+                run.output           = field( summary , "output_seconds" );
+                run.rate             = field( summary , "histories_per_second" );
+                run.peakMemory       = field( summary , "peak_resident_bytes" );
+                run.peakWorkerMemory = field( summary , "peak_worker_resident_bytes" );
+
+                std::string key = mesh + " " + h;
+                if ( run.workers == 1 ) { serialRate[key] = run.rate; }
+                run.efficiency = serialRate.count( key ) ? run.rate / ( run.workers * serialRate[key] ) : -1.0;
+
+                ResultReader results( "outfiles/" + resultName );
+                check( run , results , baseline );
+                failed = failed || run.check == "fail";
+
+                std::ostringstream efficiency , tallies;
+                if ( run.efficiency >= 0.0 ) { efficiency << std::fixed << std::setprecision(2) << run.efficiency; }
+                else                         { efficiency << "-"; }
+                tallies << run.check;
+                if ( run.binsChecked > 0 ) { tallies << " " << std::fixed << std::setprecision(1) << run.maxZ << "s"; }
+                std::cout << std::left << std::setw(18) << mesh << std::right << std::setw(10) << run.histories << std::setw(8) << run.workers
+                          << std::fixed << std::setprecision(2) << std::setw(10) << run.setup << std::setw(12) << run.transport
+                          << std::setw(10) << run.output << std::setprecision(0) << std::setw(12) << run.rate
+                          << std::setprecision(1) << std::setw(12) << std::max( run.peakMemory , run.peakWorkerMemory ) / ( 1024.0 * 1024.0 )
+                          << std::setw(12) << efficiency.str() << std::setw(14) << tallies.str() << std::endl;
+                runs.push_back( run );
+            }
+        }
+    }
+
+    std::ofstream out( jsonFilename );
+    out << std::setprecision(6) << "{\n";
+    Bench::writeContext( out );
+    out << "  \"executable\": " << Bench::quoted( exec ) << ",\n  \"input\": " << Bench::quoted( input ) << ",\n  \"runs\": [\n";
+    for ( size_t i = 0; i < runs.size(); i++ ) {
+        const Run &r = runs[i];
+        out << "    {\"mesh\": " << Bench::quoted( r.mesh ) << ", \"histories\": " << r.histories << ", \"workers\": " << r.workers
+            << ", \"setup_seconds\": " << r.setup << ", \"transport_seconds\": " << r.transport << ", \"output_seconds\": " << r.output
+            << ", \"histories_per_second\": " << r.rate << ", \"peak_resident_bytes\": " << r.peakMemory
+            << ", \"peak_worker_resident_bytes\": " << r.peakWorkerMemory;
+        if ( r.efficiency >= 0.0 ) { out << ", \"parallel_efficiency\": " << r.efficiency; }
+        out << ", \"tallies\": " << Bench::quoted( r.check ) << ", \"bins_checked\": " << r.binsChecked;
+        if ( r.binsChecked > 0 && std::isfinite( r.maxZ ) ) { out << ", \"max_sigma\": " << r.maxZ; }
+        out << "}" << ( i + 1 < runs.size() ? ",\n" : "\n" );
+    }
+    out << "  ]\n}\n";
+    std::cout << "Results written to " << jsonFilename << std::endl;
+
+    std::remove( ( "outfiles/" + resultName ).c_str() );
+    std::remove( summaryName.c_str() );
+    return( failed ? 1 : 0 );
+}
@@ -0,0 +1,252 @@
+/*
+ * Microbenchmarks of the transport kernels
+ *
+ *   microbench [--filter name] [--json file] [--min-time seconds] [--repeats n] [--input berpinpolyinair.xml]
+ *
+ * Run from the top of the repository, the problem is inputfiles/berpinpolyinair.xml (or a larger one from
+ * Tools/generate, for how the geometry and mesh lookups scale) and the meshes are read from meshfiles/.
+ *
+ * Points, directions and random numbers fed to the kernels are drawn up front from a fixed seed, so every
+ * run and every build times the same operations; the points are centroids of random tets, inside the
+ * problem, and each kernel cycles through a table of them that stays in cache (a mesh lookup still reads
+ * the tets of its grid cell). Only rand/Urand times the random number generator.
+ */
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "Input.h"
+
+namespace {
+
+  const size_t tableSize = 1024; // points, directions and particles cycled through
+
+  std::mt19937_64 engine( 20190501 );
+
+  double uniform(double a , double b) {
+    return( std::uniform_real_distribution< double >( a , b )( engine ) );
+  }
+
+  point isotropic() {
+    double mu  = uniform( -1.0 , 1.0 );
+    double phi = uniform( 0.0 , 2.0 * 3.14159265358979 );
+    double s   = std::sqrt( 1.0 - mu * mu );
+    return( point( s * std::cos(phi) , s * std::sin(phi) , mu ) );
+  }
+
+  // centroids of random tets of the mesh
+  std::vector< point > meshPoints(std::shared_ptr< Mesh > mesh) {
+    std::vector< Tet_ptr > tets = mesh->getTets();
+    std::uniform_int_distribution< size_t > pick( 0 , tets.size() - 1 );
+    std::vector< point > points;
+    for( size_t i = 0; i < tableSize; i++ ) {
+      std::vector< double > c = tets[ pick( engine ) ]->getCentroid();
+      points.push_back( point( c[0] , c[1] , c[2] ) );
+    }
+    return( points );
+  }
+
+  // setup output isn't part of the results
+  class Quiet {
+    private:
+      std::streambuf*   saved;
+      std::stringstream discard;
+    public:
+      Quiet()  { saved = std::cout.rdbuf( discard.rdbuf() ); };
+     ~Quiet()  { std::cout.rdbuf( saved ); };
+  };
+}
+
+int main(int argc , char *argv[])
+{
+    Bench::Options options;
+    std::string    jsonFilename;
+    std::string    inputFilename = "berpinpolyinair.xml";
+    for ( int i = 1; i < argc; i++ ) {
+        std::string arg = argv[i];
+        if      ( arg == "--filter"   && i + 1 < argc ) { options.filter  = argv[++i]; }
+        else if ( arg == "--json"     && i + 1 < argc ) { jsonFilename    = argv[++i]; }
+        else if ( arg == "--min-time" && i + 1 < argc ) { options.minTime = std::stod( argv[++i] ); }
+        else if ( arg == "--repeats"  && i + 1 < argc ) { options.repeats = std::max( 1 , std::stoi( argv[++i] ) ); }
+        else if ( arg == "--input"    && i + 1 < argc ) { inputFilename   = argv[++i]; }
+        else {
+            std::cout << "usage: microbench [--filter name] [--json file] [--min-time seconds] [--repeats n] [--input file]" << std::endl;
+            return 1;
+        }
+    }
+
+    // the problem and the coarse and medium meshes
+    std::shared_ptr< Input > input = std::make_shared< Input >();
+    std::shared_ptr< Mesh >  coarse , medium;
+    {
+        Quiet quiet;
+        input->readInput( "inputfiles/" + inputFilename );
+        coarse = std::make_shared< Mesh >( "coarse.thrm" , false , input->getConstants() );
+        medium = std::make_shared< Mesh >( "medium.thrm" , false , input->getConstants() );
+    }
+    std::shared_ptr< Geometry > geometry = input->getGeometry();
+    std::shared_ptr< Mesh >     mesh     = input->getMesh();
+    int                         nGroups  = input->getConstants()->getNumGroups();
+
+    std::vector< point > points = meshPoints( mesh );
+    std::vector< point > dirs;
+    std::vector< Part_ptr > particles;
+    for ( size_t i = 0; i < tableSize; i++ ) {
+        dirs.push_back( isotropic() );
+        particles.push_back( std::make_shared< Particle >( points[i] , dirs[i] , 1 + i % nGroups ) );
+    }
+    std::vector< double > mus , rands;
+    for ( size_t i = 0; i < tableSize; i++ ) {
+        mus.push_back( uniform( -1.0 , 1.0 ) );
+        rands.push_back( uniform( 0.0 , 1.0 ) );
+    }
+
+    std::vector< Bench::Result > results;
+    auto run = [&]( const std::string &name , std::function< double( uint64_t ) > kernel ) {
+        if ( Bench::selected( name , options ) ) {
+            results.push_back( Bench::measure( name , kernel , options ) );
+        }
+    };
+
+    // distance to each kind of surface, from points in and around the problem
+    std::vector< std::pair< std::string , std::shared_ptr< surface > > > surfaces = {
+        { "plane"     , std::make_shared< plane >( "p" , 0.3 , 0.4 , 0.866 , 1.0 ) },
+        { "sphere"    , std::make_shared< sphere >( "s" , 0.0 , 0.0 , 0.0 , 5.0 ) },
+        { "xCylinder" , std::make_shared< xCylinder >( "x" , 0.0 , 0.0 , 5.0 ) },
+        { "yCylinder" , std::make_shared< yCylinder >( "y" , 0.0 , 0.0 , 5.0 ) },
+        { "zCylinder" , std::make_shared< zCylinder >( "z" , 0.0 , 0.0 , 5.0 ) } };
+    for ( auto &s : surfaces ) {
+        std::shared_ptr< surface > surf = s.second;
+        run( "surface/distance/" + s.first , [&]( uint64_t n ) {
+            double sum = 0.0;
+            for ( uint64_t i = 0; i < n; i++ ) {
+                double d = surf->distance( points[ i % tableSize ] , dirs[ ( i * 7 ) % tableSize ] );
+                sum += d < 1.0e300 ? d : 0.0;
+            }
+            return( sum );
+        } );
+    }
+
+    std::vector< Cell_ptr > cells = geometry->getCells();
+    run( "cell/amIHere" , [&]( uint64_t n ) {
+        double found = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            found += cells[ i % cells.size() ]->amIHere( points[ i % tableSize ] );
+        }
+        return( found );
+    } );
+
+    run( "geometry/whereAmI" , [&]( uint64_t n ) {
+        double found = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            found += geometry->whereAmI( points[ i % tableSize ] ) != nullptr;
+        }
+        return( found );
+    } );
+
+    // the grid index of each mesh, with points of its own
+    std::vector< std::pair< std::string , std::shared_ptr< Mesh > > > meshes = {
+        { "coarse" , coarse } , { "medium" , medium } , { inputFilename.substr( 0 , inputFilename.rfind('.') ) , mesh } };
+    for ( auto &m : meshes ) {
+        std::shared_ptr< Mesh > searched = m.second;
+        std::vector< point >    inside   = meshPoints( searched );
+        run( "mesh/whereAmI/" + m.first , [&]( uint64_t n ) {
+            double found = 0.0;
+            for ( uint64_t i = 0; i < n; i++ ) {
+                found += searched->whereAmI( inside[ i % tableSize ] ) != nullptr;
+            }
+            return( found );
+        } );
+    }
+
+    // mostly misses, as in the mesh search
+    std::vector< Tet_ptr > tets = mesh->getTets();
+    std::vector< Tet_ptr > someTets;
+    std::vector< std::vector< double > > testPoints;
+    std::uniform_int_distribution< size_t > pick( 0 , tets.size() - 1 );
+    for ( size_t i = 0; i < tableSize; i++ ) {
+        someTets.push_back( tets[ pick( engine ) ] );
+        testPoints.push_back( { points[i].x , points[i].y , points[i].z } );
+    }
+    run( "tet/amIHere" , [&]( uint64_t n ) {
+        double found = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            found += someTets[ i % tableSize ]->amIHere( testPoints[ ( i * 7 ) % tableSize ] );
+        }
+        return( found );
+    } );
+
+    std::vector< Mat_ptr > materials;
+    for ( auto cell : cells ) {
+        if ( cell->getMat() ) { materials.push_back( cell->getMat() ); }
+    }
+    run( "material/getMacroXS" , [&]( uint64_t n ) {
+        double sum = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            sum += materials[ i % materials.size() ]->getMacroXS( particles[ i % tableSize ] );
+        }
+        return( sum );
+    } );
+
+    // the secondary bank is never touched by scattering
+    std::vector< std::vector< double > > scatterXS( nGroups , std::vector< double >( nGroups , 1.0 ) );
+    Scatter scatter( nGroups , scatterXS );
+    std::stack< Part_ptr > bank;
+    run( "scatter/sample" , [&]( uint64_t n ) {
+        double sum = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            Part_ptr p = particles[ i % tableSize ];
+            scatter.sample( p , bank );
+            sum += p->getGroup();
+        }
+        return( sum );
+    } );
+
+    Rand generator;
+    run( "rand/Urand" , [&]( uint64_t n ) {
+        double sum = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            sum += generator.Urand();
+        }
+        return( sum );
+    } );
+
+    run( "particle/rotate" , [&]( uint64_t n ) {
+        double sum = 0.0;
+        for ( uint64_t i = 0; i < n; i++ ) {
+            Part_ptr p = particles[ i % tableSize ];
+            p->rotate( mus[ i % tableSize ] , rands[ ( i * 7 ) % tableSize ] );
+            sum += p->getDir().z;
+        }
+        return( sum );
+    } );
+
+    // score() itself is protected, scoreCollision is what transport calls: the bin, then flux and responses
+    if ( ! geometry->getEstimators().empty() ) {
+        EstCol_ptr tally = geometry->getEstimators().front();
+        std::vector< const double* > xsRows;
+        for ( size_t i = 0; i < tableSize; i++ ) {
+            xsRows.push_back( materials.front()->getMacroXSRow( particles[i] ) );
+        }
+        run( "estimatorCollection/scoreCollision" , [&]( uint64_t n ) {
+            for ( uint64_t i = 0; i < n; i++ ) {
+                tally->scoreCollision( particles[ i % tableSize ] , xsRows[ i % tableSize ] );
+            }
+            return( 0.0 );
+        } );
+    }
+    else if ( Bench::selected( "estimatorCollection/scoreCollision" , options ) ) {
+        std::cout << "estimatorCollection/scoreCollision skipped, " << inputFilename << " has no estimators" << std::endl;
+    }
+
+    if ( ! jsonFilename.empty() ) {
+        Bench::writeJSON( jsonFilename , results );
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
  */
 
 #include "Cell.h"
+#include "Memory.h"
 
 double Cell::distToCollision(Part_ptr pi)
 {
@@ -14,16 +15,14 @@ double Cell::distToCollision(Part_ptr pi)
 
 bool Cell::amIHere( const point& pos )
 {
-  bool isWithin = true;
   //cycle through each surface and if there is one that has a incorrect eval, you are not in this cell
   for(auto surfacePair: surfacePairs)
   {
     bool posInSurface = (surfacePair.first->eval(pos) < 0); //is the position inside(true) or out of the surface
     bool cellInSurface = surfacePair.second;
-    bool match = posInSurface == cellInSurface;
-    isWithin = isWithin == match;
+    if ( posInSurface != cellInSurface ) { return false; } // two wrong sides must not cancel out
   }
-  return isWithin;
+  return true;
 }
 
 pair<Surf_ptr, double> Cell::closestSurface(Part_ptr p)
@@ -61,12 +60,12 @@ double Cell::distToSurface(Part_ptr pi)
 
 // Estimator interface
 
-void Cell::scoreTally(Part_ptr p , double xs) 
+void Cell::scoreTally(Part_ptr p , const double* xs) 
 {
-  // for each EstimatorCollection
-    // for each attribute
-      // get the index of the Estimator to score
-      // score the estimator
+  // each EstimatorCollection finds the index of its Estimator to score from the particle attributes
+  for(auto est : estimators) {
+      est->scoreCollision(p , xs);
+  }
 }
 
 void Cell::endTallyHist() 
@@ -76,3 +75,6 @@ void Cell::endTallyHist()
   }
 }
 
+uint64_t Cell::memoryUsage() {
+  return( Memory::shared< Cell >() + Memory::bytes( cellName ) + Memory::bytes( surfacePairs ) + Memory::bytes( estimators ) );
+}
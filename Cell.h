@@ -58,6 +58,7 @@ public:
 
   Mat_ptr                   getMat()        { return mat;        };
   std::string               name()          { return cellName;   };
+  uint64_t                  memoryUsage(); // bytes of the cell and its surface and estimator lists
   std::vector< EstCol_ptr > getEstimators() { return estimators; };
   
   //operations
@@ -68,7 +69,7 @@ public:
   bool amIHere( const point& pos );
 
   // Estimator interface
-  void scoreTally(Part_ptr p , double xs); 
+  void scoreTally(Part_ptr p , const double* xs); // xs is the material macroscopic xs row
   void endTallyHist();
   // TODO get Tally output
 };
@@ -0,0 +1,149 @@
+/*
+ * Checkpoint file
+ */
+
+#include "Checkpoint.h"
+
+#include <cstring>
+#include <fstream>
+
+#include <unistd.h>
+
+static uint64_t padded(uint64_t numBytes) {
+  return( ( numBytes + 7 ) / 8 * 8 );
+}
+
+/* ****************************************************************************************************** *
+ * Checkpoint Writer
+ *
+ * ****************************************************************************************************** */
+
+CheckpointWriter::CheckpointWriter(string filenamein , string magic) : filename(filenamein) , tmpFilename(filenamein + ".tmp") {
+  out = fopen( tmpFilename.c_str() , "wb" );
+  if( ! out ) {
+    std::cout << " could not open checkpoint file " << tmpFilename << std::endl;
+    throw;
+  }
+  fwrite( magic.data() , 1 , 8 , out );
+  writeWord(version);
+};
+
+CheckpointWriter::~CheckpointWriter() {
+  // never committed, leave the previous checkpoint alone
+  if( out ) {
+    fclose(out);
+    std::remove( tmpFilename.c_str() );
+  }
+};
+
+void CheckpointWriter::writeWord(uint64_t word) {
+  fwrite( &word , 8 , 1 , out );
+};
+
+void CheckpointWriter::writeDouble(double value) {
+  fwrite( &value , 8 , 1 , out );
+};
+
+void CheckpointWriter::writeString(const string &s) {
+  static const char zeros[8] = { 0 };
+  writeWord( s.size() );
+  fwrite( s.data() , 1 , s.size() , out );
+  fwrite( zeros , 1 , padded( s.size() ) - s.size() , out );
+};
+
+void CheckpointWriter::writeArray(const vector< double > &values) {
+  writeWord( values.size() );
+  fwrite( values.data() , 8 , values.size() , out );
+};
+
+void CheckpointWriter::writeArray(const vector< uint64_t > &values) {
+  writeWord( values.size() );
+  fwrite( values.data() , 8 , values.size() , out );
+};
+
+void CheckpointWriter::commit() {
+  bool ok = fflush(out) == 0 && fsync( fileno(out) ) == 0;
+  ok = ( fclose(out) == 0 ) && ok;
+  out = nullptr;
+  if( ! ok || std::rename( tmpFilename.c_str() , filename.c_str() ) != 0 ) {
+    std::cout << " could not write checkpoint file " << filename << std::endl;
+    throw;
+  }
+};
+
+/* ****************************************************************************************************** *
+ * Checkpoint Reader
+ *
+ * ****************************************************************************************************** */
+
+CheckpointReader::CheckpointReader(string filenamein , string magic) : filename(filenamein) , position(0) {
+  std::ifstream in( filename , std::ios::binary | std::ios::ate );
+  if( ! in ) {
+    std::cout << " could not open checkpoint file " << filename << std::endl;
+    throw;
+  }
+  data.resize( in.tellg() );
+  in.seekg(0);
+  in.read( data.data() , data.size() );
+
+  char fileMagic[8];
+  read( fileMagic , 8 );
+  if( string( fileMagic , 8 ) != magic || readWord() != 1 ) {
+    std::cout << " " << filename << " is not a " << ( magic == "HMRSHARD" ? "shard" : "checkpoint" ) << " file this version can read" << std::endl;
+    throw;
+  }
+};
+
+void CheckpointReader::read(void* to , uint64_t numBytes) {
+  if( numBytes > data.size() - position ) {
+    std::cout << " checkpoint file " << filename << " is truncated" << std::endl;
+    throw;
+  }
+  std::memcpy( to , data.data() + position , numBytes );
+  position += numBytes;
+};
+
+uint64_t CheckpointReader::readWord() {
+  uint64_t word;
+  read( &word , 8 );
+  return(word);
+};
+
+double CheckpointReader::readDouble() {
+  double value;
+  read( &value , 8 );
+  return(value);
+};
+
+string CheckpointReader::readString() {
+  uint64_t length = readWord();
+  if( padded(length) > data.size() - position ) {
+    std::cout << " checkpoint file " << filename << " is truncated" << std::endl;
+    throw;
+  }
+  string s( data.data() + position , length );
+  position += padded(length);
+  return(s);
+};
+
+vector< double > CheckpointReader::readDoubles() {
+  uint64_t n = readWord();
+  if( n > ( data.size() - position ) / 8 ) {
+    std::cout << " checkpoint file " << filename << " is truncated" << std::endl;
+    throw;
+  }
+  vector< double > values(n);
+  read( values.data() , 8 * n );
+  return(values);
+};
+
+vector< uint64_t > CheckpointReader::readWords() {
+  uint64_t n = readWord();
+  if( n > ( data.size() - position ) / 8 ) {
+    std::cout << " checkpoint file " << filename << " is truncated" << std::endl;
+    throw;
+  }
+  vector< uint64_t > values(n);
+  read( values.data() , 8 * n );
+  return(values);
+};
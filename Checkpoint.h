@@ -0,0 +1,84 @@
+/*
+ * Checkpoint file
+ *
+ * Everything a run needs to carry on from a batch boundary: the next history, the batch plan and, for
+ * every tally, the running sums, batch means and FOM history of each Estimator. The random number
+ * generator needs nothing saved, each history seeds itself by skipping ahead from its own index.
+ *
+ * Layout (little endian, 8 byte words):
+ *   header       "HMRCHKPT" , version , then the Transport state (see Transport::writeCheckpoint)
+ *   collections  name , appliedTo (uint64 length then characters, padded) , then the collection state
+ *                (see EstimatorCollection::writeState)
+ *
+ * The file is written next to its final name and renamed over it once it is complete and synced, so a
+ * run killed while checkpointing leaves the previous checkpoint intact.
+ *
+ * Run shards use the same container with "HMRSHARD" in place of "HMRCHKPT" (see Transport::runTransport).
+ */
+
+#ifndef _CHECKPOINT_HEADER_
+#define _CHECKPOINT_HEADER_
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::vector;
+using std::string;
+
+/* ****************************************************************************************************** *
+ * Checkpoint Writer
+ *  nothing replaces the previous checkpoint until commit()
+ * ****************************************************************************************************** */
+
+class CheckpointWriter {
+  private:
+    string  filename;
+    string  tmpFilename;
+    FILE*   out;
+
+    static const uint64_t version = 1;
+
+  public:
+    CheckpointWriter(string filenamein , string magic = "HMRCHKPT");
+   ~CheckpointWriter();
+
+    void writeWord(uint64_t word);
+    void writeDouble(double value);
+    void writeString(const string &s);
+    void writeArray(const vector< double > &values);    // length then values
+    void writeArray(const vector< uint64_t > &values);
+
+    // sync the file and move it over the previous checkpoint
+    void commit();
+};
+
+/* ****************************************************************************************************** *
+ * Checkpoint Reader
+ *  reads in the order things were written, a short or foreign file is an error
+ * ****************************************************************************************************** */
+
+class CheckpointReader {
+  private:
+    string           filename;
+    vector< char >   data;
+    uint64_t         position;
+
+    void read(void* to , uint64_t numBytes);
+
+  public:
+    CheckpointReader(string filenamein , string magic = "HMRCHKPT");
+   ~CheckpointReader() {};
+
+    uint64_t           readWord();
+    double             readDouble();
+    string             readString();
+    vector< double >   readDoubles();
+    vector< uint64_t > readWords();
+
+    string getFilename() { return(filename); };
+};
+
+#endif
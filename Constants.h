@@ -17,9 +17,11 @@ class Constants
 private:
     int numGroups;
     unsigned long long numHis;
+    int numBatches = 10;        // histories are run in this many equal batches
+    double wallTimeLimit = 0.0; // stop after this many seconds of transport, 0 for no limit
     double tolerance = std::numeric_limits<double>::epsilon();
     bool allTets = false;
-    bool locked;
+    bool locked = false;
     
 public:
     Constants() {};
@@ -33,6 +35,16 @@ public:
         return numGroups;
     }
 
+    int getNumBatches()
+    {
+        return numBatches;
+    }
+
+    double getWallTimeLimit()
+    {
+        return wallTimeLimit;
+    }
+
     bool getAllTets()
     {
         return allTets;
@@ -66,6 +78,30 @@ public:
             cout << "Access denied. Constants are locked." << endl;
         }
     }
+    void setNumBatches(int numBatchesi)
+    {
+        if(!locked)
+        {
+            numBatches = numBatchesi;
+        }
+        else
+        {
+            cout << "Access denied. Constants are locked." << endl;
+        }
+    }
+
+    void setWallTimeLimit(double wallTimeLimiti)
+    {
+        if(!locked)
+        {
+            wallTimeLimit = wallTimeLimiti;
+        }
+        else
+        {
+            cout << "Access denied. Constants are locked." << endl;
+        }
+    }
+
     void setAllTets()
     {
         if(!locked)
@@ -0,0 +1,137 @@
+/*
+ * Spatial cost profile
+ */
+
+#include "CostProfile.h"
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+#include "Memory.h"
+#include "TextWriter.h"
+
+CostProfile::CostProfile( std::shared_ptr< Geometry > geometryin , std::shared_ptr< Mesh > meshin ) :
+  geometry(geometryin) , mesh(meshin) , lastEvent(0)
+{
+  vector< Cell_ptr > allCells = geometry->getCells();
+  for( unsigned int c = 0; c < allCells.size(); c++ ) {
+    cellIndex[ allCells[c].get() ] = c;
+  }
+  cells.resize( allCells.size() );
+  tets.resize( mesh->getTets().size() );
+};
+
+CostProfile::Cost* CostProfile::cellCost( const Cell_ptr &cell ) {
+  if( ! cell ) { return nullptr; }
+  return( &cells[ cellIndex[ cell.get() ] ] );
+};
+
+CostProfile::Cost* CostProfile::tetCost( const point &pos ) {
+  int tet = mesh->locate( pos );
+  return( tet < 0 ? nullptr : &tets[tet] );
+};
+
+void CostProfile::source( const Cell_ptr &cell , const point &pos ) {
+  Cost* c = cellCost( cell );
+  Cost* t = tetCost( pos );
+  if( c ) { c->locates++; }
+  if( t ) { t->locates++; }
+  lastEvent = now();
+};
+
+void CostProfile::collision( const Cell_ptr &cell , const point &pos ) {
+  uint64_t elapsed = now() - lastEvent;
+  Cost* c = cellCost( cell );
+  Cost* t = tetCost( pos );
+  if( c ) { c->collisions++; c->time += elapsed; }
+  if( t ) { t->collisions++; t->time += elapsed; }
+  lastEvent = now();
+};
+
+void CostProfile::crossing( const Cell_ptr &from , const Cell_ptr &to , const point &pos ) {
+  uint64_t elapsed = now() - lastEvent;
+  // the locate finds the cell on the other side, or the one left if there is none
+  Cost* c = cellCost( from );
+  Cost* l = to ? cellCost( to ) : c;
+  Cost* t = tetCost( pos );
+  if( c ) { c->crossings++; c->time += elapsed; }
+  if( l ) { l->locates++; }
+  if( t ) { t->crossings++; t->locates++; t->time += elapsed; }
+  lastEvent = now();
+};
+
+void CostProfile::write( CheckpointWriter &out ) const {
+  for( const vector< Cost >* regions : { &cells , &tets } ) {
+    vector< uint64_t > words;
+    for( const Cost &cost : *regions ) {
+      words.insert( words.end() , { cost.collisions , cost.crossings , cost.locates , cost.time } );
+    }
+    out.writeArray( words );
+  }
+};
+
+void CostProfile::add( CheckpointReader &in ) {
+  for( vector< Cost >* regions : { &cells , &tets } ) {
+    vector< uint64_t > words = in.readWords();
+    if( words.size() != 4 * regions->size() ) {
+      std::cout << " the cost profile in " << in.getFilename() << " is of a different geometry or mesh than the input" << std::endl;
+      throw;
+    }
+    for( unsigned int r = 0; r < regions->size(); r++ ) {
+      (*regions)[r].collisions += words[4*r];
+      (*regions)[r].crossings  += words[4*r + 1];
+      (*regions)[r].locates    += words[4*r + 2];
+      (*regions)[r].time       += words[4*r + 3];
+    }
+  }
+};
+
+void CostProfile::addCellData() {
+  vector< Tet_ptr > allTets = mesh->getTets();
+
+  // the cell of each tet, by its centroid
+  vector< Cost* > tetCells( allTets.size() );
+  for( unsigned int t = 0; t < allTets.size(); t++ ) {
+    vector< double > centroid = allTets[t]->getCentroid();
+    tetCells[t] = cellCost( geometry->whereAmI( point( centroid[0] , centroid[1] , centroid[2] ) ) );
+  }
+
+  auto add = [&]( string name , std::function< double ( const Cost & ) > value ) {
+    vector< double > tetValues( allTets.size() ) , cellValues( allTets.size() , 0.0 );
+    for( unsigned int t = 0; t < allTets.size(); t++ ) {
+      tetValues[t] = value( tets[t] );
+      if( tetCells[t] ) { cellValues[t] = value( *tetCells[t] ); }
+    }
+    mesh->addCellData( "profile tet " + name , std::move(tetValues) );
+    mesh->addCellData( "profile cell " + name , std::move(cellValues) );
+  };
+  add( "collisions" , []( const Cost &cost ) { return( static_cast<double>( cost.collisions ) ); } );
+  add( "crossings"  , []( const Cost &cost ) { return( static_cast<double>( cost.crossings ) ); } );
+  add( "locates"    , []( const Cost &cost ) { return( static_cast<double>( cost.locates ) ); } );
+  add( "time (s)"   , []( const Cost &cost ) { return( 1.0e-9 * cost.time ); } );
+};
+
+void CostProfile::writeTable( string filename ) {
+  std::cout << "Writing the cost profile of the cells to " << filename << "..." << std::endl;
+
+  uint64_t total = 0;
+  for( const Cost &cost : cells ) { total += cost.time; }
+
+  std::ofstream out;
+  out.open( filename );
+  out << "Cost profile, time spent on particles in each cell" << std::endl;
+  out << "cell   collisions   crossings   locates   time (s)   fraction of time" << std::endl;
+  vector< Cell_ptr > allCells = geometry->getCells();
+  for( unsigned int c = 0; c < allCells.size(); c++ ) {
+    out << allCells[c]->name() << "   " << cells[c].collisions << "   " << cells[c].crossings << "   " << cells[c].locates << "   "
+        << Text::shortest( 1.0e-9 * cells[c].time ) << "   " << Text::shortest( total > 0 ? static_cast<double>( cells[c].time ) / total : 0.0 ) << std::endl;
+  }
+  out.close();
+};
+
+uint64_t CostProfile::memoryUsage() const {
+  // the map's nodes are a pointer, an int and the link to the next node
+  return( Memory::bytes( cells ) + Memory::bytes( tets ) + cellIndex.size() * ( sizeof( std::pair< Cell* const , int > ) + sizeof(void*) ) 
+        + cellIndex.bucket_count() * sizeof(void*) );
+}
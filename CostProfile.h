@@ -0,0 +1,85 @@
+/*
+ * Spatial cost profile
+ *
+ * Where in the geometry transport spends its time. For every cell and every tet of the mesh it counts
+ * collisions, surface crossings and whereAmI (locate) calls, and adds up the wall clock time spent on
+ * particles there: the time from a particle's previous event (its start, or its last collision or crossing)
+ * to the next one goes to the cell it flew through and the tet the event happened in.
+ *
+ * Finding the tet is a search over the whole mesh, so it's done after the clock is read and the clock is
+ * restarted once the profile is updated; the profile's own cost isn't in the times it records. It still
+ * slows the run down, so it's only on with outfiles profile="true".
+ *
+ * The tet arrays, and each tet painted with the numbers of the cell holding its centroid, go into the mesh
+ * VTK file through Mesh::writeToVTK, so ParaView shows the hot spots directly (over-refined regions, cells
+ * with many surfaces). The cells are also listed in a table.
+ */
+
+#ifndef _COSTPROFILE_HEADER_
+#define _COSTPROFILE_HEADER_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Cell.h"
+#include "Checkpoint.h"
+#include "Geometry.h"
+#include "Mesh.h"
+#include "Point.h"
+
+using std::vector;
+using std::string;
+
+class CostProfile {
+  private:
+    // one region's counts, ns for the time
+    struct Cost {
+      uint64_t collisions;
+      uint64_t crossings;
+      uint64_t locates;
+      uint64_t time;
+      Cost() : collisions(0) , crossings(0) , locates(0) , time(0) {};
+    };
+
+    std::shared_ptr< Geometry >        geometry;
+    std::shared_ptr< Mesh >            mesh;
+    std::unordered_map< Cell* , int >  cellIndex;
+    vector< Cost >                     cells;
+    vector< Cost >                     tets;
+    uint64_t                           lastEvent; // ns
+
+    static uint64_t now() {
+      return( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+    };
+
+    Cost* cellCost( const Cell_ptr &cell );
+    Cost* tetCost( const point &pos );
+
+  public:
+    CostProfile( std::shared_ptr< Geometry > geometryin , std::shared_ptr< Mesh > meshin );
+   ~CostProfile() {};
+
+    // a particle starts flying, from the source (whose cell was just located) or from the bank
+    void source( const Cell_ptr &cell , const point &pos );
+    void startFlight() { lastEvent = now(); };
+
+    // the particle's time since its last event goes to the cell it was in
+    void collision( const Cell_ptr &cell , const point &pos );
+    void crossing( const Cell_ptr &from , const Cell_ptr &to , const point &pos ); // to is null if the particle was lost
+
+    // the profile of a shard, after its counters
+    void write( CheckpointWriter &out ) const;
+    void add( CheckpointReader &in );
+
+    // tet and cell arrays on the mesh for its VTK file, and the cell table
+    void addCellData();
+    void writeTable( string filename );
+
+    uint64_t memoryUsage() const;
+};
+
+#endif
@@ -5,17 +5,39 @@
  */
 #include <cmath>
 #include "Estimator.h"
+#include "Memory.h"
 
 // functions
 void Estimator::endHist() {
-  // set the current history tally and square tally running sums
-  histTally    += currentHistTally;
-  histTallySqr += pow( currentHistTally , 2 );
+  // nothing was scored this history, adding zeros wouldn't change any of the sums
+  if ( currentHistTally == 0.0 ) { return; }
+
+  // set the current history tally and power tally running sums for this batch
+  double sqr      = currentHistTally * currentHistTally;
+  batchTally     += currentHistTally;
+  batchTallySqr  += sqr;
+  batchTallyCub  += sqr * currentHistTally;
+  batchTallyQuad += sqr * sqr;
   
   // set the current hist tally to 0
   currentHistTally = 0;
 };
 
+void Estimator::endBatch(unsigned long long nBatchHist) {
+  // keep the batch mean and fold the batch sums into the run totals
+  batchMeans.push_back( nBatchHist > 0 ? batchTally / nBatchHist : 0.0 );
+
+  histTally     += batchTally;
+  histTallySqr  += batchTallySqr;
+  histTallyCub  += batchTallyCub;
+  histTallyQuad += batchTallyQuad;
+
+  batchTally     = 0.0;
+  batchTallySqr  = 0.0;
+  batchTallyCub  = 0.0;
+  batchTallyQuad = 0.0;
+};
+
 void Estimator::score(double val) {
   currentHistTally += val;
 };
@@ -26,8 +48,8 @@ std::pair < double , double > Estimator::getScalarEstimator(unsigned long long n
     std::pair < double , double >  estimate;
     if (nHist > 1) {
         // find the standard deviation of the estimator
-        double stdDev = sqrt( ( 1.0 / (nHist-1) ) * ( histTallySqr  - ( 1.0 / nHist ) * pow( histTally , 2 )  ) ); 
-        estimate.first  = histTally / nHist;
+        double stdDev = sqrt( ( 1.0 / (nHist-1) ) * ( getHistTallySqr()  - ( 1.0 / nHist ) * pow( getHistTally() , 2 )  ) ); 
+        estimate.first  = getHistTally() / nHist;
         estimate.second = stdDev;
     }
     else {
@@ -38,6 +60,101 @@ std::pair < double , double > Estimator::getScalarEstimator(unsigned long long n
     return(estimate);
 };
 
+double Estimator::getRelativeError(unsigned long long nHist) {
+// standard error of the mean over the mean
+// an estimator that has never been scored has no relative error to speak of, call it 1
+  double s1 = getHistTally();
+  double s2 = getHistTallySqr();
+  if ( nHist < 2 || s1 == 0.0 ) { return(1.0); }
+
+  double n   = static_cast<double>(nHist);
+  double var = ( s2 / ( s1 * s1 ) - 1.0 / n ) * n / ( n - 1.0 );
+  return( var > 0.0 ? sqrt( var ) : 0.0 );
+};
+
+double Estimator::getVOV(unsigned long long nHist) {
+// relative variance of the variance of the mean, from the first four sums
+// (e.g. MCNP manual ch. 2), should be below 0.1 for a reliable confidence interval
+  double s1 = getHistTally();
+  double s2 = getHistTallySqr();
+  double s3 = getHistTallyCub();
+  double s4 = getHistTallyQuad();
+  if ( nHist < 2 || s1 == 0.0 ) { return(1.0); }
+
+  double n     = static_cast<double>(nHist);
+  double m     = s1 / n;
+  double denom = s2 - s1 * m;
+  if ( denom <= 0.0 ) { return(0.0); }
+
+  double numer = s4 - 4.0 * m * s3 + 6.0 * m * m * s2 - 3.0 * m * m * m * s1;
+  return( numer / ( denom * denom ) - 1.0 / n );
+};
+
+double Estimator::getFOM(unsigned long long nHist , double time) {
+  // no FOM for an estimator that has never been scored
+  double r = getRelativeError(nHist);
+  if ( getHistTally() == 0.0 || r <= 0.0 || time <= 0.0 ) { return(0.0); }
+  return( 1.0 / ( r * r * time ) );
+};
+
+void Estimator::recordFOM(unsigned long long nHist , double time) {
+  fomHistory.push_back( getFOM(nHist , time) );
+};
+
+bool Estimator::hasStableFOM() {
+// the FOM should be roughly constant once the tally has converged, so a trend or a large
+// spread over the last half of the batches means R isn't falling as 1/sqrt(N) yet
+// (rare large scores, an undersampled region, ...)
+  int nBatch = fomHistory.size();
+  if ( nBatch < 4 ) { return(true); } // not enough batches to tell
+
+  double fomMin = fomHistory[nBatch / 2];
+  double fomMax = fomHistory[nBatch / 2];
+  double fomSum = 0.0;
+  for ( int i = nBatch / 2; i < nBatch; ++i ) {
+    fomMin  = fmin( fomMin , fomHistory[i] );
+    fomMax  = fmax( fomMax , fomHistory[i] );
+    fomSum += fomHistory[i];
+  }
+  double fomMean = fomSum / ( nBatch - nBatch / 2 );
+  if ( fomMean <= 0.0 ) { return(true); } // never scored
+
+  return( ( fomMax - fomMin ) <= fomTolerance * fomMean );
+};
+
+void Estimator::writeState(CheckpointWriter &out) {
+  // the batch sums are empty between batches
+  out.writeDouble( histTally     );
+  out.writeDouble( histTallySqr  );
+  out.writeDouble( histTallyCub  );
+  out.writeDouble( histTallyQuad );
+  out.writeArray( batchMeans );
+  out.writeArray( fomHistory );
+};
+
+void Estimator::readState(CheckpointReader &in) {
+  histTally     = in.readDouble();
+  histTallySqr  = in.readDouble();
+  histTallyCub  = in.readDouble();
+  histTallyQuad = in.readDouble();
+  batchMeans    = in.readDoubles();
+  fomHistory    = in.readDoubles();
+};
+
+void Estimator::writeBatchSums(CheckpointWriter &out) {
+  out.writeDouble( batchTally     );
+  out.writeDouble( batchTallySqr  );
+  out.writeDouble( batchTallyCub  );
+  out.writeDouble( batchTallyQuad );
+};
+
+void Estimator::addBatchSums(CheckpointReader &in) {
+  batchTally     += in.readDouble();
+  batchTallySqr  += in.readDouble();
+  batchTallyCub  += in.readDouble();
+  batchTallyQuad += in.readDouble();
+};
+
 /*
  *
 //functions
@@ -50,3 +167,7 @@ void CollisionTally::score( double xs ) {
      currentHistTally +=  1.0 / xs;
 };
 */
+
+uint64_t Estimator::memoryUsage() {
+  return( Memory::shared< Estimator >() + Memory::bytes( batchMeans ) + Memory::bytes( fomHistory ) );
+}
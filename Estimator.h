@@ -11,27 +11,70 @@
 #include <vector>
 #include <memory> 
 
+#include "Checkpoint.h"
+
 using std::vector;
 using std::string;
 
 class Estimator {
+  // history scores are summed into running sums of their first four powers, which is
+  // enough to get the mean, relative error and variance of the variance at any time
+  // sums are accumulated per batch first and folded into the run totals in endBatch(),
+  // so the totals only depend on the batch partials and the order they are added in
   protected:
     double currentHistTally;
     double histTally;
     double histTallySqr;
+    double histTallyCub;
+    double histTallyQuad;
+    double batchTally;
+    double batchTallySqr;
+    double batchTallyCub;
+    double batchTallyQuad;
+    vector< double > batchMeans; // mean score per history in each completed batch
+    vector< double > fomHistory; // figure of merit recorded at the end of each batch
 
   public:
-    Estimator(): currentHistTally(0.0) , histTally(0.0) , histTallySqr(0.0) {}; 
+    // the FOM over the last half of the batches should stay within this fraction of its mean
+    static constexpr double fomTolerance = 0.1;
+
+    Estimator(): currentHistTally(0.0) , histTally(0.0) , histTallySqr(0.0) , histTallyCub(0.0) , histTallyQuad(0.0) ,
+                 batchTally(0.0) , batchTallySqr(0.0) , batchTallyCub(0.0) , batchTallyQuad(0.0) {}; 
    ~Estimator() {};
     
     // set/gets
-    double getCurrentHistTally() { return( currentHistTally ); };
-    double getHistTally()    	   { return( histTally        ); };
-    double getHistTallySqr() 	   { return( histTallySqr     ); };
+    double getCurrentHistTally() { return( currentHistTally               ); };
+    double getHistTally()    	   { return( histTally     + batchTally     ); };
+    double getHistTallySqr() 	   { return( histTallySqr  + batchTallySqr  ); };
+    double getHistTallyCub()     { return( histTallyCub  + batchTallyCub  ); };
+    double getHistTallyQuad()    { return( histTallyQuad + batchTallyQuad ); };
+    vector< double > getBatchMeans() { return( batchMeans ); };
+    bool             scoredThisBatch() { return( batchTallySqr != 0.0 ); };
+    vector< double > getFOMHistory() { return( fomHistory ); };
     
     // estimator methods
     void endHist();
+    void endBatch(unsigned long long nBatchHist);
     std::pair < double , double > getScalarEstimator(unsigned long long);
+
+    // statistics of the mean after nHist histories
+    double getRelativeError(unsigned long long nHist);          // std error of the mean / mean
+    double getVOV(unsigned long long nHist);                    // relative variance of the variance of the mean
+    double getFOM(unsigned long long nHist , double time);      // 1 / ( R^2 T )
+
+    // FOM as a function of history count, and whether it has settled down
+    void recordFOM(unsigned long long nHist , double time);
+    bool hasStableFOM();
+
+    uint64_t memoryUsage(); // bytes, with its batch means and FOM history
+
+    // running sums, batch means and FOM history, for checkpoints (only at a batch boundary)
+    void writeState(CheckpointWriter &out);
+    void readState(CheckpointReader &in);
+
+    // sums of the batch in progress, written by a run shard and added back in when shards are merged
+    void writeBatchSums(CheckpointWriter &out);
+    void addBatchSums(CheckpointReader &in);
     
     // virtual estimator methods
     virtual void score( double val);
@@ -7,14 +7,18 @@
  */
 
 #include <cassert>
+#include <cmath>
 #include "EstimatorCollection.h"
+#include "Material.h"
+#include "Memory.h"
 
 /* ****************************************************************************************************** * 
  * Base Estimator Collection                                   
  *
  * ****************************************************************************************************** */ 
 
-EstimatorCollection::EstimatorCollection(std::map< string , Bin_ptr > attributesin): attributes(attributesin) 
+EstimatorCollection::EstimatorCollection(string label , std::map< string , Bin_ptr > attributesin): 
+  estimatorName(label) , relErrTarget(0.0) , attributes(attributesin) , responses(1 , "flux") , responseXS(1 , -1)
 {
 // default constructor calculates number of estimators required
   size = 1;
@@ -65,6 +69,129 @@ void EstimatorCollection::endHist() {
   }
 };
 
+void EstimatorCollection::endBatch(unsigned long long nBatchHist) {
+  for(auto estimator : estimators) {
+    estimator->endBatch(nBatchHist);
+  }
+};
+
+void EstimatorCollection::recordFOM(unsigned long long nHist , double time) {
+  for(auto estimator : estimators) {
+    estimator->recordFOM(nHist , time);
+  }
+};
+
+void EstimatorCollection::writeState(CheckpointWriter &out) {
+  out.writeWord( estimators.size() );
+  for(auto estimator : estimators) {
+    estimator->writeState(out);
+  }
+};
+
+void EstimatorCollection::readState(CheckpointReader &in) {
+  if( in.readWord() != estimators.size() ) {
+    std::cout << " estimator " << estimatorName << " has a different number of bins than in checkpoint " << in.getFilename() << std::endl;
+    throw;
+  }
+  for(auto estimator : estimators) {
+    estimator->readState(in);
+  }
+};
+
+void EstimatorCollection::writeBatchSums(CheckpointWriter &out) {
+  out.writeWord( estimators.size() );
+  for(auto estimator : estimators) {
+    estimator->writeBatchSums(out);
+  }
+};
+
+void EstimatorCollection::addBatchSums(CheckpointReader &in) {
+  if( in.readWord() != estimators.size() ) {
+    std::cout << " estimator " << estimatorName << " has a different number of bins than in shard " << in.getFilename() << std::endl;
+    throw;
+  }
+  for(auto estimator : estimators) {
+    estimator->addBatchSums(in);
+  }
+};
+
+double EstimatorCollection::getMaxRelativeError(unsigned long long nHist) {
+  // bins that have never been scored (e.g. a group nothing reaches) have nothing to converge,
+  // but a collection with no scores at all is as far from converged as it gets
+  double maxRelErr = 0.0;
+  bool   scored    = false;
+  for(auto estimator : estimators) {
+    if( estimator->getHistTally() != 0.0 ) {
+      maxRelErr = std::fmax( maxRelErr , estimator->getRelativeError(nHist) );
+      scored    = true;
+    }
+  }
+  return( scored ? maxRelErr : 1.0 );
+};
+
+double EstimatorCollection::getMaxVOV(unsigned long long nHist) {
+  double maxVOV = 0.0;
+  for(auto estimator : estimators) {
+    if( estimator->getHistTally() != 0.0 ) {
+      maxVOV = std::fmax( maxVOV , estimator->getVOV(nHist) );
+    }
+  }
+  return(maxVOV);
+};
+
+bool EstimatorCollection::isConverged(unsigned long long nHist) {
+  return( relErrTarget > 0.0 && getMaxRelativeError(nHist) <= relErrTarget );
+};
+
+void EstimatorCollection::setResponses(vector< string > names) {
+  responses.clear();
+  responseXS.clear();
+  for(auto name : names) {
+    int column = Material::getXSIndex(name);
+    if( name != "flux" && column < 0 ) {
+      std::cout << " unknown response " << name << " for estimator " << estimatorName << std::endl;
+      throw;
+    }
+    responses.push_back(name);
+    responseXS.push_back( name == "flux" ? -1 : column );
+  }
+
+  estimators.clear();
+  for(unsigned int i = 0; i < size * responses.size(); ++i) {
+    estimators.push_back( std::make_shared<Estimator>() );
+  }
+};
+
+string EstimatorCollection::getBinLabel(int j) {
+  int n = responses.size();
+  if( n == 1 ) { return( std::to_string(j) ); }
+  return( std::to_string(j / n) + " " + responses[j % n] );
+};
+
+TallyResult EstimatorCollection::getResults(unsigned long long nHist) {
+  int numBins    = estimators.size();
+  int numBatches = numBins > 0 ? estimators[0]->getBatchMeans().size() : 0;
+
+  TallyResult r;
+  r.name      = estimatorName;
+  r.appliedTo = appliedTo;
+  r.batchMeans.resize( numBins * numBatches );
+  for(int j = 0; j < numBins; ++j) {
+    Estimator_ptr est = estimators[j];
+    double m = est->getScalarEstimator(nHist).first;
+    r.labels.push_back( getBinLabel(j) );
+    r.mean.push_back( m );
+    r.stdErr.push_back( std::fabs(m) * est->getRelativeError(nHist) );
+
+    // one column per batch
+    vector< double > batches = est->getBatchMeans();
+    for(int b = 0; b < numBatches; ++b) {
+      r.batchMeans[ b * numBins + j ] = batches[b];
+    }
+  }
+  return(r);
+};
+
 int EstimatorCollection::getLinearIndex(Part_ptr p ) {
   vector<int> indices;
   for(auto const& attribute : attributes) {
@@ -75,14 +202,32 @@ int EstimatorCollection::getLinearIndex(Part_ptr p ) {
     }
     else { 
       // if one of the particle attributes is outisde the binning range, return from the function and don't score any estimators
-      return(0);
+      return(-1);
     }
   }
   return( Utility::linearizeIndices( indices ,  binSizes ) );
 };
 
 void EstimatorCollection::score(Part_ptr p  , double d) {
-  estimators.at( getLinearIndex(p) )->score(d);
+  int index = getLinearIndex(p);
+  if( index >= 0 ) {
+    estimators.at( index )->score(d);
+  }
+}
+
+void EstimatorCollection::scoreResponses(Part_ptr p , const double* xs) {
+  int index = getLinearIndex(p);
+  if( index < 0 ) { return; }
+
+  // collision estimate of the flux, 1 / total
+  scoreRow(index , xs , 1.0 / xs[0]);
+}
+
+void EstimatorCollection::scoreRow(int row , const double* xs , double flux) {
+  int n = responses.size();
+  for(int r = 0; r < n; ++r) {
+    estimators[ row * n + r ]->score( responseXS[r] < 0 ? flux : flux * xs[ responseXS[r] ] );
+  }
 }
 
 /* ****************************************************************************************************** * 
@@ -98,6 +243,198 @@ void EstimatorCollection::score(Part_ptr p  , double d) {
 
 
 void SurfaceFluenceEstimatorCollection::scoreSurfaceFluence(Part_ptr p , point surfNormal ) {
-  // score the cos of the angle bt particle direction and surface normal
-  estimators.at( getLinearIndex(p) )->score( 1 / ( p->getDir() * surfNormal ) );
+  // score the inverse of the cos of the angle bt particle direction and surface normal
+  // crossings in either direction count, and grazing crossings (mu < grazingCosine) score
+  // 2 / grazingCosine, the average of 1/mu over [0 , grazingCosine] for an isotropic flux,
+  // so a single near-tangent track can't give the estimator infinite variance
+  double mu = std::fabs( p->getDir() * surfNormal );
+  score( p , mu > grazingCosine ? 1.0 / mu : 2.0 / grazingCosine );
 };
+
+/* ****************************************************************************************************** * 
+ * Sparse Mesh Estimator Collection                                   
+ *
+ * ****************************************************************************************************** */ 
+
+// marks an empty slot in the hash table
+static const unsigned long long emptyKey = ~0ULL;
+
+SparseMeshEstimatorCollection::SparseMeshEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin):
+  EstimatorCollection(label , attributesin) , numBatches(0) , numKeysWritten(0)
+{
+  // nothing is allocated until it's scored, estimators only holds the ones that have been
+  estimators.clear();
+  keys.assign( 1024 , emptyKey );
+  slots.assign( 1024 , -1 );
+};
+
+int SparseMeshEstimatorCollection::find(unsigned long long key) {
+  // fibonacci hashing into a power of 2 table, then linear probing
+  unsigned long long mask = keys.size() - 1;
+  unsigned long long h    = ( key * 11400714819323198485ULL ) >> 32;
+  while( true ) {
+    h &= mask;
+    if( keys[h] == key      ) { return( slots[h] ); }
+    if( keys[h] == emptyKey ) { return( -1 );       }
+    ++h;
+  }
+};
+
+int SparseMeshEstimatorCollection::allocate(unsigned long long key) {
+  // keep the table at most half full
+  if( 2 * ( entryKeys.size() + 1 ) > keys.size() ) { grow(); }
+
+  // estimators created now have missed the batches so far, give them their (zero) batch means and FOMs
+  int index = estimators.size();
+  for(unsigned int r = 0; r < responses.size(); ++r) {
+    Estimator_ptr estimator = std::make_shared<Estimator>();
+    for(int b = 0; b < numBatches; ++b) {
+      estimator->endBatch(1);
+      estimator->recordFOM(1 , 1.0);
+    }
+    estimators.push_back(estimator);
+  }
+  entryKeys.push_back(key);
+
+  unsigned long long mask = keys.size() - 1;
+  unsigned long long h    = ( key * 11400714819323198485ULL ) >> 32;
+  while( keys[h & mask] != emptyKey ) { ++h; }
+  keys[h & mask]  = key;
+  slots[h & mask] = index;
+  return(index);
+};
+
+void SparseMeshEstimatorCollection::grow() {
+  // double the table and reinsert every allocated key
+  keys.assign( 2 * keys.size() , emptyKey );
+  slots.assign( keys.size() , -1 );
+  unsigned long long mask = keys.size() - 1;
+  for(unsigned int i = 0; i < entryKeys.size(); ++i) {
+    unsigned long long h = ( entryKeys[i] * 11400714819323198485ULL ) >> 32;
+    while( keys[h & mask] != emptyKey ) { ++h; }
+    keys[h & mask]  = entryKeys[i];
+    slots[h & mask] = i * responses.size();
+  }
+};
+
+void SparseMeshEstimatorCollection::scoreCollision(Part_ptr p , const double* xs , int element) {
+  int bin = getLinearIndex(p);
+  if( bin < 0 ) { return; }
+
+  unsigned long long key   = static_cast<unsigned long long>(element) * size + bin;
+  int                index = find(key);
+  if( index < 0 ) { index = allocate(key); }
+
+  // remember the row so only the scored estimators need to end the history
+  bool fresh = true;
+  for(unsigned int r = 0; r < responses.size(); ++r) {
+    fresh = fresh && estimators[ index + r ]->getCurrentHistTally() == 0.0;
+  }
+  if( fresh ) { touched.push_back(index); }
+
+  // collision estimate of the flux, 1 / total, times each response
+  double flux = 1.0 / xs[0];
+  for(unsigned int r = 0; r < responses.size(); ++r) {
+    estimators[ index + r ]->score( responseXS[r] < 0 ? flux : flux * xs[ responseXS[r] ] );
+  }
+};
+
+Estimator_ptr SparseMeshEstimatorCollection::getEstimator(int element , int bin , int response) {
+  int index = find( static_cast<unsigned long long>(element) * size + bin );
+  return( index < 0 ? nullptr : estimators[ index + response ] );
+};
+
+string SparseMeshEstimatorCollection::getBinLabel(int j) {
+  int                n     = responses.size();
+  unsigned long long key   = entryKeys.at(j / n);
+  string             label = "element " + std::to_string( key / size ) + " bin " + std::to_string( key % size );
+  return( n == 1 ? label : label + " " + responses[j % n] );
+};
+
+void SparseMeshEstimatorCollection::setResponses(vector< string > names) {
+  EstimatorCollection::setResponses(names);
+  estimators.clear();
+};
+
+void SparseMeshEstimatorCollection::endHist() {
+  for(int index : touched) {
+    for(unsigned int r = 0; r < responses.size(); ++r) {
+      estimators[ index + r ]->endHist();
+    }
+  }
+  touched.clear();
+};
+
+void SparseMeshEstimatorCollection::endBatch(unsigned long long nBatchHist) {
+  EstimatorCollection::endBatch(nBatchHist);
+  numBatches++;
+};
+
+void SparseMeshEstimatorCollection::writeState(CheckpointWriter &out) {
+  out.writeWord( numBatches );
+  out.writeArray( vector< uint64_t >( entryKeys.begin() , entryKeys.end() ) );
+  EstimatorCollection::writeState(out);
+};
+
+void SparseMeshEstimatorCollection::readState(CheckpointReader &in) {
+  // reallocate the rows with no batches to back fill, the Estimators read theirs
+  estimators.clear();
+  entryKeys.clear();
+  keys.assign( 1024 , emptyKey );
+  slots.assign( 1024 , -1 );
+  numBatches = 0;
+
+  int batches = in.readWord();
+  for(uint64_t key : in.readWords()) {
+    allocate(key);
+  }
+  EstimatorCollection::readState(in);
+  numBatches     = batches;
+  numKeysWritten = entryKeys.size();
+};
+
+void SparseMeshEstimatorCollection::writeBatchSums(CheckpointWriter &out) {
+  // rows in allocation order, so merging allocates the new ones in the same order
+  int                n = responses.size();
+  vector< uint64_t > rows;
+  for(unsigned int i = 0; i < entryKeys.size(); ++i) {
+    bool scored = i >= numKeysWritten;
+    for(int r = 0; r < n && ! scored; ++r) {
+      scored = estimators[ i * n + r ]->scoredThisBatch();
+    }
+    if( scored ) { rows.push_back(i); }
+  }
+  numKeysWritten = entryKeys.size();
+
+  vector< uint64_t > rowKeys;
+  for(uint64_t i : rows) { rowKeys.push_back( entryKeys[i] ); }
+  out.writeArray(rowKeys);
+  for(uint64_t i : rows) {
+    for(int r = 0; r < n; ++r) {
+      estimators[ i * n + r ]->writeBatchSums(out);
+    }
+  }
+};
+
+void SparseMeshEstimatorCollection::addBatchSums(CheckpointReader &in) {
+  // a key new to this shard may have been allocated by an earlier one
+  for(uint64_t key : in.readWords()) {
+    int index = find(key);
+    if( index < 0 ) { index = allocate(key); }
+    for(unsigned int r = 0; r < responses.size(); ++r) {
+      estimators[ index + r ]->addBatchSums(in);
+    }
+  }
+};
+
+uint64_t EstimatorCollection::memoryUsage() {
+  uint64_t total = sizeof(*this) + Memory::bytes( binSizes ) + Memory::bytes( estimators ) + Memory::bytes( responses ) + Memory::bytes( responseXS );
+  for( auto est : estimators ) {
+    total += est->memoryUsage();
+  }
+  return(total);
+}
+
+uint64_t SparseMeshEstimatorCollection::memoryUsage() {
+  return( EstimatorCollection::memoryUsage() + Memory::bytes( keys ) + Memory::bytes( slots ) + Memory::bytes( entryKeys ) + Memory::bytes( touched ) );
+}
@@ -20,6 +20,7 @@
 #include "Particle.h"
 #include "Estimator.h"
 #include "ParticleAttributeBinningStructure.h"
+#include "ResultFile.h"
 
 using std::vector;
 using std::string;
@@ -35,39 +36,85 @@ typedef std::shared_ptr<ParticleAttributeBinningStructure> Bin_ptr;
 
 class EstimatorCollection {
   protected:
+    string                         estimatorName;
+    string                         appliedTo;    // what the collection is attached to, e.g. "cell berpball"
     int                            size;
+    double                         relErrTarget; // stop the run once every bin is below this, 0 for no target
     vector <int>                   binSizes;
     std::map < string , Bin_ptr >  attributes;
-    vector   < Estimator_ptr    >  estimators;
+    vector   < Estimator_ptr    >  estimators;   // laid out [bin][response]
+    vector   < string           >  responses;    // what each Estimator in a row multiplies the score by
+    vector   < int              >  responseXS;   // column of the Material xs row for each response, -1 for flux
     
     void score(Part_ptr , double); 
+    void scoreResponses(Part_ptr , const double* xs); // compute the bin once, score the whole row
+    void scoreRow(int row , const double* xs , double flux);  // flux times each response into row
 
   public:
-    EstimatorCollection(std::map< string , Bin_ptr > attributesin);
+    EstimatorCollection(string label , std::map< string , Bin_ptr > attributesin);
    ~EstimatorCollection() {};
 
-    // find index of estimator to score
+    string                  name()            { return(estimatorName); };
+    string                  getAppliedTo()    { return(appliedTo);     };
+    void                    setAppliedTo(string label) { appliedTo = label; };
+    int                     getSize()         { return(size);          };
+    virtual uint64_t        memoryUsage();    // bytes of the collection and all its Estimators
+    int                     getNumResponses() { return(responses.size()); };
+    vector< string >        getResponses()    { return(responses);     };
+    vector< Estimator_ptr > getEstimators()   { return(estimators);    };
+    double                  getRelErrTarget() { return(relErrTarget);  };
+    void                    setRelErrTarget(double target) { relErrTarget = target; };
+
+    // "flux" or a column of the flattened Material cross sections, reallocates the (unscored) Estimators
+    virtual void            setResponses(vector< string > names);
+
+    // find index of estimator to score, -1 if the particle is outside the binning range
     int  getLinearIndex(Part_ptr p);
 
+    // label of the j'th Estimator in getEstimators(), for output
+    virtual string getBinLabel(int j);
+
     // interface for wrappers of score() for derived EstimatorCollection classes
-    virtual void scoreCollision(Part_ptr , double)     = 0;
+    virtual void scoreCollision(Part_ptr , const double*) = 0; // macroscopic xs row of the material
     virtual void scoreSurfaceCurrent(Part_ptr)         = 0;
     virtual void scoreSurfaceFluence(Part_ptr , point) = 0;
 
-    void endHist();
+    virtual void endHist();
+    virtual void endBatch(unsigned long long nBatchHist);
+    void recordFOM(unsigned long long nHist , double time);
+
+    // every Estimator, for checkpoints at a batch boundary, reading needs the same input as the run that wrote it
+    virtual void writeState(CheckpointWriter &out);
+    virtual void readState(CheckpointReader &in);
+
+    // sums of the batch in progress, a run shard writes them before every endBatch and merging adds them back
+    virtual void writeBatchSums(CheckpointWriter &out);
+    virtual void addBatchSums(CheckpointReader &in);
+
+    // output files of its own beyond the FOM report, e.g. a VTK grid or a reconstructed shape
+    virtual void writeOutput(unsigned long long) {};
+
+    // every bin with its label, mean, standard error and batch means, a tally of the result file
+    TallyResult getResults(unsigned long long nHist);
+
+    // largest relative error and variance of the variance over all scored bins, and whether the error meets the target
+    double getMaxRelativeError(unsigned long long nHist);
+    double getMaxVOV(unsigned long long nHist);
+    bool   isConverged(unsigned long long nHist);
 };
 
 /* ****************************************************************************************************** * 
  * Collision Estimator Collection                                   
- *  Scoring function wrapped by scoreCollision
+ *  Scoring function wrapped by scoreCollision, one row of responses per bin so a single collision
+ *  scores flux and any reaction rates together
  * ****************************************************************************************************** */ 
 
 class CollisionEstimatorCollection: public EstimatorCollection {
   public:
-    CollisionEstimatorCollection(std::map< string , Bin_ptr > attributesin): EstimatorCollection(attributesin) {};
+    CollisionEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin): EstimatorCollection(label , attributesin) {};
    ~CollisionEstimatorCollection() {}; 
 
-    void scoreCollision(Part_ptr p , double xs) { score(p , 1.0 / xs); }; // tally 1 / cross section
+    void scoreCollision(Part_ptr p , const double* xs) { scoreResponses(p , xs); }; // tally response / total cross section
     void scoreSurfaceCurrent(Part_ptr)  {};
     void scoreSurfaceFluence(Part_ptr , point) {};
 };
@@ -79,7 +126,7 @@ class CollisionEstimatorCollection: public EstimatorCollection {
 
 class SurfaceEstimatorCollection: public EstimatorCollection {
   public:
-    SurfaceEstimatorCollection(std::map< string , Bin_ptr > attributesin): EstimatorCollection(attributesin) {}; 
+    SurfaceEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin): EstimatorCollection(label , attributesin) {}; 
    ~SurfaceEstimatorCollection() {};
 };
 
@@ -87,23 +134,77 @@ class SurfaceEstimatorCollection: public EstimatorCollection {
 //const std::string  SurfaceEstimatorCollection::estimatorType = "Collision";
 
 class SurfaceFluenceEstimatorCollection : public SurfaceEstimatorCollection {
+  private:
+    static constexpr double grazingCosine = 0.1;
   public:
-    SurfaceFluenceEstimatorCollection(std::map< string , Bin_ptr > attributesin): SurfaceEstimatorCollection(attributesin) {};
+    SurfaceFluenceEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin): SurfaceEstimatorCollection(label , attributesin) {};
    ~SurfaceFluenceEstimatorCollection() {};
 
-    void scoreCollision(Part_ptr , double) {};
-    void scoreSurfaceCurrent(Part_ptr)     {};
+    void scoreCollision(Part_ptr , const double*) {};
+    void scoreSurfaceCurrent(Part_ptr)            {};
     void scoreSurfaceFluence(Part_ptr p , point surfNormal); // tally 1 /  cos of angle between p direction and surfNormal
 };
 
 class SurfaceCurrentEstimatorCollection : public SurfaceEstimatorCollection {
   public:
-    SurfaceCurrentEstimatorCollection(std::map< string , Bin_ptr > attributesin): SurfaceEstimatorCollection(attributesin) {};
+    SurfaceCurrentEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin): SurfaceEstimatorCollection(label , attributesin) {};
    ~SurfaceCurrentEstimatorCollection() {};
 
-    void scoreCollision(Part_ptr , double)     {};
-    void scoreSurfaceFluence(Part_ptr , point) {};
+    void scoreCollision(Part_ptr , const double*) {};
+    void scoreSurfaceFluence(Part_ptr , point)    {};
     void scoreSurfaceCurrent(Part_ptr p)   { score(p , 1.0); }; // tally 1 particle
 };
 
+/* ****************************************************************************************************** * 
+ * Sparse Mesh Estimator Collection                                   
+ *  A single collision EstimatorCollection covering every element of a mesh. Estimators are keyed by 
+ *  ( element , bin ) in an open addressing hash table and only allocated the first time that key is 
+ *  scored, so memory scales with the number of elements that actually score instead of the mesh size.
+ *  Elements that never score read back as zero, same as an unscored dense Estimator.
+ *  Scoring function wrapped by scoreCollision( p , xs , element )
+ * ****************************************************************************************************** */ 
+
+class SparseMeshEstimatorCollection : public EstimatorCollection {
+  private:
+    vector< unsigned long long > keys;       // hash table of element * size + bin, linear probing
+    vector< int >                slots;      // index into estimators of the row for each occupied key
+    vector< unsigned long long > entryKeys;  // key of each allocated row of responses
+    vector< int >                touched;    // rows scored during the current history
+    int                          numBatches; // completed batches, to back fill estimators allocated late
+    unsigned int                 numKeysWritten; // rows allocated before the batch in progress
+
+    int  find(unsigned long long key);
+    int  allocate(unsigned long long key);
+    void grow();
+
+  public:
+    SparseMeshEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin);
+   ~SparseMeshEstimatorCollection() {};
+
+    // the element isn't known from the particle alone, the mesh passes it in
+    void scoreCollision(Part_ptr , const double*) {};
+    void scoreSurfaceCurrent(Part_ptr)            {};
+    void scoreSurfaceFluence(Part_ptr , point)    {};
+    void scoreCollision(Part_ptr p , const double* xs , int element); // tally response / total cross section in element
+
+    // Estimator for response of bin of element, nullptr if it has never been scored
+    Estimator_ptr getEstimator(int element , int bin , int response = 0);
+    int           getNumAllocated() { return( estimators.size() ); };
+    string        getBinLabel(int j);
+    void          setResponses(vector< string > names);
+
+    void endHist();
+    void endBatch(unsigned long long nBatchHist);
+
+    // the allocated keys come first, in allocation order, so the rows come back in the same order
+    void writeState(CheckpointWriter &out);
+    void readState(CheckpointReader &in);
+
+    // only the rows scored or allocated this batch, by key, another shard may have allocated them in another order
+    void writeBatchSums(CheckpointWriter &out);
+    void addBatchSums(CheckpointReader &in);
+
+    uint64_t memoryUsage();
+};
+
 #endif
@@ -0,0 +1,103 @@
+/*
+ * Transport event counters
+ */
+
+#include "EventCounter.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "TextWriter.h"
+
+EventCounter::EventCounter() : sourceParticles(0) , crossings(0) , whereAmICalls(0) , lostParticles(0) , fissionBanked(0) ,
+  maxBankDepth(0) , whereAmITime(0.0) , histories(0) , transportTime(0.0)
+{
+  std::fill( collisions , collisions + numReactionTypes , 0 );
+};
+
+uint64_t EventCounter::totalCollisions() const {
+  uint64_t total = 0;
+  for( int r = 0; r < numReactionTypes; r++ ) { total += collisions[r]; }
+  return(total);
+};
+
+void EventCounter::add(const EventCounter &other) {
+  sourceParticles += other.sourceParticles;
+  for( int r = 0; r < numReactionTypes; r++ ) { collisions[r] += other.collisions[r]; }
+  crossings       += other.crossings;
+  whereAmICalls   += other.whereAmICalls;
+  lostParticles   += other.lostParticles;
+  fissionBanked   += other.fissionBanked;
+  maxBankDepth     = std::max( maxBankDepth , other.maxBankDepth );
+  whereAmITime    += other.whereAmITime;
+  histories       += other.histories;
+  transportTime    = std::max( transportTime , other.transportTime ); // the processes ran side by side
+};
+
+void EventCounter::write(CheckpointWriter &out) const {
+  out.writeWord( sourceParticles );
+  out.writeArray( vector< uint64_t >( collisions , collisions + numReactionTypes ) );
+  out.writeWord( crossings );
+  out.writeWord( whereAmICalls );
+  out.writeWord( lostParticles );
+  out.writeWord( fissionBanked );
+  out.writeWord( maxBankDepth );
+  out.writeDouble( whereAmITime );
+  out.writeWord( histories );
+  out.writeDouble( transportTime );
+};
+
+void EventCounter::read(CheckpointReader &in) {
+  sourceParticles = in.readWord();
+  vector< uint64_t > byReaction = in.readWords();
+  if( byReaction.size() != numReactionTypes ) {
+    std::cout << " " << in.getFilename() << " counts collisions of " << byReaction.size() << " reactions, expected " << numReactionTypes << std::endl;
+    throw;
+  }
+  std::copy( byReaction.begin() , byReaction.end() , collisions );
+  crossings       = in.readWord();
+  whereAmICalls   = in.readWord();
+  lostParticles   = in.readWord();
+  fissionBanked   = in.readWord();
+  maxBankDepth    = in.readWord();
+  whereAmITime    = in.readDouble();
+  histories       = in.readWord();
+  transportTime   = in.readDouble();
+};
+
+void EventCounter::writeJSON(string filename) const {
+  std::cout << "Writing event counters to " << filename << "..." << std::endl;
+
+  std::ofstream out;
+  out.open( filename );
+
+  // every count as { "total": , "per history": , "per second": }
+  auto rates = [this]( uint64_t count ) {
+    return( "{ \"total\": " + std::to_string( count )
+          + ", \"per_history\": " + Text::shortest( histories > 0 ? static_cast<double>(count) / histories : 0.0 )
+          + ", \"per_second\": "  + Text::shortest( transportTime > 0.0 ? count / transportTime : 0.0 ) + " }" );
+  };
+
+  out << "{" << std::endl;
+  out << "  \"histories\": " << histories << "," << std::endl;
+  out << "  \"transport_seconds\": " << Text::shortest( transportTime ) << "," << std::endl;
+  out << "  \"histories_per_second\": " << Text::shortest( transportTime > 0.0 ? histories / transportTime : 0.0 ) << "," << std::endl;
+  out << "  \"source_particles\": " << rates( sourceParticles ) << "," << std::endl;
+  out << "  \"collisions\": " << rates( totalCollisions() ) << "," << std::endl;
+  out << "  \"collisions_by_reaction\": {" << std::endl;
+  for( int r = 0; r < numReactionTypes; r++ ) {
+    out << "    \"" << reactionTypeName( static_cast< ReactionType >(r) ) << "\": " << rates( collisions[r] )
+        << ( r + 1 < numReactionTypes ? "," : "" ) << std::endl;
+  }
+  out << "  }," << std::endl;
+  out << "  \"surface_crossings\": " << rates( crossings ) << "," << std::endl;
+  out << "  \"where_am_i_calls\": " << rates( whereAmICalls ) << "," << std::endl;
+  out << "  \"where_am_i_seconds\": " << Text::shortest( whereAmITime ) << "," << std::endl;
+  out << "  \"where_am_i_seconds_per_call\": " << Text::shortest( whereAmICalls > 0 ? whereAmITime / whereAmICalls : 0.0 ) << "," << std::endl;
+  out << "  \"lost_particles\": " << rates( lostParticles ) << "," << std::endl;
+  out << "  \"fission_secondaries_banked\": " << rates( fissionBanked ) << "," << std::endl;
+  out << "  \"max_bank_depth\": " << maxBankDepth << std::endl;
+  out << "}" << std::endl;
+  out.close();
+};
@@ -0,0 +1,53 @@
+/*
+ * Transport event counters
+ *
+ * What the transport loop did: source particles, collisions by reaction, surface crossings, whereAmI
+ * calls and their time, particles lost out of the geometry, fission secondaries banked and the deepest
+ * the bank got. Transport bumps plain integers, one counter per process, so counting costs next to
+ * nothing and is never shared between threads. Shards and workers carry theirs in the shard file and
+ * merging adds them up (max for the bank depth, and for the transport time as the processes run side
+ * by side).
+ *
+ * At the end they are written as JSON next to the timing file, as totals, per history and per second of
+ * transport, for spotting regressions and sizing machines.
+ */
+
+#ifndef _EVENTCOUNTER_HEADER_
+#define _EVENTCOUNTER_HEADER_
+
+#include <cstdint>
+#include <string>
+
+#include "Reaction.h"
+#include "Checkpoint.h"
+
+using std::string;
+
+class EventCounter {
+  public:
+    uint64_t sourceParticles;
+    uint64_t collisions[numReactionTypes];  // by ReactionType
+    uint64_t crossings;
+    uint64_t whereAmICalls;
+    uint64_t lostParticles;                 // no cell on the other side of a surface
+    uint64_t fissionBanked;
+    uint64_t maxBankDepth;
+    double   whereAmITime;                  // s, 0 unless built with timing=2
+    uint64_t histories;
+    double   transportTime;                 // s of wall clock, the longest of the processes that ran
+
+    EventCounter();
+   ~EventCounter() {};
+
+    uint64_t totalCollisions() const;
+
+    void add(const EventCounter &other);
+
+    // the counters of a shard, after its batches
+    void write(CheckpointWriter &out) const;
+    void read(CheckpointReader &in);
+
+    void writeJSON(string filename) const;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Functional expansion tallies
+ *
+ * Legendre and Zernike expansions of the flux shape within a cell.
+ */
+
+#include "FunctionalExpansion.h"
+
+/* ****************************************************************************************************** *
+ * Functional Expansion Estimator Collection
+ *
+ * ****************************************************************************************************** */
+
+FunctionalExpansionEstimatorCollection::FunctionalExpansionEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin ,
+                                                                               int orderin , int numCoefficientsin):
+  EstimatorCollection(label , attributesin) , order(orderin) , numCoefficients(numCoefficientsin) , outFilename(label + ".fet")
+{
+  allocate();
+};
+
+void FunctionalExpansionEstimatorCollection::allocate() {
+  // one row of coefficients per bin
+  estimators.clear();
+  for(int i = 0; i < size * numCoefficients; ++i) {
+    estimators.push_back( std::make_shared<Estimator>() );
+  }
+};
+
+void FunctionalExpansionEstimatorCollection::setResponses(vector< string > names) {
+  if( names.size() != 1 || names[0] != "flux" ) {
+    std::cout << " functional expansion estimator " << estimatorName << " can only score the flux response" << std::endl;
+    throw;
+  }
+};
+
+string FunctionalExpansionEstimatorCollection::getBinLabel(int j) {
+  return( std::to_string( j / numCoefficients ) + " " + coefficientLabel( j % numCoefficients ) );
+};
+
+void FunctionalExpansionEstimatorCollection::scoreCollision(Part_ptr p , const double* xs) {
+  int bin = getLinearIndex(p);
+  if( bin < 0 || ! evaluateBasis( p->getPos() ) ) { return; }
+
+  double flux = 1.0 / xs[0];
+  for(int k = 0; k < numCoefficients; ++k) {
+    estimators[ bin * numCoefficients + k ]->score( flux * basis[k] );
+  }
+};
+
+void FunctionalExpansionEstimatorCollection::writeOutput(unsigned long long nHist) {
+  std::cout << "Writing functional expansion tally " << estimatorName << " to " << "outfiles/" << outFilename << "..." << std::endl;
+
+  std::ofstream out;
+  out.open( "outfiles/" + outFilename );
+
+  out << estimatorName << " (" << appliedTo << "), order " << order << ", " << nHist << " histories" << std::endl;
+  for(int bin = 0; bin < size; ++bin) {
+    out << std::endl << "bin " << bin << std::endl;
+    out << "coefficient   mean   R" << std::endl;
+    for(int k = 0; k < numCoefficients; ++k) {
+      Estimator_ptr est = estimators[ bin * numCoefficients + k ];
+      out << coefficientLabel(k) << "   " << est->getScalarEstimator(nHist).first << "   " << est->getRelativeError(nHist) << std::endl;
+    }
+    out << std::endl;
+    writeReconstruction( out , bin , nHist );
+  }
+  out.close();
+};
+
+/* ****************************************************************************************************** *
+ * Legendre Estimator Collection
+ *
+ * ****************************************************************************************************** */
+
+LegendreEstimatorCollection::LegendreEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , int orderin ,
+                                                         char axisin , point centerin , double minin , double maxin):
+  FunctionalExpansionEstimatorCollection(label , attributesin , orderin , orderin + 1) , axis(axisin) , center(centerin) , min(minin) , max(maxin) {};
+
+double LegendreEstimatorCollection::coordinate(point p) {
+  switch( axis ) {
+    case 'x' : return( p.x );
+    case 'y' : return( p.y );
+    case 'z' : return( p.z );
+    default  : return( std::sqrt( ( p - center ) * ( p - center ) ) );
+  }
+};
+
+bool LegendreEstimatorCollection::evaluateBasis(point p) {
+  double u = coordinate(p);
+  if( u < min || u > max ) { return(false); }
+  Utility::legendre( order , 2.0 * ( u - min ) / ( max - min ) - 1.0 , basis );
+  return(true);
+};
+
+double LegendreEstimatorCollection::reconstruct(point p , int bin , unsigned long long nHist) {
+  return( reconstruct( coordinate(p) , bin , nHist ) );
+};
+
+double LegendreEstimatorCollection::reconstruct(double u , int bin , unsigned long long nHist) {
+  if( u < min || u > max ) { return(0.0); }
+
+  // f(u) = sum_k ( 2k + 1 ) / ( max - min ) a_k P_k(xi), from the orthogonality of P_k on [-1 , 1]
+  vector< double > P;
+  Utility::legendre( order , 2.0 * ( u - min ) / ( max - min ) - 1.0 , P );
+  double f = 0.0;
+  for(int k = 0; k < numCoefficients; ++k) {
+    f += ( 2*k + 1 ) / ( max - min ) * estimators[ bin * numCoefficients + k ]->getScalarEstimator(nHist).first * P[k];
+  }
+  return(f);
+};
+
+void LegendreEstimatorCollection::writeReconstruction(std::ofstream &out , int bin , unsigned long long nHist) {
+  out << axis << "   flux per unit " << axis << std::endl;
+  int nPoints = 51;
+  for(int i = 0; i < nPoints; ++i) {
+    double u = min + ( max - min ) * i / ( nPoints - 1 );
+    out << u << "   " << reconstruct( u , bin , nHist ) << std::endl;
+  }
+};
+
+/* ****************************************************************************************************** *
+ * Zernike Estimator Collection
+ *
+ * ****************************************************************************************************** */
+
+ZernikeEstimatorCollection::ZernikeEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , int orderin ,
+                                                       double x0in , double y0in , double radiusin):
+  FunctionalExpansionEstimatorCollection(label , attributesin , orderin , Utility::numZernike(orderin)) , x0(x0in) , y0(y0in) , radius(radiusin) {};
+
+string ZernikeEstimatorCollection::coefficientLabel(int k) {
+  // undo the n then m ordering
+  int n = 0;
+  while( Utility::numZernike(n) <= k ) { n++; }
+  int m = -n + 2 * ( k - Utility::numZernike(n - 1) );
+  return( "Z(" + std::to_string(n) + "," + std::to_string(m) + ")" );
+};
+
+bool ZernikeEstimatorCollection::evaluateBasis(point p) {
+  double u   = ( p.x - x0 ) / radius;
+  double v   = ( p.y - y0 ) / radius;
+  double rho = std::sqrt( u*u + v*v );
+  if( rho > 1.0 ) { return(false); }
+  Utility::zernike( order , rho , std::atan2( v , u ) , basis );
+  return(true);
+};
+
+double ZernikeEstimatorCollection::reconstruct(point p , int bin , unsigned long long nHist) {
+  double u   = ( p.x - x0 ) / radius;
+  double v   = ( p.y - y0 ) / radius;
+  double rho = std::sqrt( u*u + v*v );
+  if( rho > 1.0 ) { return(0.0); }
+
+  // f = sum_nm ( 2n + 2 ) / ( eps_m pi R^2 ) a_nm Z_nm, eps_m = 2 for m = 0 and 1 otherwise
+  vector< double > Z;
+  Utility::zernike( order , rho , std::atan2( v , u ) , Z );
+  double f = 0.0;
+  int    k = 0;
+  for(int n = 0; n <= order; ++n) {
+    for(int m = -n; m <= n; m += 2) {
+      double norm = ( 2.0*n + 2.0 ) / ( ( m == 0 ? 2.0 : 1.0 ) * M_PI * radius * radius );
+      f += norm * estimators[ bin * numCoefficients + k ]->getScalarEstimator(nHist).first * Z[k];
+      k++;
+    }
+  }
+  return(f);
+};
+
+void ZernikeEstimatorCollection::writeReconstruction(std::ofstream &out , int bin , unsigned long long nHist) {
+  out << "x   y   flux per unit area" << std::endl;
+  int nPoints = 21;
+  for(int i = 0; i < nPoints; ++i) {
+    for(int j = 0; j < nPoints; ++j) {
+      double x = x0 + radius * ( 2.0 * i / ( nPoints - 1 ) - 1.0 );
+      double y = y0 + radius * ( 2.0 * j / ( nPoints - 1 ) - 1.0 );
+      if( std::pow( x - x0 , 2 ) + std::pow( y - y0 , 2 ) <= radius * radius ) {
+        out << x << "   " << y << "   " << reconstruct( point( x , y , 0.0 ) , bin , nHist ) << std::endl;
+      }
+    }
+  }
+};
@@ -0,0 +1,102 @@
+/*
+ * Functional expansion tallies
+ *
+ * Instead of binning collisions in space, score the coefficients of an orthogonal polynomial expansion
+ * of the flux shape within a cell: Legendre in one coordinate (x, y, z or the distance r from a center)
+ * or Zernike over a disc in x-y. A collision at u scores P_k(u) / total cross section into coefficient k,
+ * so a few dozen coefficients describe the shape that would otherwise take thousands of bins. The shape
+ * is reconstructed from the coefficients at output time.
+ *
+ * Collisions outside the expansion domain are not scored.
+ */
+
+#ifndef _FUNCTIONALEXPANSION_HEADER_
+#define _FUNCTIONALEXPANSION_HEADER_
+
+#include <cmath>
+#include <fstream>
+
+#include "Point.h"
+#include "Utility.h"
+#include "EstimatorCollection.h"
+
+/* ****************************************************************************************************** *
+ * Functional Expansion Estimator Collection
+ *  one row of numCoefficients Estimators per particle attribute bin, flux response only
+ *  Scoring function wrapped by scoreCollision
+ * ****************************************************************************************************** */
+
+class FunctionalExpansionEstimatorCollection : public EstimatorCollection {
+  protected:
+    int              order;
+    int              numCoefficients;
+    vector< double > basis;       // basis functions at the last collision, reused
+    string           outFilename;
+
+    // fill basis at p, false if p is outside the expansion domain
+    virtual bool   evaluateBasis(point p) = 0;
+    virtual string coefficientLabel(int k) = 0;
+
+    void allocate();
+
+  public:
+    FunctionalExpansionEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , int orderin , int numCoefficientsin);
+   ~FunctionalExpansionEstimatorCollection() {};
+
+    void scoreCollision(Part_ptr p , const double* xs); // tally basis / cross section
+    void scoreSurfaceCurrent(Part_ptr)         {};
+    void scoreSurfaceFluence(Part_ptr , point) {};
+
+    int    getOrder() { return(order); };
+    void   setResponses(vector< string > names);
+    string getBinLabel(int j);
+
+    // flux shape per unit length (Legendre) or area (Zernike) at p from the coefficients of bin
+    virtual double reconstruct(point p , int bin , unsigned long long nHist) = 0;
+
+    // coefficients and the reconstructed shape on a set of sample points
+    void setOutFilename(string filename) { outFilename = filename; };
+    void writeOutput(unsigned long long nHist);
+    virtual void writeReconstruction(std::ofstream &out , int bin , unsigned long long nHist) = 0;
+};
+
+class LegendreEstimatorCollection : public FunctionalExpansionEstimatorCollection {
+  private:
+    char   axis;        // 'x' , 'y' , 'z' or 'r'
+    point  center;      // origin of r
+    double min , max;   // domain of the coordinate, mapped onto [-1 , 1]
+
+    double coordinate(point p);
+
+  protected:
+    bool   evaluateBasis(point p);
+    string coefficientLabel(int k) { return( "P" + std::to_string(k) ); };
+
+  public:
+    LegendreEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , int orderin ,
+                                char axisin , point centerin , double minin , double maxin);
+   ~LegendreEstimatorCollection() {};
+
+    double reconstruct(point p , int bin , unsigned long long nHist);
+    double reconstruct(double u , int bin , unsigned long long nHist); // at coordinate u
+    void   writeReconstruction(std::ofstream &out , int bin , unsigned long long nHist);
+};
+
+class ZernikeEstimatorCollection : public FunctionalExpansionEstimatorCollection {
+  private:
+    double x0 , y0 , radius; // disc in x-y, the expansion ignores z
+
+  protected:
+    bool   evaluateBasis(point p);
+    string coefficientLabel(int k);
+
+  public:
+    ZernikeEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , int orderin ,
+                               double x0in , double y0in , double radiusin);
+   ~ZernikeEstimatorCollection() {};
+
+    double reconstruct(point p , int bin , unsigned long long nHist);
+    void   writeReconstruction(std::ofstream &out , int bin , unsigned long long nHist);
+};
+
+#endif
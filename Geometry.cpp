@@ -4,6 +4,9 @@
 */
 
 #include "Geometry.h"
+#include "Memory.h"
+
+#include <set>
 
 Cell_ptr Geometry::whereAmI( point pos ) 
 { // Returns a pointer to the cell
@@ -178,4 +181,38 @@ void Geometry::readXS( std::string filename , int nGroups, bool loud )
   }
   
   xs_file.close(); //close XS input file
-}
\ No newline at end of file
+}
+
+uint64_t Geometry::memoryUsage()
+{
+  uint64_t total = Memory::shared< Geometry >() + Memory::bytes( cells ) + Memory::bytes( surfaces ) + Memory::bytes( estimators );
+  for( auto cell : cells )
+  {
+    total += cell->memoryUsage();
+  }
+  for( auto surf : surfaces )
+  {
+    total += surf->memoryUsage();
+  }
+  return total;
+}
+
+uint64_t Geometry::materialMemoryUsage()
+{
+  // the cells hold the materials, several cells can share one
+  std::set< Material* > counted;
+  uint64_t total = Memory::bytes( materials );
+  for( auto mat : materials )
+  {
+    counted.insert( mat.get() );
+  }
+  for( auto cell : cells )
+  {
+    if( cell->getMat() ) { counted.insert( cell->getMat().get() ); }
+  }
+  for( Material* mat : counted )
+  {
+    total += mat->memoryUsage();
+  }
+  return total;
+}
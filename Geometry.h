@@ -23,6 +23,7 @@
 #include "Surface.h"
 #include "Estimator.h"
 #include "Source.h"
+#include "StructuredMesh.h"
 
 using std::vector;
 using std::make_shared;
@@ -34,6 +35,8 @@ typedef std::shared_ptr< Estimator > Estimator_ptr;
 typedef std::shared_ptr< Source >    Source_ptr;
 typedef std::shared_ptr< Nuclide >   Nuclide_ptr;
 typedef std::shared_ptr< Reaction >  Reaction_ptr;
+typedef std::shared_ptr< EstimatorCollection > EstCol_ptr;
+typedef std::shared_ptr< StructuredMeshEstimatorCollection > StructEstCol_ptr;
 
 class Geometry
 {
@@ -42,6 +45,8 @@ private:
   std::vector< Surf_ptr >      surfaces;
   std::vector< Mat_ptr >       materials;
   Source_ptr                   source; // do we want to turn this into a vector?
+  std::vector< EstCol_ptr >    estimators; // every EstimatorCollection in the problem (cells, surfaces and tets)
+  std::vector< StructEstCol_ptr > structuredEstimators; // structured mesh tallies, scored by Transport directly
 
 public:
   Geometry() {};
@@ -52,16 +57,24 @@ public:
   void addSurface  ( Surf_ptr   newSurface  ) { surfaces.push_back(newSurface);   };
   void addMaterial ( Mat_ptr    newMaterial ) { materials.push_back(newMaterial); };
   void setSource   ( Source_ptr newSource   ) { source = newSource;               };  
+  void addEstimator( EstCol_ptr newEstimator) { estimators.push_back(newEstimator); };
+  void addStructuredEstimator( StructEstCol_ptr newEstimator ) { structuredEstimators.push_back(newEstimator); };
 
   // Getters
   std::vector< Mat_ptr >  getMaterials() { return materials; };
   std::vector< Cell_ptr > getCells()     { return cells;     };
   std::vector< Surf_ptr > getSurfaces()  { return surfaces;  };
   Source_ptr              getSource()    { return source;    };
+  std::vector< EstCol_ptr > getEstimators() { return estimators; };
+  std::vector< StructEstCol_ptr > getStructuredEstimators() { return structuredEstimators; };
 
   // Functions
   void     readXS   ( std::string filename , int nGroups, bool loud );
   Cell_ptr whereAmI ( point pos );
+
+  // bytes of the cells and surfaces, and of the materials (with their cross sections) in the list or the cells
+  uint64_t memoryUsage();
+  uint64_t materialMemoryUsage();
   Part_ptr sampleSource() { return source->sample(); };	
 };
 
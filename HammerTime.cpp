@@ -1,40 +1,75 @@
+
 #include "HammerTime.h"
 
-void HammerTime::startHist() {
-    startTimer("History");
-}
+#include <cmath>
+#include <iomanip>
+#include <sstream>
 
-void HammerTime::endHist() {
-    endTimer("History");
-}
+const int        HammerTime::timeBinsPerDecade;
+constexpr double HammerTime::minBinTime;
+const int        HammerTime::numTimeBins;
+const int        HammerTime::numSlowest;
 
-void HammerTime::startTimer( string key ) { 
-    currentTimes[key] = clock();
+TimerId HammerTime::getTimerId( string key ) {
+    auto found = ids.find(key);
+    if ( found != ids.end() ) {
+        return(found->second);
+    }
+    TimerId id = names.size();
+    ids[key] = id;
+    names.push_back(key);
+    totals.push_back(0);
+    calls.push_back(0);
+    starts.push_back(0);
+    return(id);
 }
 
 void HammerTime::endTimer( string key ) {
-    // check if key exists in currentTimes, 
-    // which it would if startTimer has been called for this key
-    if ( currentTimes.count(key) == 0) {
+    // check if key exists, which it would if startTimer has been called for this key
+    auto found = ids.find(key);
+    if ( found == ids.end() ) {
         std::cerr << "An endTimer() was called for a process for which the timer was never started! " << std::endl;
-    } 
+    }
     else {
-        // if the key exists, add a result
-        clock_t time = clock() - currentTimes[key];
-        results[key] += ((double)time) / CLOCKS_PER_SEC ; 
-        calls[key]++;
+        end( found->second );
     }
 }
 
-std::map <string , double> HammerTime::getAvgResults() {
-    // check if the average has already been calculated
-    if( ! avgResults.empty() ) {
-        return(avgResults);
+void HammerTime::recordHistory( unsigned long long history , unsigned long long events , uint64_t ns ) {
+    // log scale bins, times below the first bin go in it
+    double decades = std::log10( 1.0e-9 * ns / minBinTime );
+    int    bin     = decades > 0.0 ? static_cast<int>( decades * timeBinsPerDecade ) : 0;
+    timeBins[ std::min( bin , numTimeBins - 1 ) ]++;
+
+    int eventBin = 0;
+    while ( ( events >> ( eventBin + 1 ) ) > 0 ) { eventBin++; }
+    eventBins[eventBin]++;
+
+    // keep the slowest, the fastest of them on top of the heap
+    HistoryCost cost = { ns , history , events };
+    if ( slowest.size() < numSlowest ) {
+        slowest.push_back( cost );
+        std::push_heap( slowest.begin() , slowest.end() , std::greater< HistoryCost >() );
     }
-    else {
-        // take the average of each result vector
-        for (const auto& any : results) {
-            avgResults[any.first] = any.second / calls[any.first];
+    else if ( ns > slowest.front().ns ) {
+        std::pop_heap( slowest.begin() , slowest.end() , std::greater< HistoryCost >() );
+        slowest.back() = cost;
+        std::push_heap( slowest.begin() , slowest.end() , std::greater< HistoryCost >() );
+    }
+}
+
+vector< HistoryCost > HammerTime::getSlowest() {
+    vector< HistoryCost > sorted = slowest;
+    std::sort( sorted.begin() , sorted.end() , std::greater< HistoryCost >() );
+    return(sorted);
+}
+
+std::map <string , double> HammerTime::getAvgResults() {
+    // seconds per call of every timer that has run
+    std::map <string , double> avgResults;
+    for (const auto& any : ids) {
+        if ( calls[any.second] > 0 ) {
+            avgResults[any.first] = 1.0e-9 * totals[any.second] / calls[any.second];
         }
     }
     return(avgResults);
@@ -42,47 +77,66 @@ std::map <string , double> HammerTime::getAvgResults() {
 
 void HammerTime::printAvgResults() {
     std::cout << std::endl << "Printing timing results to " << "outfiles/" << outFilename << "..." << std::endl;
-    
-    // check if the average has already been calculated
-    if(avgResults.empty() ) {
-        // take the average of each result vector
-        for (const auto& any : results) {
-            avgResults[any.first] = any.second / calls[any.first];
-        }
-    }
+
     // print the average results
     std::ofstream timeOut;
     timeOut.open( "outfiles/" + outFilename );
-    timeOut << "Timing results averaged over " <<  calls["Histories"] << " histories:" << std::endl;
-    for (const auto& any : avgResults) {
-        timeOut << any.first << "   " << any.second << "  This block ran " << calls[any.first] << " times." << std::endl;
+    timeOut << "Timing results averaged over " <<  calls[historyId] << " histories:" << std::endl;
+    for (const auto& any : getAvgResults()) {
+        timeOut << any.first << "   " << Text::shortest( any.second ) << "  This block ran " << calls[ ids[any.first] ] << " times." << std::endl;
+    }
+
+    // the histograms from the first to the last bin with anything in it
+    auto printBins = [&timeOut]( const vector< uint64_t > &bins , std::function< string (int) > edge ) {
+        int first = 0 , last = bins.size() - 1;
+        while ( first < last && bins[first] == 0 ) { first++; }
+        while ( last > first && bins[last]  == 0 ) { last--;  }
+        uint64_t total = 0;
+        for ( uint64_t n : bins ) { total += n; }
+
+        uint64_t sum = 0;
+        for ( int b = first; b <= last; b++ ) {
+            sum += bins[b];
+            timeOut << "  " << edge(b) << "   " << edge(b + 1) << "   " << bins[b] << "   " 
+                    << Text::shortest( total > 0 ? static_cast<double>(sum) / total : 0.0 ) << std::endl;
+        }
+    };
+    timeOut << std::endl << "History time distribution (s): from , to , histories , cumulative fraction" << std::endl;
+    printBins( timeBins , []( int b ) { 
+        std::ostringstream edge;
+        edge << std::setprecision(3) << minBinTime * std::pow( 10.0 , static_cast<double>(b) / timeBinsPerDecade );
+        return( edge.str() );
+    } );
+    timeOut << std::endl << "Collisions and surface crossings per history: from , to (exclusive) , histories , cumulative fraction" << std::endl;
+    printBins( eventBins , []( int b ) { return( std::to_string( b == 0 ? 0ULL : 1ULL << b ) ); } );
+
+    timeOut << std::endl << "Slowest histories, rerun one with --replay <history>: history , time (s) , events" << std::endl;
+    for ( const auto &cost : getSlowest() ) {
+        timeOut << "  " << cost.history << "   " << Text::shortest( 1.0e-9 * cost.ns ) << "   " << cost.events << std::endl;
     }
     timeOut.close();
 }
 
 double HammerTime::getAvgResult( string key ) {
-    if(avgResults.empty() ) {
-        // take the average of each result vector
-        for (const auto& any : results) {
-            avgResults[any.first] = any.second / calls[any.first];
-        }
-    }
-    if ( avgResults.count(key) == 0 ) {
+    auto found = ids.find(key);
+    if ( found == ids.end() || calls[found->second] == 0 ) {
         std::cerr << "An was avgResult was called for a non-existent key! " << std::endl;
-    } 
-    else{ 
-        return(avgResults[key]);
+        return(0);
     }
- 
-    return(0);
+    return( 1.0e-9 * totals[found->second] / calls[found->second] );
+}
+
+double HammerTime::getTotalResult( string key ) {
+    auto found = ids.find(key);
+    if ( found == ids.end() ) {
+        return(0);
+    }
+    return( 1.0e-9 * totals[found->second] );
 }
 
 double HammerTime::getAvgHistoryTime() {
-    if(avgResults.empty() ) {
-        // take the average of each result vector
-        for (const auto& any : results) {
-            avgResults[any.first] = any.second / calls[any.first];
-        }
+    if ( calls[historyId] == 0 ) {
+        return(0);
     }
-    return(avgResults["History"]);
+    return( 1.0e-9 * totals[historyId] / calls[historyId] );
 }
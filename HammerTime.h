@@ -12,44 +12,128 @@
 #include <fstream>
 #include <iostream>
 #include <string>
-#include <time.h>       /* clock_t, clock, CLOCKS_PER_SEC */
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
 
 #include "Utility.h"
+#include "TextWriter.h"
 
 using std::string;
 using std::vector;
 
+// how much of transport is timed, set with make timing=N
+//   0  nothing (the FOM report has no times)
+//   1  each history
+//   2  each history and the scoring blocks inside it, on every collision and crossing (default)
+#ifndef HAMMER_TIMING_LEVEL
+#define HAMMER_TIMING_LEVEL 2
+#endif
+
+typedef int TimerId;
+
+// one history's time and the number of collisions and surface crossings in it
+struct HistoryCost {
+    uint64_t           ns;
+    unsigned long long history;
+    unsigned long long events;
+    bool operator > ( const HistoryCost &other ) const { return( ns > other.ns ); };
+};
+
 class HammerTime {
     // this class is for timeing various subroutines in transport
     // Each history, any function can be timed by calling start and end on either side of it
     // At the beginning and end of each history, startHist() and endHist() should be called, so as to calculate average history time
     // There are multiple functions to get or print the results of the timer
+    //
+    // Timers are named once at setup with getTimerId(), after that start and end are an index and a read of
+    // the monotonic clock. The string versions are kept for code that isn't hot.
+    //
+    // Beyond the averages, the time and event count of every history go into log scale histograms and the
+    // slowest histories are kept, so the rare expensive ones can be found and rerun with --replay.
+    public:
+        static const int timeBinsPerDecade = 10;
+        static constexpr double minBinTime = 1.0e-7; // s, lower edge of the first time bin
+        static const int numTimeBins       = 90;     // up to 100 s, longer histories go in the last bin
+        static const int numSlowest        = 20;
+
     private:
-        std::map<string , double  >  results;
-        std::map<string , int     >  calls;
-        std::map<string , clock_t >  currentTimes;
-        std::map<string , double  >  avgResults;
+        vector< string >          names;
+        std::map< string , int >  ids;
+        vector< uint64_t >        totals;  // ns
+        vector< uint64_t >        calls;
+        vector< uint64_t >        starts;  // ns, of the call in progress
+        TimerId                   historyId;
+        vector< uint64_t >        timeBins;    // histories with times in [ minBinTime 10^(b/10) , minBinTime 10^((b+1)/10) )
+        vector< uint64_t >        eventBins;   // histories with [ 2^b , 2^(b+1) ) events, bin 0 also has 0 events
+        vector< HistoryCost >     slowest;     // min heap of the slowest numSlowest histories
         string outFilename;
+
+        void recordHistory( unsigned long long history , unsigned long long events , uint64_t ns );
+
+        static uint64_t now() {
+            return( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+        };
+
     public:
-        HammerTime() {};
+        HammerTime() : timeBins( numTimeBins , 0 ) , eventBins( 64 , 0 ) { historyId = getTimerId( "History" ); };
        ~HammerTime() {};
 
        void setOutFilename( string filename ) { outFilename = filename; };
 
-       void startHist();
-       void endHist();
+       // the id of a named timer, made the first time the name is asked for
+       TimerId getTimerId( string key );
 
-       void startTimer( string key );
+       void start( TimerId id ) { starts[id] = now(); };
+       void end( TimerId id )   { totals[id] += now() - starts[id]; calls[id]++; };
+
+       // events are the collisions and surface crossings of the history
+#if HAMMER_TIMING_LEVEL >= 1
+       void startHist() { start( historyId ); };
+       void endHist( unsigned long long history , unsigned long long events ) {
+           uint64_t ns = now() - starts[historyId];
+           totals[historyId] += ns;
+           calls[historyId]++;
+           recordHistory( history , events , ns );
+       };
+#else
+       void startHist() {};
+       void endHist( unsigned long long , unsigned long long ) {};
+#endif
+
+       void startTimer( string key ) { start( getTimerId( key ) ); };
        void endTimer( string key );
 
-       std::map<string , double> getAvgResults(); 
+       std::map<string , double> getAvgResults();
        void printAvgResults();
 
        double getAvgResult( string key );
+       double getTotalResult( string key ); // summed time over all calls, 0 if never timed
        double getAvgHistoryTime();
-};
 
+       vector< uint64_t >    getTimeBins()  { return( timeBins );  };
+       vector< uint64_t >    getEventBins() { return( eventBins ); };
+       vector< HistoryCost > getSlowest();   // slowest first
+};
 
+// times the rest of the enclosing scope
+class ScopedTimer {
+    private:
+        HammerTime &timer;
+        TimerId     id;
+    public:
+        ScopedTimer( HammerTime &timerin , TimerId idin ) : timer(timerin) , id(idin) { timer.start(id); };
+       ~ScopedTimer() { timer.end(id); };
+};
 
+// time the rest of the scope as one of the blocks inside a history, compiled out below level 2
+#define HAMMER_TIME_CONCAT_( a , b ) a##b
+#define HAMMER_TIME_CONCAT( a , b ) HAMMER_TIME_CONCAT_( a , b )
+#if HAMMER_TIMING_LEVEL >= 2
+#define HAMMER_TIME_EVENT( timer , id ) ScopedTimer HAMMER_TIME_CONCAT( scopedTimer , __LINE__ )( timer , id )
+#else
+#define HAMMER_TIME_EVENT( timer , id ) do {} while(0)
 #endif
 
+#endif
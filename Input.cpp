@@ -5,6 +5,97 @@
 
 #include "Input.h"
 #include <set>
+#include <algorithm>
+
+// structured mesh from the grid attributes of an estimator, grid="xyz" or grid="rzt"
+static std::shared_ptr< StructuredGrid > readStructuredGrid( pugi::xml_node e , std::string name ) {
+  std::string grid = e.attribute("grid").value();
+  if ( grid == "xyz" ) {
+    int nx = e.attribute("nx").as_int( 1 );
+    int ny = e.attribute("ny").as_int( 1 );
+    int nz = e.attribute("nz").as_int( 1 );
+    if ( nx < 1 || ny < 1 || nz < 1 ) {
+      std::cout << " structured mesh for estimator " << name << " needs at least one cell in each direction" << std::endl;
+      throw;
+    }
+    return std::make_shared< CartesianGrid >( e.attribute("xmin").as_double(), e.attribute("xmax").as_double(), nx,
+                                              e.attribute("ymin").as_double(), e.attribute("ymax").as_double(), ny,
+                                              e.attribute("zmin").as_double(), e.attribute("zmax").as_double(), nz );
+  }
+  else if ( grid == "rzt" ) {
+    int nr = e.attribute("nr").as_int( 1 );
+    int nz = e.attribute("nz").as_int( 1 );
+    int nt = e.attribute("ntheta").as_int( 1 );
+    if ( nr < 1 || nz < 1 || nt < 1 ) {
+      std::cout << " structured mesh for estimator " << name << " needs at least one cell in each direction" << std::endl;
+      throw;
+    }
+    return std::make_shared< CylindricalGrid >( e.attribute("x0").as_double(), e.attribute("y0").as_double(), 
+                                                e.attribute("rmax").as_double(), nr,
+                                                e.attribute("zmin").as_double(), e.attribute("zmax").as_double(), nz, nt );
+  }
+  std::cout << " unknown grid " << grid << " for estimator " << name << ", use xyz or rzt" << std::endl;
+  throw;
+}
+
+// collision estimator for a cell, a functional expansion of the flux shape if expansion="legendre" or "zernike"
+// manyCells when it is one of the estimators of all_cells
+static EstCol_ptr makeCellCollisionEstimator( pugi::xml_node e , std::string name , std::string cellName ,
+                                              std::map< std::string , Bin_ptr > attributeMap , bool manyCells ) {
+  std::string expansion = e.attribute("expansion").value();
+  int         order     = e.attribute("order").as_int( 4 );
+  std::string fetFile   = e.attribute("fetfile").as_string( ( name + "_" + cellName + ".fet" ).c_str() );
+
+  // a fetfile given for all_cells would be written by every cell over the one before, so each cell's gets its
+  // name before the extension, flux.fet -> flux_berpball.fet
+  if ( e.attribute("fetfile") && manyCells ) {
+    size_t dot = fetFile.find_last_of('.');
+    if ( dot == std::string::npos || dot < fetFile.find_last_of('/') + 1 ) { dot = fetFile.size(); }
+    fetFile = fetFile.substr( 0 , dot ) + "_" + cellName + fetFile.substr( dot );
+  }
+
+  if ( expansion == "" ) {
+    return std::make_shared<CollisionEstimatorCollection>( name , attributeMap );
+  }
+  if ( order < 0 ) {
+    std::cout << " expansion order must be at least 0 for estimator " << name << std::endl;
+    throw;
+  }
+  if ( expansion == "legendre" ) {
+    // Legendre in x, y, z or the distance r from ( x0 , y0 , z0 ), over [ min , max ]
+    std::string axis = e.attribute("axis").as_string( "z" );
+    double      min  = e.attribute("min").as_double( 0.0 );
+    double      max  = e.attribute("max").as_double( 0.0 );
+    if ( axis != "x" && axis != "y" && axis != "z" && axis != "r" ) {
+      std::cout << " unknown axis " << axis << " for estimator " << name << ", use x, y, z or r" << std::endl;
+      throw;
+    }
+    if ( max <= min ) {
+      std::cout << " expansion domain of estimator " << name << " needs max > min" << std::endl;
+      throw;
+    }
+    point center( e.attribute("x0").as_double(), e.attribute("y0").as_double(), e.attribute("z0").as_double() );
+    std::shared_ptr< LegendreEstimatorCollection > est = 
+      std::make_shared<LegendreEstimatorCollection>( name , attributeMap , order , axis[0] , center , min , max );
+    est->setOutFilename( fetFile );
+    return est;
+  }
+  else if ( expansion == "zernike" ) {
+    // Zernike on the disc of radius about ( x0 , y0 ) in x-y
+    double radius = e.attribute("radius").as_double( 0.0 );
+    if ( radius <= 0.0 ) {
+      std::cout << " zernike expansion of estimator " << name << " needs a positive radius" << std::endl;
+      throw;
+    }
+    std::shared_ptr< ZernikeEstimatorCollection > est = 
+      std::make_shared<ZernikeEstimatorCollection>( name , attributeMap , order , e.attribute("x0").as_double(), 
+                                                    e.attribute("y0").as_double(), radius );
+    est->setOutFilename( fetFile );
+    return est;
+  }
+  std::cout << " unknown expansion " << expansion << " for estimator " << name << ", use legendre or zernike" << std::endl;
+  throw;
+}
 
 void Input::readInput( std::string xmlFilename ) {
 
@@ -16,24 +107,74 @@ void Input::readInput( std::string xmlFilename ) {
     throw;
   }
 
+  // attributes set on the command line win over the file, e.g. setup.nhistories=1000
+  for ( auto setting : overrides ) {
+    size_t dot = setting.find('.');
+    size_t eq  = setting.find('=');
+    if ( dot == std::string::npos || eq == std::string::npos || eq < dot ) {
+      std::cout << " setting " << setting << " isn't of the form element.attribute=value" << std::endl;
+      throw;
+    }
+    std::string element   = setting.substr( 0 , dot );
+    std::string attribute = setting.substr( dot + 1 , eq - dot - 1 );
+    pugi::xml_node node   = input_file.child( element.c_str() );
+    if ( ! node ) {
+      std::cout << " no element " << element << " in the input to set " << attribute << " of" << std::endl;
+      throw;
+    }
+    pugi::xml_attribute attr = node.attribute( attribute.c_str() );
+    if ( ! attr ) { attr = node.append_attribute( attribute.c_str() ); }
+    attr.set_value( setting.substr( eq + 1 ).c_str() );
+  }
+
   // get setup parameters
   pugi::xml_node input_setup = input_file.child("setup");
   xsFilename   = input_setup.attribute("xsfile").value();
   meshFilename = input_setup.attribute("meshfile").value();
   nGroups      = input_setup.attribute("ngroups").as_int();
   nHist        = input_setup.attribute("nhistories").as_int();
+  nBatches     = input_setup.attribute("nbatches").as_int( 10 );
+  wallTime     = input_setup.attribute("walltime").as_double( 0.0 );
   loud         = input_setup.attribute("loud").as_bool();
 
+  if ( nBatches < 1 ) {
+    std::cout << " nbatches must be at least 1" << std::endl;
+    throw;
+  }
+  // can't have more batches than histories
+  if ( nBatches > nHist ) { nBatches = nHist > 0 ? nHist : 1; }
+
   // get outfile parameters
   pugi::xml_node input_outfiles = input_file.child("outfiles");
   outFilename  = input_outfiles.attribute("outfile").value();
   vtkFilename  = input_outfiles.attribute("vtkfile").value();
   timeFilename = input_outfiles.attribute("timefile").value();
+  fomFilename  = input_outfiles.attribute("fomfile").as_string( "fom.out" );
+  resultFilename = input_outfiles.attribute("resultfile").as_string( "results.bin" );
+  // event counters go next to the timing file, time.out -> time_counters.json
+  counterFilename = input_outfiles.attribute("counterfile").as_string(
+                      ( timeFilename.substr( 0 , timeFilename.find_last_of('.') ) + "_counters.json" ).c_str() );
+  snapshotEvery  = input_outfiles.attribute("snapshotevery").as_int( 0 );
+  checkpointFilename = input_outfiles.attribute("checkpoint").as_string( "checkpoint.bin" );
+  checkpointEvery    = input_outfiles.attribute("checkpointevery").as_int( 0 );
+  profile            = input_outfiles.attribute("profile").as_bool( false );
+  traceFilename      = input_outfiles.attribute("tracefile").as_string( "" );
+  progressEvery      = input_outfiles.attribute("progressevery").as_double( 10.0 );
+  std::istringstream progressStream( input_outfiles.attribute("progresstallies").as_string( "" ) );
+  for ( std::string t; progressStream >> t; ) {
+    progressTallies.push_back( t );
+  }
+
+  // appended binary VTK arrays unless ascii is asked for, for debugging
+  VTK::setEncoding( input_outfiles.attribute("vtkencoding").as_string( "raw" ),
+                    input_outfiles.attribute("vtkcompressor").as_string( "zlib" ) );
 
   // set and lock constants
   constants = std::make_shared< Constants > ();
   constants->setNumGroups( nGroups );
   constants->setNumHis( nHist );
+  constants->setNumBatches( nBatches );
+  constants->setWallTimeLimit( wallTime );
 
   // initialize geometry and mesh objects
   geometry = std::make_shared< Geometry >   ();
@@ -282,6 +423,9 @@ void Input::readInput( std::string xmlFilename ) {
         Mat->addNuclide( findByName( nuclides, nuclideName ), frac );
       }
     }
+
+    // tabulate the macroscopic cross sections used in transport and tallies
+    Mat->flattenXS( nGroups );
   }
 
   // iterate over surfaces
@@ -393,6 +537,14 @@ void Input::readInput( std::string xmlFilename ) {
     std::string name      = e.attribute("name").value();
     std::string apply     = e.attribute("apply").value();
     std::string applyName = e.attribute("applyName").value();
+    double      relTol    = e.attribute("reltol").as_double( 0.0 ); // relative error target for stopping the run
+
+    // responses every bin scores from one event, e.g. responses="flux Capture Fission", default just the flux
+    std::vector< std::string > responses;
+    std::istringstream responseStream( e.attribute("responses").as_string("flux") );
+    for ( std::string r; responseStream >> r; ) {
+      responses.push_back( r );
+    }
     
   
     // TODO parse particle attribute binning
@@ -423,7 +575,11 @@ void Input::readInput( std::string xmlFilename ) {
           for ( auto cel : geometry->getCells() ) {
             // make a CollisionEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<CollisionEstimatorCollection>( attributeMap );
+            EstCol_ptr est = makeCellCollisionEstimator( e , name , cel->name() , attributeMap , true );
+            est->setRelErrTarget( relTol );
+            est->setResponses( responses );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "cell " + cel->name() );
             cel->addEstimator(est);
           }
         }
@@ -433,7 +589,11 @@ void Input::readInput( std::string xmlFilename ) {
           if ( cel ) {
             // make a CollisionEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<CollisionEstimatorCollection>( attributeMap );
+            EstCol_ptr est = makeCellCollisionEstimator( e , name , cel->name() , attributeMap , false );
+            est->setRelErrTarget( relTol );
+            est->setResponses( responses );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "cell " + cel->name() );
             cel->addEstimator(est);
           }
           else {
@@ -443,26 +603,56 @@ void Input::readInput( std::string xmlFilename ) {
         }
       }
       else if ( apply == "tet" ) {
+        // storage="sparse" only allocates the ( tet , bin ) pairs that score, for large mostly empty meshes
+        std::string storage = e.attribute("storage").as_string("dense");
+
         // special case "all_tets"
         if ( applyName == "all_tets" ) {
           constants->setAllTets();
           if (constants->getAllTets()) {
             std::cout << "Success!" << std::endl;
           }
-          for ( auto t : mesh->getTets() ) {
-            // make a CollisionEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
-            // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<CollisionEstimatorCollection>( attributeMap );
-            t->addEstimator(est);
+          if ( storage == "sparse" ) {
+            // a single collection for the whole mesh, keyed by tet id
+            std::shared_ptr< SparseMeshEstimatorCollection > est = std::make_shared<SparseMeshEstimatorCollection>( name , attributeMap );
+            est->setRelErrTarget( relTol );
+            est->setResponses( responses );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "mesh " + meshFilename );
+            mesh->addEstimator(est);
+          }
+          else if ( storage != "dense" ) {
+            std::cout << " unknown storage " << storage << " for estimator " << name << std::endl;
+            throw;
+          }
+          else {
+            for ( auto t : mesh->getTets() ) {
+              // make a CollisionEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
+              // use the attributeMap for this estimator as the constructor
+              EstCol_ptr est = std::make_shared<CollisionEstimatorCollection>( name , attributeMap );
+              est->setRelErrTarget( relTol );
+              est->setResponses( responses );
+              geometry->addEstimator(est);
+              est->setAppliedTo( "tet " + t->name() );
+              t->addEstimator(est);
+            }
           }
         }
         else {
+          if ( storage != "dense" ) {
+            std::cout << " storage " << storage << " is only available for all_tets, estimator " << name << std::endl;
+            throw;
+          }
           std::shared_ptr< Tet > tet = findByName( mesh->getTets(), applyName );
 
           if ( tet ) {
             // make a CollisionEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<CollisionEstimatorCollection>( attributeMap );
+            EstCol_ptr est = std::make_shared<CollisionEstimatorCollection>( name , attributeMap );
+            est->setRelErrTarget( relTol );
+            est->setResponses( responses );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "tet " + tet->name() );
             tet->addEstimator(est);
           }
           else {
@@ -471,11 +661,42 @@ void Input::readInput( std::string xmlFilename ) {
           }
         }
       }
+      else if ( apply == "mesh" ) {
+        // structured mesh laid over the problem, binned arithmetically
+        StructEstCol_ptr est = std::make_shared<StructuredMeshCollisionEstimatorCollection>( name , attributeMap , readStructuredGrid( e , name ) );
+        est->setRelErrTarget( relTol );
+        est->setResponses( responses );
+        est->setVTKFilename( e.attribute("vtkfile").as_string( (name + ".vtu").c_str() ) );
+        geometry->addEstimator(est);
+        geometry->addStructuredEstimator(est);
+        est->setAppliedTo( "mesh " + std::string( e.attribute("grid").value() ) );
+      }
+      else {
+        std::cout << " unknown apply type with name " << apply << " for estimator " << name << std::endl;
+        throw;
+      }
+    }
+    else if ( type == "TrackLengthTally" ) {
+      if ( apply == "mesh" ) {
+        // structured mesh laid over the problem, every flight is split into its grid cells
+        StructEstCol_ptr est = std::make_shared<StructuredMeshTrackLengthEstimatorCollection>( name , attributeMap , readStructuredGrid( e , name ) );
+        est->setRelErrTarget( relTol );
+        est->setResponses( responses );
+        est->setVTKFilename( e.attribute("vtkfile").as_string( (name + ".vtu").c_str() ) );
+        geometry->addEstimator(est);
+        geometry->addStructuredEstimator(est);
+        est->setAppliedTo( "mesh " + std::string( e.attribute("grid").value() ) );
+      }
       else {
         std::cout << " unknown apply type with name " << apply << " for estimator " << name << std::endl;
         throw;
       }
     }
+    else if ( ( type == "SurfaceFluenceTally" || type == "SurfaceCurrentTally" ) && 
+              ( responses.size() != 1 || responses[0] != "flux" ) ) {
+      std::cout << " surface estimator " << name << " can only score the flux response" << std::endl;
+      throw;
+    }
     else if ( type == "SurfaceFluenceTally" ) {
       // make sure all attributes in the attribute map are consistent with a SurfaceTally
       // by creating a dummy surface tally and doing an attribute check
@@ -488,7 +709,10 @@ void Input::readInput( std::string xmlFilename ) {
           for ( auto surf : geometry->getSurfaces() ) {
             // make a SurfaceEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<SurfaceFluenceEstimatorCollection>( attributeMap );
+            EstCol_ptr est = std::make_shared<SurfaceFluenceEstimatorCollection>( name , attributeMap );
+            est->setRelErrTarget( relTol );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "surface " + surf->name() );
             surf->addEstimator(est);
           }
         }
@@ -498,7 +722,10 @@ void Input::readInput( std::string xmlFilename ) {
           if ( surf ) {
             // make a SurfaceEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<SurfaceFluenceEstimatorCollection>( attributeMap );
+            EstCol_ptr est = std::make_shared<SurfaceFluenceEstimatorCollection>( name , attributeMap );
+            est->setRelErrTarget( relTol );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "surface " + surf->name() );
             surf->addEstimator(est);
           }
           else {
@@ -524,7 +751,10 @@ void Input::readInput( std::string xmlFilename ) {
           for ( auto surf : geometry->getSurfaces() ) {
             // make a SurfaceEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<SurfaceCurrentEstimatorCollection>( attributeMap );
+            EstCol_ptr est = std::make_shared<SurfaceCurrentEstimatorCollection>( name , attributeMap );
+            est->setRelErrTarget( relTol );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "surface " + surf->name() );
             surf->addEstimator(est);
           }
         }
@@ -534,7 +764,10 @@ void Input::readInput( std::string xmlFilename ) {
           if ( surf ) {
             // make a SurfaceEstimatorCollection shared ptr and cast it as an EstimatorCollection shared ptr 
             // use the attributeMap for this estimator as the constructor
-            EstCol_ptr est = std::make_shared<SurfaceCurrentEstimatorCollection>( attributeMap );
+            EstCol_ptr est = std::make_shared<SurfaceCurrentEstimatorCollection>( name , attributeMap );
+            est->setRelErrTarget( relTol );
+            geometry->addEstimator(est);
+            est->setAppliedTo( "surface " + surf->name() );
             surf->addEstimator(est);
           }
           else {
@@ -713,6 +946,15 @@ void Input::readInput( std::string xmlFilename ) {
     }
     geometry->setSource( sourc );
   }
+
+  // progress reports the tallies with relative error targets unless told which
+  if ( progressTallies.empty() ) {
+    for ( auto est : geometry->getEstimators() ) {
+      if ( est->getRelErrTarget() > 0.0 && std::find( progressTallies.begin(), progressTallies.end(), est->name() ) == progressTallies.end() ) {
+        progressTallies.push_back( est->name() );
+      }
+    }
+  }
   constants->lock(); // Please don't move this
 }
 
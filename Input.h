@@ -27,6 +27,7 @@
 #include "HammerTime.h"
 #include "ParticleAttributeBinningStructure.h"
 #include "EstimatorCollection.h"
+#include "FunctionalExpansion.h"
 
 typedef std::shared_ptr<EstimatorCollection> EstCol_ptr;
 
@@ -42,18 +43,42 @@ class Input
     std::string                   outFilename;
     std::string                   vtkFilename;
     std::string                   timeFilename;
+    std::string                   fomFilename;
+    std::string                   resultFilename;
+    std::string                   counterFilename;
+    bool                          profile;
+    std::string                   traceFilename;
+    double                        progressEvery;
+    std::vector< std::string >    progressTallies;
+    int                           snapshotEvery;
+    std::string                   checkpointFilename;
+    int                           checkpointEvery;
     bool                          loud;
     int                           nHist;
+    int                           nBatches;
+    double                        wallTime;
     int                           nGroups;
+    std::vector< std::string >    overrides; // element.attribute=value
 
   public:
     Input() {};
    ~Input() {};    
     void readInput( std::string xmlFilename );    
+    void setOverride( std::string setting ) { overrides.push_back( setting ); }; // before readInput
     std::shared_ptr< Geometry >   getGeometry()  { return geometry;  };
     std::shared_ptr< Mesh >       getMesh()      { return mesh;      };
     std::shared_ptr< Constants >  getConstants() { return constants; };
     std::shared_ptr< HammerTime > getTimer()     { return timer;     };
+    std::string                   getFOMFilename() { return fomFilename; };
+    std::string                   getResultFilename() { return resultFilename; };
+    std::string                   getCounterFilename() { return counterFilename; };
+    bool                          getProfile() { return profile; };
+    std::string                   getTraceFilename() { return traceFilename; };
+    double                        getProgressInterval() { return progressEvery; };
+    std::vector< std::string >    getProgressTallies() { return progressTallies; };
+    int                           getSnapshotInterval() { return snapshotEvery; };
+    std::string                   getCheckpointFilename() { return checkpointFilename; };
+    int                           getCheckpointInterval() { return checkpointEvery; };
 };
 
 template< typename T >
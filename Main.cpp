@@ -2,29 +2,231 @@
 #include "Logo.h"
 #include "Input.h"
 #include <memory>
+#include <cstdio>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
 #include "HammerTime.h"
+#include "Trace.h"
+#include "Memory.h"
+#include "Progress.h"
+#include "TextWriter.h"
 
 typedef std::shared_ptr<Transport>   T_ptr;
 typedef std::shared_ptr<Mesh>        Mesh_ptr;
 typedef std::shared_ptr<HammerTime>  Time_ptr;
 
+// fork numWorkers copies of the loaded problem, each runs a shard of whole batches and writes its batch sums to
+// shared memory (a file in /dev/shm), then the parent merges them in batch order, same result as one process
+static void runWorkers( T_ptr t , std::shared_ptr< Constants > constants , int numWorkers , std::shared_ptr< Progress > progress )
+{
+    unsigned long long maxHis     = constants->getNumHis();
+    int                numBatches = constants->getNumBatches();
+    numWorkers = std::min( numWorkers , numBatches );
+
+    std::string dir = access( "/dev/shm" , W_OK ) == 0 ? "/dev/shm/" : "outfiles/";
+    std::vector< std::string > filenames;
+    std::vector< pid_t >       workers;
+
+    // nothing buffered may be printed twice
+    cout.flush();
+    fflush( stdout );
+    for ( int w = 0; w < numWorkers; w++ ) 
+    {
+        int firstBatch = numBatches * w / numWorkers;
+        int lastBatch  = numBatches * ( w + 1 ) / numWorkers;
+        filenames.push_back( dir + "hammer_" + std::to_string( getpid() ) + "_" + std::to_string( w ) + ".bin" );
+
+        pid_t pid = fork();
+        if ( pid < 0 ) 
+        {
+            std::cout << " could not fork worker " << w << std::endl;
+            throw;
+        }
+        if ( pid == 0 ) 
+        {
+            // the geometry, mesh and cross sections are shared copy on write, only the tallies get written to
+            Trace::clear();
+            Trace::nameProcess( "worker " + std::to_string( w ) );
+            if ( progress ) 
+            {
+                t->setProgress( progress , w );
+            }
+            t->setShard( maxHis * firstBatch / numBatches , maxHis * lastBatch / numBatches , filenames[w] );
+            t->runTransport();
+            if ( Trace::enabled() ) 
+            {
+                Trace::writeFragment( filenames[w] + ".trace" );
+            }
+            cout.flush();
+            _exit( 0 );
+        }
+        workers.push_back( pid );
+    }
+
+    // the parent reports on all the workers, its thread is only started once they're forked
+    if ( progress ) 
+    {
+        progress->start();
+    }
+
+    bool failed = false;
+    {
+        TraceScope trace( "wait for workers" );
+        for ( pid_t pid : workers ) 
+        {
+            int status;
+            waitpid( pid , &status , 0 );
+            failed = failed || ! WIFEXITED( status ) || WEXITSTATUS( status ) != 0;
+        }
+    }
+    if ( progress ) 
+    {
+        progress->stop();
+    }
+    if ( Trace::enabled() ) 
+    {
+        for ( auto filename : filenames ) { Trace::readFragment( filename + ".trace" ); }
+    }
+    if ( failed ) 
+    {
+        for ( auto filename : filenames ) { std::remove( filename.c_str() ); }
+        std::cout << " a worker failed, no tallies were merged" << std::endl;
+        throw;
+    }
+
+    t->mergeShards( filenames );
+    for ( auto filename : filenames ) { std::remove( filename.c_str() ); }
+}
+
+// seconds of each phase of the run and the peak memory, for the benchmark driver
+static void writeSummary( std::string filename , T_ptr t , int numWorkers , double setupTime , double transportTime , double outputTime )
+{
+    struct rusage children;
+    getrusage( RUSAGE_CHILDREN , &children );
+
+    std::ofstream out( filename );
+    out << "{" << std::endl;
+    out << "  \"histories\": " << t->getNumHis() << "," << std::endl;
+    out << "  \"workers\": " << numWorkers << "," << std::endl;
+    out << "  \"setup_seconds\": " << Text::shortest( setupTime ) << "," << std::endl;
+    out << "  \"transport_seconds\": " << Text::shortest( transportTime ) << "," << std::endl;
+    out << "  \"output_seconds\": " << Text::shortest( outputTime ) << "," << std::endl;
+    out << "  \"histories_per_second\": " << Text::shortest( transportTime > 0.0 ? t->getNumHis() / transportTime : 0.0 ) << "," << std::endl;
+    out << "  \"peak_resident_bytes\": " << Memory::peakResidentSize() << "," << std::endl;
+    out << "  \"peak_worker_resident_bytes\": " << 1024 * static_cast< uint64_t >( children.ru_maxrss ) << std::endl;
+    out << "}" << std::endl;
+}
+
+static void printUsage()
+{
+    std::cout << " usage: a.out xmlFilename [--restart | --shard a b | --merge shardFiles... | --workers N | --replay i]"
+              << " [--set element.attribute=value ...] [--summary file]" << std::endl;
+}
+
+static double secondsSince( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+}
+
 int main(int argc , char *argv[]) 
-//INPUT: xmlFilename
+//INPUT: xmlFilename [--restart | --shard a b | --merge shardFiles... | --workers N | --replay i] [--set element.attribute=value ...] [--summary file]
 //xmlFilename: the xml-formatted input file containing the problem parameters
+//--restart:   carry on from the checkpoint in outfiles/ instead of starting over
+//--shard:     only run histories [a, b), on batch boundaries, and write their tallies to outfiles/shard_a_b.bin
+//--merge:     no transport, the output of the full run from the shard files of all its histories
+//--workers:   run the batches in N forked processes and merge their tallies
+//--replay:    only rerun history i, printing each of its events, e.g. one of the slowest in the timing file
+//--set:       override an attribute of the input, e.g. --set setup.nhistories=1000 --set setup.meshfile=coarse.thrm
+//--summary:   write the setup, transport and output seconds, histories per second and peak memory to a JSON file
 //TODO:
 
 {
     std::string xmlFilename = "inputfiles/";
+    bool        restart     = false;
+    bool        shard       = false;
+    unsigned long long shardStart = 0 , shardEnd = 0;
+    std::vector< std::string > mergeFilenames;
+    bool        replay      = false;
+    unsigned long long replayHistory = 0;
+    int         numWorkers  = 1;
+    std::vector< std::string > settings;
+    std::string summaryFilename;
+    auto        runStart    = std::chrono::steady_clock::now();
 
-    if ( argc > 1 ) 
+    for ( int a = 1; a < argc; a++ ) 
+    {
+        std::string arg = argv[a];
+        if ( arg == "--restart" ) 
+        {
+            restart = true;
+        }
+        else if ( arg == "--shard" && a + 2 < argc ) 
+        {
+            shard      = true;
+            shardStart = std::stoull( argv[a + 1] );
+            shardEnd   = std::stoull( argv[a + 2] );
+            a += 2;
+        }
+        else if ( arg == "--workers" && a + 1 < argc ) 
+        {
+            numWorkers = std::stoi( argv[a + 1] );
+            a += 1;
+        }
+        else if ( arg == "--replay" && a + 1 < argc ) 
+        {
+            replay        = true;
+            replayHistory = std::stoull( argv[a + 1] );
+            a += 1;
+        }
+        else if ( arg == "--set" && a + 1 < argc ) 
+        {
+            settings.push_back( argv[a + 1] );
+            a += 1;
+        }
+        else if ( arg == "--summary" && a + 1 < argc ) 
+        {
+            summaryFilename = argv[a + 1];
+            a += 1;
+        }
+        else if ( arg == "--merge" ) 
+        {
+            mergeFilenames.assign( argv + a + 1 , argv + argc );
+            break;
+        }
+        else if ( arg.compare( 0 , 2 , "--" ) == 0 || xmlFilename != "inputfiles/" ) 
+        {
+            // an unknown option, one missing its values or a second input file
+            std::cout << " unexpected argument " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else 
+        {
+            xmlFilename += arg;
+        }
+    }
+    if ( xmlFilename == "inputfiles/" ) 
+    {
+        printUsage();
+        return 1;
+    }
+    if ( (int) restart + (int) shard + (int) ! mergeFilenames.empty() + (int) ( numWorkers > 1 ) + (int) replay > 1 ) 
     {
-        xmlFilename += argv[1];
+        std::cout << " --restart, --shard, --merge, --workers and --replay can't be used together" << std::endl;
+        return 1;
     }
 
     printLogo();
 
     // Initialize and read xml input
     std::shared_ptr< Input > input = std::make_shared< Input > ();
+    for ( auto setting : settings ) 
+    {
+        input->setOverride( setting );
+    }
     input->readInput( xmlFilename );
 
     // Create pointers to geometry, constants, and mesh
@@ -33,15 +235,112 @@ int main(int argc , char *argv[])
     std::shared_ptr< Mesh >       mesh      = input->getMesh();
     std::shared_ptr< HammerTime > timer     = input->getTimer();
 
+    // a shard runs all of its histories and only has part of the tallies, it can't stop on time or write the
+    // checkpoints and snapshots of the whole run
+    if ( ( shard || numWorkers > 1 ) && 
+         ( constants->getWallTimeLimit() > 0.0 || input->getCheckpointInterval() > 0 || input->getSnapshotInterval() > 0 ) ) 
+    {
+        std::cout << " walltime, checkpointevery and snapshotevery can't be used with --shard or --workers" << std::endl;
+        return 1;
+    }
+
+    // a timeline of the run's phases, if asked for
+    if ( ! input->getTraceFilename().empty() ) 
+    {
+        Trace::enable();
+        Trace::nameProcess( "hammer" );
+        Trace::nameThread( "transport" );
+    }
+
     T_ptr t = std::make_shared<Transport>( geometry, constants, mesh, timer );
+    t->setFOMFilename( input->getFOMFilename() );
+    t->setResultFilename( input->getResultFilename() );
+    t->setCounterFilename( input->getCounterFilename() );
+    t->setProfile( input->getProfile() );
+    t->setSnapshotInterval( input->getSnapshotInterval() );
+    t->setCheckpoint( input->getCheckpointFilename() , input->getCheckpointInterval() );
+    t->setRestart( restart );
+    if ( shard ) 
+    {
+        t->setShard( shardStart , shardEnd );
+    }
+
+    t->accountMemory();
+    Memory::print( "after setup" );
+
+    double setupTime = secondsSince( runStart );
+    auto   transportStart = std::chrono::steady_clock::now();
+
+    // a line every progressevery seconds while transport runs, with a slot per worker
+    std::shared_ptr< Progress > progress;
+    if ( input->getProgressInterval() > 0.0 && ! replay && mergeFilenames.empty() ) 
+    {
+        progress = std::make_shared< Progress >( input->getProgressTallies() , input->getProgressInterval() , numWorkers );
+    }
 
-    cout << "running transport..." << endl;
-    t->runTransport();
+    // one history's events, no tallies are written
+    if ( replay ) 
+    {
+        cout << "replaying history " << replayHistory << "..." << endl;
+        t->replayHistory( replayHistory );
+        return 0;
+    }
+
+    if ( ! mergeFilenames.empty() ) 
+    {
+        cout << "merging shards..." << endl;
+        t->mergeShards( mergeFilenames );
+    }
+    else if ( numWorkers > 1 ) 
+    {
+        cout << "running transport in " << numWorkers << " worker processes..." << endl;
+        runWorkers( t , constants , numWorkers , progress );
+    }
+    else 
+    {
+        cout << "running transport..." << endl;
+        if ( progress ) 
+        {
+            t->setProgress( progress );
+            progress->start();
+        }
+        t->runTransport();
+        if ( progress ) 
+        {
+            progress->stop();
+        }
+    }
+
+    double transportTime = secondsSince( transportStart );
+
+    // a shard's tallies only mean something once merged
+    if ( shard ) 
+    {
+        t->accountMemory();
+        Memory::print( "at the end" );
+        if ( Trace::enabled() ) 
+        {
+            Trace::write( "outfiles/" + input->getTraceFilename() );
+        }
+        return 0;
+    }
     cout << std::endl << "Transport finished!" << std::endl;
     cout << std::endl << "************************************************************************" << std::endl;
     cout << "************************************************************************" << std::endl;
     cout << "Printing outputs..." << endl;
+    auto outputStart = std::chrono::steady_clock::now();
     t->output();
+    double outputTime = secondsSince( outputStart );
+    t->accountMemory();
+    Memory::print( "at the end" );
+    if ( ! summaryFilename.empty() ) 
+    {
+        writeSummary( summaryFilename , t , numWorkers , setupTime , transportTime , outputTime );
+    }
+    if ( Trace::enabled() ) 
+    {
+        Trace::write( "outfiles/" + input->getTraceFilename() );
+    }
 
     return 0;
 }
\ No newline at end of file
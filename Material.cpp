@@ -5,6 +5,7 @@
 */
 
 #include "Material.h"
+#include "Memory.h"
 
 void Material::addNuclide( Nuclide_ptr newNuclide, double atomFrac )
 {
@@ -25,9 +26,44 @@ double Material::getMicroXS( Part_ptr p )
 
 double Material::getMacroXS( Part_ptr p ) 
 {
+  if ( ! xsTable.empty() ) { return getMacroXSRow( p )[0]; }
   return getAtomDensity() * getMicroXS( p );
 }
 
+const std::vector< std::string > Material::xsNames = { "total", "Capture", "Scatter", "Fission" };
+
+int Material::getXSIndex( std::string name )
+{
+  for ( unsigned int i = 0; i < xsNames.size(); i++ )
+  {
+    if ( xsNames[i] == name ) { return i; }
+  }
+  return -1;
+}
+
+void Material::flattenXS( int nGroups )
+{
+  xsTable.clear();
+  xsTable.reserve( nGroups * xsNames.size() );
+
+  for ( int g = 1; g <= nGroups; g++ )
+  {
+    Part_ptr p = std::make_shared< Particle >( point( 0.0, 0.0, 0.0 ), point( 0.0, 0.0, 1.0 ), g );
+
+    // total is summed the same way as getMacroXS so transport doesn't change
+    xsTable.push_back( getAtomDensity() * getMicroXS( p ) );
+    for ( unsigned int i = 1; i < xsNames.size(); i++ )
+    {
+      double xs = 0.0;
+      for ( auto n : nuclides ) 
+      { 
+        xs += n.first->getXS( p, xsNames[i] ) * n.second;
+      }
+      xsTable.push_back( getAtomDensity() * xs );
+    }
+  }
+}
+
 // randomly sample a nuclide based on total cross sections and atomic fractions
 Nuclide_ptr Material::sampleNuclide( Part_ptr p ) 
 {
@@ -47,7 +83,7 @@ Nuclide_ptr Material::sampleNuclide( Part_ptr p )
 // function that samples an entire collision: sample nuclide, then its reaction, 
 // and finally process that reaction with input pointers to the working particle p
 // and the particle bank
-void Material::sampleCollision( Part_ptr p, std::stack< Part_ptr > &bank ) {
+Reaction_ptr Material::sampleCollision( Part_ptr p, std::stack< Part_ptr > &bank ) {
   // first sample nuclide
   Nuclide_ptr  N = sampleNuclide( p );
 
@@ -56,4 +92,13 @@ void Material::sampleCollision( Part_ptr p, std::stack< Part_ptr > &bank ) {
 
   // finally process the reaction
   R->sample( p, bank );
+  return R;
+}
+
+uint64_t Material::memoryUsage() {
+  uint64_t total = Memory::shared< Material >() + Memory::bytes( materialName ) + Memory::bytes( nuclides ) + Memory::bytes( xsTable );
+  for ( auto n : nuclides ) {
+    total += n.first->memoryUsage();
+  }
+  return total;
 }
@@ -22,6 +22,7 @@ using std::stack;
 
 typedef std::shared_ptr< Particle > Part_ptr;
 typedef std::shared_ptr< Nuclide  > Nuclide_ptr;
+typedef std::shared_ptr< Reaction > Reaction_ptr;
 
 class Material
 //Material in which neutrons transport through. Contains all x-sec data and processes reactions
@@ -32,10 +33,15 @@ class Material
     std::string                                     materialName;
     double                                          atomDensity; // for homogeneous, set to 1
     std::vector< std::pair< Nuclide_ptr, double > > nuclides;
+    std::vector< double >                           xsTable; // macroscopic xs, one row of xsNames per group
 
     double getMicroXS( Part_ptr p );
 
   public:
+    // columns of a row of the flattened cross section table, "total" first
+    static const std::vector< std::string > xsNames;
+    static int getXSIndex( std::string name ); // -1 if not a column
+
     // Constructor/Destructor
     Material( std::string label, double atomDensityi ) : materialName(label), atomDensity(atomDensityi) {};
    ~Material() {};
@@ -48,8 +54,13 @@ class Material
     double      getAtomDensity() { return atomDensity;  };
     double      getMacroXS( Part_ptr p );
 
+    // the row of macroscopic cross sections for the particle's group, laid out as xsNames
+    const double* getMacroXSRow( Part_ptr p ) { return &xsTable[ ( p->getGroup() - 1 ) * xsNames.size() ]; };
+
     // Functions
+    void        flattenXS       ( int nGroups                         ); // fill the table once all nuclides are added
     Nuclide_ptr sampleNuclide   ( Part_ptr p                          );
-    void        sampleCollision ( Part_ptr p, stack< Part_ptr > &bank );
+    Reaction_ptr sampleCollision( Part_ptr p, stack< Part_ptr > &bank ); // returns the reaction that happened
+    uint64_t     memoryUsage(); // bytes, with the cross section table, nuclides and their reactions
 };
 #endif
@@ -0,0 +1,100 @@
+/*
+ * Memory accounting
+ */
+
+#include "Memory.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+  std::atomic< uint64_t > owned[ Memory::numSubsystems ];    // by set()
+  std::atomic< int64_t >  buffers[ Memory::numSubsystems ];  // by add()
+  std::atomic< uint64_t > peaks[ Memory::numSubsystems ];
+
+  void raisePeak(Memory::Subsystem s , uint64_t bytes) {
+    uint64_t seen = peaks[s].load();
+    while( bytes > seen && ! peaks[s].compare_exchange_weak( seen , bytes ) ) {}
+  }
+
+  // a "Vm...:   1234 kB" line of /proc/self/status
+  uint64_t procStatus(const std::string &key) {
+    std::ifstream status( "/proc/self/status" );
+    std::string line;
+    while( std::getline( status , line ) ) {
+      if( line.compare( 0 , key.size() , key ) == 0 ) {
+        std::istringstream fields( line.substr( key.size() + 1 ) );
+        uint64_t kB = 0;
+        fields >> kB;
+        return( 1024 * kB );
+      }
+    }
+    return(0);
+  }
+
+  // kB below a MB, the cross sections of a small problem hardly register in MB
+  std::string megabytes(uint64_t bytes) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    if( bytes < 1024 * 1024 ) { text << bytes / 1024.0 << " kB"; }
+    else                      { text << bytes / ( 1024.0 * 1024.0 ) << " MB"; }
+    return( text.str() );
+  }
+}
+
+std::string Memory::name(Subsystem s) {
+  switch( s ) {
+    case geometry:  return "geometry";
+    case materials: return "materials and cross sections";
+    case mesh:      return "mesh";
+    case tallies:   return "tallies";
+    case banks:     return "particle bank";
+    case output:    return "output buffers";
+    default:        return "unknown";
+  }
+}
+
+void Memory::set(Subsystem s , uint64_t bytes , uint64_t peak) {
+  owned[s] = bytes;
+  uint64_t now = current(s);
+  raisePeak( s , now > peak ? now : peak );
+}
+
+void Memory::add(Subsystem s , int64_t bytes) {
+  buffers[s] += bytes;
+  raisePeak( s , current(s) );
+}
+
+uint64_t Memory::current(Subsystem s) {
+  int64_t total = static_cast< int64_t >( owned[s].load() ) + buffers[s].load();
+  return( total > 0 ? total : 0 );
+}
+
+uint64_t Memory::peak(Subsystem s) {
+  return( peaks[s].load() );
+}
+
+uint64_t Memory::residentSize()     { return( procStatus( "VmRSS" ) ); }
+uint64_t Memory::peakResidentSize() { return( procStatus( "VmHWM" ) ); }
+
+void Memory::print(const std::string &when) {
+  uint64_t totalCurrent = 0 , totalPeak = 0;
+  std::cout << std::endl << "Memory " << when << ":" << std::endl;
+  std::cout << "  " << std::left << std::setw(30) << "subsystem" << std::right << std::setw(12) << "current" << std::setw(12) << "peak" << std::endl;
+  for( int s = 0; s < numSubsystems; s++ ) {
+    Subsystem subsystem = static_cast< Subsystem >(s);
+    totalCurrent += current(subsystem);
+    totalPeak    += peak(subsystem);
+    std::cout << "  " << std::left << std::setw(30) << name(subsystem) << std::right
+              << std::setw(12) << megabytes( current(subsystem) ) << std::setw(12) << megabytes( peak(subsystem) ) << std::endl;
+  }
+  std::cout << "  " << std::left << std::setw(30) << "accounted for" << std::right
+            << std::setw(12) << megabytes( totalCurrent ) << std::setw(12) << megabytes( totalPeak ) << std::endl;
+  std::cout << "  " << std::left << std::setw(30) << "resident (VmRSS, VmHWM)" << std::right
+            << std::setw(12) << megabytes( residentSize() ) << std::setw(12) << megabytes( peakResidentSize() ) << std::endl;
+}
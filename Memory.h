@@ -0,0 +1,60 @@
+/*
+ * Memory accounting
+ *
+ * Bytes held by each subsystem, counted explicitly rather than by hooking the allocator: the objects that
+ * make up a subsystem report the capacity of their containers plus their own size (memoryUsage()), and
+ * buffers that come and go (text output, tally snapshots, VTK arrays) add themselves while they live.
+ * Transport takes a sample at setup, at every batch boundary and at the end; the peak of each subsystem
+ * is the largest sample or buffer total seen. Heap overheads (allocator headers, map nodes) are left out,
+ * so the process's resident size from /proc (VmRSS, and its peak VmHWM) is printed alongside as a check.
+ *
+ * A forked worker accounts for itself, the report of a --workers run covers the parent process.
+ */
+
+#ifndef _MEMORY_HEADER_
+#define _MEMORY_HEADER_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Memory {
+
+  enum Subsystem { geometry , materials , mesh , tallies , banks , output , numSubsystems };
+  std::string name(Subsystem s);
+
+  // what the subsystem's objects hold now, peak is at least that and at least the given peak
+  void set(Subsystem s , uint64_t bytes , uint64_t peak = 0);
+
+  // a buffer of the subsystem allocated ( bytes > 0 ) or freed ( bytes < 0 ), safe from any thread
+  void add(Subsystem s , int64_t bytes);
+
+  uint64_t current(Subsystem s);
+  uint64_t peak(Subsystem s);
+
+  // VmRSS and VmHWM of this process in bytes, 0 if /proc can't tell
+  uint64_t residentSize();
+  uint64_t peakResidentSize();
+
+  void print(const std::string &when);
+
+  // bytes of a container's storage and of an object made by make_shared (with its control block)
+  template< class T > uint64_t bytes(const std::vector< T > &v) { return( v.capacity() * sizeof(T) ); };
+  inline uint64_t bytes(const std::string &s) { return( s.capacity() > 15 ? s.capacity() + 1 : 0 ); };
+  template< class T > uint64_t shared() { return( sizeof(T) + 2 * sizeof(long) ); };
+
+  // adds a buffer for as long as it lives
+  class Buffer {
+    private:
+      Subsystem subsystem;
+      uint64_t  size;
+    public:
+      Buffer(Subsystem s , uint64_t sizein) : subsystem(s) , size(sizein) { add( subsystem , size ); };
+     ~Buffer() { add( subsystem , - static_cast< int64_t >( size ) ); };
+      Buffer(const Buffer &) = delete;
+      Buffer &operator=(const Buffer &) = delete;
+  };
+}
+
+#endif
@@ -7,11 +7,20 @@
 //
 
 #include "Mesh.h"
+#include "Memory.h"
+
+#include <algorithm>
+#include <map>
+#include <cmath>
+#include <limits>
 
 Mesh::Mesh( std::string fileName, bool loud , Constants_ptr constantsin ): constants(constantsin)
 {
     readFile( fileName, loud );
     histCounter = 0;
+    lastTet     = -1;
+    indexedTets = 0;
+    buildIndex();
 }
 
 void Mesh::readFile( std::string fileName, bool loud )
@@ -63,6 +72,11 @@ void Mesh::readFile( std::string fileName, bool loud )
         
         verticesVector.push_back(vertice);
         Mesh::addVertice(vertice);
+
+        // need this for VTK output
+        vtkPoints.push_back(tempPtr->x);
+        vtkPoints.push_back(tempPtr->y);
+        vtkPoints.push_back(tempPtr->z);
         
     }
     
@@ -197,33 +211,135 @@ void Mesh::printVertices()
     }
 }
 
-Tet_ptr Mesh::whereAmI( point pos )
+void Mesh::buildIndex()
+{
+    gridStart.clear();
+    gridTets.clear();
+    indexedTets = tetVector.size();
+    if ( tetVector.empty() ) { return; }
+
+    std::vector< std::vector< double > > low , high;
+    double lo[3] = {  std::numeric_limits< double >::max() ,  std::numeric_limits< double >::max() ,  std::numeric_limits< double >::max() };
+    double hi[3] = { -std::numeric_limits< double >::max() , -std::numeric_limits< double >::max() , -std::numeric_limits< double >::max() };
+    for ( auto tet : tetVector ) {
+        std::vector< double > v[4] = { tet->getVert1() , tet->getVert2() , tet->getVert3() , tet->getVert4() };
+        std::vector< double > l( 3 ) , h( 3 );
+        for ( int a = 0; a < 3; a++ ) {
+            l[a] = std::min( std::min( v[0][a] , v[1][a] ) , std::min( v[2][a] , v[3][a] ) );
+            h[a] = std::max( std::max( v[0][a] , v[1][a] ) , std::max( v[2][a] , v[3][a] ) );
+            lo[a] = std::min( lo[a] , l[a] );
+            hi[a] = std::max( hi[a] , h[a] );
+        }
+        low.push_back( l );
+        high.push_back( h );
+    }
+
+    // about one grid cell per tet, as near cubic as the mesh's extent allows
+    double extent[3] , volume = 1.0;
+    for ( int a = 0; a < 3; a++ ) {
+        extent[a] = std::max( hi[a] - lo[a] , 1.0e-12 );
+        volume   *= extent[a];
+    }
+    double side = std::cbrt( volume / tetVector.size() );
+    for ( int a = 0; a < 3; a++ ) {
+        gridSize[a]  = std::max( 1 , std::min( 1024 , (int)std::ceil( extent[a] / side ) ) );
+        gridMin[a]   = lo[a];
+        gridWidth[a] = extent[a] / gridSize[a];
+    }
+
+    // count the tets of each grid cell, then fill
+    int numCells = gridSize[0] * gridSize[1] * gridSize[2];
+    gridStart.assign( numCells + 1 , 0 );
+    for ( int pass = 0; pass < 2; pass++ ) {
+        std::vector< int > next( gridStart.begin() , gridStart.end() - 1 );
+        for ( unsigned int t = 0; t < tetVector.size(); t++ ) {
+            int from[3] , to[3];
+            for ( int a = 0; a < 3; a++ ) {
+                from[a] = gridCell( low[t][a] , a );
+                to[a]   = gridCell( high[t][a] , a );
+            }
+            for ( int k = from[2]; k <= to[2]; k++ ) {
+                for ( int j = from[1]; j <= to[1]; j++ ) {
+                    for ( int i = from[0]; i <= to[0]; i++ ) {
+                        int g = i + gridSize[0] * ( j + gridSize[1] * k );
+                        if ( pass == 0 ) { gridStart[ g + 1 ]++; }
+                        else             { gridTets[ next[g]++ ] = t; }
+                    }
+                }
+            }
+        }
+        if ( pass == 0 ) {
+            for ( int g = 0; g < numCells; g++ ) { gridStart[ g + 1 ] += gridStart[g]; }
+            gridTets.resize( gridStart.back() );
+        }
+    }
+}
+
+int Mesh::gridCell( double x , int axis )
 {
-    Tet_ptr hereIAm = nullptr;
+    // the edges of the grid are the edges of tets, a rounding error off them still counts as on
+    double f = ( x - gridMin[axis] ) / gridWidth[axis];
+    if ( f < -1.0e-9 || f > gridSize[axis] + 1.0e-9 ) { return -1; }
+    return( std::max( 0 , std::min( (int)f , gridSize[axis] - 1 ) ) );
+}
 
+int Mesh::locate( point pos )
+{
     std::vector< double > testPoint = Utility::pointFourVec( pos );
-    
-    for( auto tet : tetVector )
+
+    // the tally and the cost profile locate the same collision one after the other
+    if ( lastTet >= 0 && lastTet < (int)tetVector.size() && tetVector[lastTet]->amIHere( testPoint ) )
+    {
+        return lastTet;
+    }
+
+    // tets added since the index was built
+    if ( indexedTets != tetVector.size() ) { buildIndex(); }
+    if ( gridStart.empty() ) { return -1; }
+
+    // only the tets that overlap the point's grid cell
+    int i = gridCell( pos.x , 0 );
+    int j = gridCell( pos.y , 1 );
+    int k = gridCell( pos.z , 2 );
+    if ( i < 0 || j < 0 || k < 0 ) { return -1; }
+    int g = i + gridSize[0] * ( j + gridSize[1] * k );
+    for( int n = gridStart[g]; n < gridStart[ g + 1 ]; n++ )
     {
-        if ( tet->amIHere( testPoint ) == true )
+        if ( tetVector[ gridTets[n] ]->amIHere( testPoint ) )
         {
-            return tet;
+            lastTet = gridTets[n];
+            return lastTet;
         }
     }
+    return -1;
+}
 
-    if ( hereIAm == nullptr )
-    {
-       // std::cout << "ERROR: Couldn't locate Tet." << std::endl;
+Tet_ptr Mesh::whereAmI( point pos )
+{
+    // nullptr outside the mesh, the scoring reports that
+    int i = locate( pos );
+    return( i < 0 ? nullptr : tetVector[i] );
+}
+
+bool Mesh::hasEstimators() {
+    if ( ! estimators.empty() ) { return true; }
+    for( auto tet : tetVector ) {
+        if ( ! tet->getEstimators().empty() ) { return true; }
     }
-    return hereIAm;
+    return false;
 }
 
-void Mesh::scoreTally(Part_ptr p, double xs) {
+void Mesh::scoreTally(Part_ptr p, const double* xs) {
     //what tet in the mesh did the particle collide in?
     Tet_ptr t = whereAmI( p->getPos() );
     
     // make sure its a valid mesh element
     if(t != nullptr) {
+        // mesh wide collections allocate their estimator for this tet on first score
+        for(auto est : estimators) {
+            est->scoreCollision(p , xs , t->getID());
+        }
+
         //score the tally in that tet
         t->scoreTally(p , xs);
         for(int i = 0; i < histCounter; i++)
@@ -242,6 +358,9 @@ void Mesh::scoreTally(Part_ptr p, double xs) {
 }
 
 void Mesh::endTallyHist() {
+    for(auto est : estimators) {
+        est->endHist();
+    }
     for(int i = 0; i < histCounter; i++)
     {
         tetHist[i]->endTallyHist();
@@ -250,217 +369,111 @@ void Mesh::endTallyHist() {
     histCounter = 0;
 }
 
-void Mesh::printMeshTallies() {
+void Mesh::printMeshTallies( unsigned long long nHist ) {
     std::cout << "Printing mesh tallies to " << "outfiles/" << outFilename << "..." << std::endl;
 
     std::ofstream meshTallyStream;
     meshTallyStream.open( "outfiles/" + outFilename );
+    TextWriter text( meshTallyStream );
+
+    text << "Mesh tally output\n";
+    text << "tally   bin   mean   R\n";
 
-    meshTallyStream << "Mesh tally output" << std::endl;
+    // tallies on individual tets
+    for ( auto tet : tetVector ) {
+        for ( auto est : tet->getEstimators() ) {
+            std::vector< Estimator_ptr > bins = est->getEstimators();
+            for ( unsigned int j = 0; j < bins.size(); j++ ) {
+                text << est->name() << "   tet " << tet->getID() << " bin " << est->getBinLabel(j) << "   "
+                                << bins[j]->getScalarEstimator(nHist).first << "   " << bins[j]->getRelativeError(nHist) << '\n';
+            }
+        }
+    }
 
-    /*
-    for(auto tet : tetVector) {
-        meshTallyStream << tet->getID();
-        for (auto tally : tet->getTally(constants->getNumHis()) ) {
-            meshTallyStream << "   " << tally.first;
+    // tallies over the whole mesh, only the tets that were scored
+    for ( auto est : estimators ) {
+        std::vector< Estimator_ptr > bins = est->getEstimators();
+        for ( unsigned int j = 0; j < bins.size(); j++ ) {
+            text << est->name() << "   " << est->getBinLabel(j) << "   "
+                            << bins[j]->getScalarEstimator(nHist).first << "   " << bins[j]->getRelativeError(nHist) << '\n';
         }
-        meshTallyStream << std::endl;
     }
-    */
 
+    text.flush();
     meshTallyStream.close();
 }
 
-void Mesh::writeToVTK() {
-
-
+void Mesh::writeToVTK( unsigned long long nHist ) {
     std::cout << "Writing mesh tallies to " << "outfiles/" << vtkFilename << "..." << std::endl;
 
-    std::ofstream vtkStream;
-    vtkStream.open( "outfiles/" + vtkFilename );
-
-    // Specify file type
-    XMLTag vtkfile( 0, "VTKFile" );
-    vtkfile.addAttribute( "type", "UnstructuredGrid" );
-    vtkfile.addAttribute( "version", "0.1" );
-    vtkfile.addAttribute( "byte_order", "LittleEndian" );
-    vtkfile.addAttribute( "compressor", "vtkZLibDataCompressor");
-
-    // Specify grid type
-    XMLTag unstGrid( 1, "UnstructuredGrid");
-
-    // Piece (has information for points and cells)
-    XMLTag piece( 2, "Piece" );
-    piece.addAttribute( "NumberOfPoints", std::to_string(numVertices) );
-    piece.addAttribute( "NumberOfCells", std::to_string(numTets) );
-
-    // Point Data (not currently using)
-    XMLTag pointData1( 3, "PointData" );
-
-    // CellData (xml calls them 'cells', hammer calls them 'tets')
-    // Need to find a way to loop through a tet's estimators
-    XMLTag cellData( 3, "CellData" );
-    cellData.addAttribute( "Scalars", "mesh_tallies");
-/*
-    for ( auto tally : tetVector[0]->getTally(constants->getNumHis()) ) {
-           std::vector<double> tempVec;
-           cellDataVec.push_back(tempVec);
+    // CellData (xml calls them 'cells', hammer calls them 'tets'), one mean and one R array per tally bin and
+    // response named like those of the structured mesh, tets without the tally read back as zero
+    std::vector< VTK::CellData > tallyData;
+    std::map< std::string , size_t > column;
+    auto setCell = [&]( const std::string &label , size_t tet , Estimator_ptr est ) {
+        auto found = column.find( label );
+        if ( found == column.end() ) {
+            found = column.insert( std::make_pair( label , tallyData.size() ) ).first;
+            tallyData.push_back( std::make_pair( label + " mean" , std::vector< double >( tetVector.size() , 0.0 ) ) );
+            tallyData.push_back( std::make_pair( label + " R" , std::vector< double >( tetVector.size() , 1.0 ) ) );
         }
-
-    for ( auto tet : tetVector ) {
-        int i = 0;
-        for (auto tally : tet->getTally(constants->getNumHis()) ) {
-            if ( i == constants->getNumGroups() ) {
-                i = 0;
+        if ( est ) {
+            tallyData[ found->second ].second[tet]     = est->getScalarEstimator(nHist).first;
+            tallyData[ found->second + 1 ].second[tet] = est->getRelativeError(nHist);
+        }
+    };
+    auto label = []( EstimatorCollection &est , int bin , int r ) {
+        return( est.name() + ( est.getSize() > 1 ? " bin " + std::to_string(bin) : "" ) + " " + est.getResponses()[r] );
+    };
+    for ( size_t i = 0; i < tetVector.size(); i++ ) {
+        for ( const auto &est : tetVector[i]->getEstimators() ) {
+            std::vector< Estimator_ptr > bins = est->getEstimators();
+            int n = est->getNumResponses();
+            for ( unsigned int j = 0; j < bins.size(); j++ ) {
+                setCell( label( *est , j / n , j % n ) , i , bins[j] );
+            }
+        }
+        for ( const auto &est : estimators ) {
+            int n = est->getNumResponses();
+            for ( int bin = 0; bin < est->getSize(); bin++ ) {
+                for ( int r = 0; r < n; r++ ) {
+                    setCell( label( *est , bin , r ) , i , est->getEstimator( tetVector[i]->getID() , bin , r ) );
+                }
             }
-            cellDataVec[i].push_back(tally.first);
-            i++;
         }
     }
-*/
-    std::vector< std::shared_ptr< XMLTag > > tallyTags;
-    int i = 0;
-    double tallyMin, tallyMax;
-    for ( auto dataVec : cellDataVec ) {
-
-        //std::string tallyName = tetVector[0]->getEstimators()[i]->name();
-        //TODO fix this
-        std::string tallyName = "";
-        XMLTag tallyTag( 4, "DataArray" );
-        tallyTag.addAttribute( "type", "Float64");
-        tallyTag.addAttribute( "Name", tallyName );
-        tallyTag.addAttribute( "format", "ascii" );
-        tallyMin = Utility::vecMin(dataVec);
-        tallyMax = Utility::vecMax(dataVec);
-        // the string stream is the only way I was able to retain precision
-        std::ostringstream maxStream, minStream;
-        maxStream << tallyMax;
-        minStream << tallyMin;
-        std::string maxString = maxStream.str();
-        std::string minString = minStream.str();
-        tallyTag.addAttribute( "RangeMin", minString );
-        tallyTag.addAttribute( "RangeMax", maxString );
-        tallyTag.addDataArray( dataVec );
-        std::shared_ptr< XMLTag > Tag_ptr = std::make_shared< XMLTag >( tallyTag );
-
-        tallyTags.push_back( Tag_ptr );
-
-        i++;
+    uint64_t written = Memory::bytes( tallyData );
+    for ( const auto &data : tallyData ) {
+        written += Memory::bytes( data.second );
     }
+    Memory::Buffer accounted( Memory::output , written );
 
-    // Points and data array
-    XMLTag points( 3, "Points" );
-    XMLTag pointsData( 4, "DataArray" );
-    pointsData.addAttribute( "type", "Float64" );
-    pointsData.addAttribute( "Name", "Points" );
-    pointsData.addAttribute( "NumberOfComponents", "3" );
-    pointsData.addAttribute( "format", "ascii" );
-
-    // Find the max/min value vertex in the mesh
-    double maxCoor = verticesVector[0].second->x;
-    double minCoor = verticesVector[0].second->x;
-
-    std::vector< double > vtkPointVec;
-
-    for ( auto vert : verticesVector ) {
-        // Find max
-        if ( (vert.second->x) > maxCoor ) { maxCoor = vert.second->x; }
-        if ( (vert.second->y) > maxCoor ) { maxCoor = vert.second->y; }
-        if ( (vert.second->y) > maxCoor ) { maxCoor = vert.second->y; }
-        // Find min
-        if ( (vert.second->x) < minCoor ) { minCoor = vert.second->x; }
-        if ( (vert.second->y) < minCoor ) { minCoor = vert.second->y; }
-        if ( (vert.second->y) < minCoor ) { minCoor = vert.second->y; }
-
-        vtkPointVec.push_back(vert.second->x);
-        vtkPointVec.push_back(vert.second->y);
-        vtkPointVec.push_back(vert.second->z);
+    // the named arrays are written from where they are kept
+    std::vector< const VTK::CellData* > cellData;
+    for ( const auto &data : tallyData ) {
+        cellData.push_back( &data );
     }
-
-    // the string stream is the only way I was able to retain precision
-    std::ostringstream maxCoorStream, minCoorStream;
-    maxCoorStream << maxCoor;
-    minCoorStream << minCoor;
-    std::string maxCoorString = maxCoorStream.str();
-    std::string minCoorString = minCoorStream.str();
-
-    pointsData.addAttribute( "RangeMin", minCoorString );
-    pointsData.addAttribute( "RangeMax", maxCoorString );
-    pointsData.addDataArray( vtkPointVec );
-
-    // Cells and data arrays
-    XMLTag cells( 3, "Cells" );
-    XMLTag cellsData1( 4, "DataArray" ); // tells vtk which points are associated with each tet
-    XMLTag cellsData2( 4, "DataArray" ); // tells vtk how to segment the the tet associations
-    XMLTag cellsData3( 4, "DataArray" ); // tells vtk which type of cell to build
-
-    cellsData1.addAttribute( "type", "Int64" );
-    cellsData1.addAttribute( "Name", "connectivity" );
-    cellsData1.addAttribute( "format", "ascii" );
-    cellsData1.addAttribute( "RangeMin", "0" );
-    cellsData1.addAttribute( "RangeMax", std::to_string(numVertices-1) );
-    cellsData1.addDataArray( connectivity );
-
-    cellsData2.addAttribute( "type", "Int64" );
-    cellsData2.addAttribute( "Name", "offsets" );
-    cellsData2.addAttribute( "format", "ascii" );
-    cellsData2.addAttribute( "RangeMin", "4" ); // 4 corresponds to number of verts in tet
-    cellsData2.addAttribute( "RangeMax", std::to_string(4*numTets) );
-
-    std::vector< double > offsets;
-    for ( int i = 0; i<numTets; i++ ) {
-        offsets.push_back( 4.0*(i+1) );
+    for ( const auto &data : namedCellData ) {
+        cellData.push_back( &data );
     }
 
-    cellsData2.addDataArray( offsets );
-
-    cellsData3.addAttribute( "type", "UInt8" );
-    cellsData3.addAttribute( "Name", "types" );
-    cellsData3.addAttribute( "format", "ascii" );
-    cellsData3.addAttribute( "RangeMin", "10" ); // 10 corresponds to vtk cell type (tetrahedron)
-    cellsData3.addAttribute( "RangeMax", "10" ); // 10 corresponds to vtk cell type (tetrahedron)
+    VTK::writeUnstructuredGrid( "outfiles/" + vtkFilename, vtkPoints, connectivity, 4, VTK::tetrahedron, cellData );
+}
 
-    std::vector< double > vtkCellType;
-    for ( int i = 0; i<numTets; i++) {
-        vtkCellType.push_back( 10 );
+uint64_t Mesh::memoryUsage() {
+    uint64_t total = Memory::bytes( verticesVector ) + Memory::bytes( tetVector ) + Memory::bytes( tetHist ) + Memory::bytes( estimators )
+                   + Memory::bytes( gridStart ) + Memory::bytes( gridTets );
+    total += verticesVector.size() * Memory::shared< point >();
+    for ( auto tet : tetVector ) {
+        total += tet->memoryUsage();
     }
+    return total;
+}
 
-    cellsData3.addDataArray( vtkCellType );
-
-    // Write all XMLTags and Data Arrays to file
-    vtkStream << "<?xml version=\"1.0\"?>" << std::endl;
-    vtkStream << vtkfile.getTagOpen() << std::endl;
-    vtkStream << unstGrid.getTagOpen() << std::endl;
-    vtkStream << piece.getTagOpen() << std::endl;
-    vtkStream << pointData1.getTagOpen() << std::endl;
-    vtkStream << pointData1.getTagClose() << std::endl;
-    vtkStream << cellData.getTagOpen() << std::endl;
-    // loop over the estimator tallies and write to file
-    for ( auto tag : tallyTags ) {
-        vtkStream << tag->getTagOpen() << std::endl;
-        tag->arrayToFile( vtkStream, 24, false );
-        vtkStream << tag->getTagClose() << std::endl;
+uint64_t Mesh::vtkMemoryUsage() {
+    uint64_t total = Memory::bytes( vtkPoints ) + Memory::bytes( connectivity ) + Memory::bytes( namedCellData );
+    for ( const auto &data : namedCellData ) {
+        total += Memory::bytes( data.second );
     }
-    vtkStream << cellData.getTagClose() << std::endl;
-    vtkStream << points.getTagOpen() << std::endl;
-    vtkStream << pointsData.getTagOpen() << std::endl;
-    pointsData.arrayToFile( vtkStream, 12, false );
-    vtkStream << pointsData.getTagClose() << std::endl;
-    vtkStream << points.getTagClose() << std::endl;
-    vtkStream << cells.getTagOpen() << std::endl;
-    vtkStream << cellsData1.getTagOpen() << std::endl;
-    cellsData1.arrayToFile( vtkStream, 24, true );
-    vtkStream << cellsData1.getTagClose() << std::endl;
-    vtkStream << cellsData2.getTagOpen() << std::endl;
-    cellsData2.arrayToFile( vtkStream, 16, true );
-    vtkStream << cellsData2.getTagClose() << std::endl;
-    vtkStream << cellsData3.getTagOpen() << std::endl;
-    cellsData3.arrayToFile( vtkStream, 32, true );
-    vtkStream << cellsData3.getTagClose() << std::endl;
-    vtkStream << cells.getTagClose() << std::endl;
-    vtkStream << piece.getTagClose() << std::endl;
-    vtkStream << unstGrid.getTagClose() << std::endl;
-    vtkStream << vtkfile.getTagClose() << std::endl;
-
-    vtkStream.close();
+    return total;
 }
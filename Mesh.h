@@ -12,7 +12,7 @@
 #include "Tet.h"
 #include "Point.h"
 #include "Utility.h"
-#include "XMLTag.h"
+#include "VTKWriter.h"
 
 #include <vector>
 #include <utility>
@@ -35,15 +35,31 @@ private:
     std::vector < std::pair<int,Point_ptr> > verticesVector;
     std::vector < Tet_ptr >   tetVector;
     std::vector < Tet_ptr > tetHist;
+    std::vector< double > vtkPoints;    // x y z of every vertex, need this vector for VTK output
     std::vector< double > connectivity; // need this vector for VTK output
-    std::vector< std::vector< double > > cellDataVec; // need this vector for VTK output
+    std::vector< VTK::CellData > namedCellData; // per tet arrays other code hands in, e.g. the cost profile
     int histCounter;
+    int lastTet; // found by the last locate, tried first by the next
+
+    // uniform grid over the mesh, each grid cell lists the tets whose bounding boxes overlap it (compressed
+    // rows: the tets of grid cell g are gridTets[ gridStart[g] ] up to gridTets[ gridStart[g+1] ])
+    double gridMin[3];
+    double gridWidth[3];
+    int    gridSize[3];
+    std::vector< int > gridStart;
+    std::vector< int > gridTets;
+    size_t indexedTets;
+    void buildIndex();
+    int  gridCell( double x , int axis ); // -1 off the grid
     int numVertices;
     int numTets;
     void readFile( std::string fileName, bool loud );
     std::string outFilename;
     std::string vtkFilename;
     Constants_ptr constants;
+
+    // collections covering every tet, scored with the tet id
+    std::vector< std::shared_ptr< SparseMeshEstimatorCollection > > estimators;
     
     
 public:
@@ -61,15 +77,23 @@ public:
     void printTets();
     void printVertices();
     Tet_ptr whereAmI( point pos );
+    int     locate( point pos ); // index of the tet in getTets() (and the VTK cells), -1 if outside the mesh
     std::vector< Tet_ptr > getTets() { return tetVector; };
 
     // estimator interface
-    void scoreTally( Part_ptr p , double xs );
+    void addEstimator( std::shared_ptr< SparseMeshEstimatorCollection > newEstimator ) { estimators.push_back( newEstimator ); };
+    bool hasEstimators();
+    void scoreTally( Part_ptr p , const double* xs ); // xs is the material macroscopic xs row
     void endTallyHist();
-    void printMeshTallies();
+    void printMeshTallies( unsigned long long nHist );
 
     // VTK (xml) interface
-    void writeToVTK();
+    void writeToVTK( unsigned long long nHist ); // tet tallies as mean and R arrays, then the named arrays
+    void addCellData( std::string name , std::vector< double > values ) { namedCellData.push_back( std::make_pair( name , std::move( values ) ) ); };
+
+    // bytes of the tets and vertices, and of the arrays kept for the VTK file
+    uint64_t memoryUsage();
+    uint64_t vtkMemoryUsage();
     void setVTKFilename( std::string filename ) { vtkFilename = filename; };
     void setOutFilename( std::string filename ) { outFilename = filename; };
     
@@ -4,6 +4,7 @@
 */
 
 #include "Nuclide.h"
+#include "Memory.h"
 
 // return the total microscopic cross section
 double Nuclide::getTotalXS( Part_ptr p ) 
@@ -41,4 +42,14 @@ Reaction_ptr Nuclide::sampleReaction( Part_ptr p )
   }
   assert( false ); // should never reach here
   return nullptr;
-}
\ No newline at end of file
+}
+
+uint64_t Nuclide::memoryUsage()
+{
+  uint64_t total = Memory::shared< Nuclide >() + Memory::bytes( nuclideName ) + Memory::bytes( reactions );
+  for ( auto reaction : reactions ) 
+  {
+    total += reaction->memoryUsage();
+  }
+  return total;
+}
@@ -41,6 +41,7 @@ class Nuclide
 
     // Functions
     Reaction_ptr sampleReaction( Part_ptr p );
+    uint64_t     memoryUsage(); // bytes, with its reactions
 };
 
 #endif
\ No newline at end of file
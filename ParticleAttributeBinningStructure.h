@@ -38,7 +38,8 @@ class GroupBinningStructure : public ParticleAttributeBinningStructure {
   private:
     Utility::BinningStructure<int> binning;
   public:
-    GroupBinningStructure(int numGroups): ParticleAttributeBinningStructure(numGroups) , binning(0 , numGroups , numGroups) {};
+    // groups are numbered 1 ... numGroups
+    GroupBinningStructure(int numGroups): ParticleAttributeBinningStructure(numGroups) , binning(1 , numGroups + 1 , numGroups) {};
    ~GroupBinningStructure() {};
     
     std::pair< int , bool > getIndex( Part_ptr p ) { return(binning.getIndex( p->getGroup() ) ); };
@@ -48,8 +49,8 @@ class CollisionOrderBinningStructure : public ParticleAttributeBinningStructure
   private:
     Utility::BinningStructure<int> binning;
   public:
-    CollisionOrderBinningStructure(int min , int max): ParticleAttributeBinningStructure(max - min) , binning(min   , max   , 1 + max - min ) {};
-    CollisionOrderBinningStructure(int order        ): ParticleAttributeBinningStructure( 1       ) , binning(order , order , 1             ) {};
+    CollisionOrderBinningStructure(int min , int max): ParticleAttributeBinningStructure(1 + max - min) , binning(min   , max + 1   , 1 + max - min ) {};
+    CollisionOrderBinningStructure(int order        ): ParticleAttributeBinningStructure( 1           ) , binning(order , order + 1 , 1             ) {};
    ~CollisionOrderBinningStructure() {};
     
     std::pair< int , bool > getIndex( Part_ptr p ) { return(binning.getIndex( p->getNumCollisions() ) ); };
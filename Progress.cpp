@@ -0,0 +1,135 @@
+/*
+ * Live progress
+ */
+
+#include "Progress.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include <sys/mman.h>
+
+Progress::Progress(vector< string > tallyNamesin , double intervalin , int numSlotsin) :
+  tallyNames(tallyNamesin) , interval(intervalin) , numSlots( numSlotsin > 0 ? numSlotsin : 1 ) , stopping(false)
+{
+  if( tallyNames.size() > maxTallies ) {
+    std::cout << "Progress reports the first " << maxTallies << " of the " << tallyNames.size() << " tallies asked for." << std::endl;
+    tallyNames.resize( maxTallies );
+  }
+
+  // shared with the workers forked later on
+  mappedSize = numSlots * sizeof(Slot);
+  void* memory = mmap( nullptr , mappedSize , PROT_READ | PROT_WRITE , MAP_SHARED | MAP_ANONYMOUS , -1 , 0 );
+  if( memory == MAP_FAILED ) {
+    std::cout << " could not map " << mappedSize << " bytes of shared memory for the progress counters" << std::endl;
+    throw;
+  }
+  slots = static_cast< Slot* >( memory );
+  for( int s = 0; s < numSlots; s++ ) {
+    Slot* slot = new( &slots[s] ) Slot;
+    slot->planned        = 0;
+    slot->histories      = 0;
+    slot->tallyHistories = 0;
+    for( int t = 0; t < maxTallies; t++ ) { slot->relErr[t] = 0.0; }
+  }
+};
+
+Progress::~Progress() {
+  stop();
+  munmap( slots , mappedSize );
+};
+
+void Progress::start() {
+  if( interval <= 0.0 || thread.joinable() ) { return; }
+  stopping = false;
+  thread   = std::thread( &Progress::run , this );
+};
+
+void Progress::stop() {
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  if( thread.joinable() ) { thread.join(); }
+};
+
+uint64_t Progress::planned() {
+  uint64_t total = 0;
+  for( int s = 0; s < numSlots; s++ ) { total += slots[s].planned.load( std::memory_order_relaxed ); }
+  return( total );
+};
+
+uint64_t Progress::histories() {
+  uint64_t total = 0;
+  for( int s = 0; s < numSlots; s++ ) { total += slots[s].histories.load( std::memory_order_relaxed ); }
+  return( total );
+};
+
+double Progress::relativeError(int tally) {
+  double   sumSquares = 0.0;
+  uint64_t n          = 0;
+  for( int s = 0; s < numSlots; s++ ) {
+    // the errors are stored before their history count, an error at least as new as the count is read
+    uint64_t nSlot  = slots[s].tallyHistories.load( std::memory_order_acquire );
+    double   relErr = slots[s].relErr[tally].load( std::memory_order_relaxed );
+    sumSquares += static_cast< double >( nSlot ) * nSlot * relErr * relErr;
+    n          += nSlot;
+  }
+  return( n > 0 ? std::sqrt( sumSquares ) / n : -1.0 );
+};
+
+string Progress::duration(double seconds) {
+  long long s = std::llround( seconds );
+  char text[32];
+  if( s >= 3600 )    { snprintf( text , sizeof(text) , "%lldh %02lldm %02llds" , s / 3600 , s / 60 % 60 , s % 60 ); }
+  else if( s >= 60 ) { snprintf( text , sizeof(text) , "%lldm %02llds" , s / 60 , s % 60 ); }
+  else               { snprintf( text , sizeof(text) , "%llds" , s ); }
+  return( text );
+};
+
+void Progress::run() {
+  auto start = std::chrono::steady_clock::now();
+  auto last  = start;
+  uint64_t historiesLast = histories();
+  std::unique_lock< std::mutex > lock(mutex);
+  while( ! wake.wait_for( lock , std::chrono::duration< double >( interval ) , [this] { return( stopping ); } ) ) {
+    auto now = std::chrono::steady_clock::now();
+    historiesLast = report( std::chrono::duration< double >( now - start ).count() , std::chrono::duration< double >( now - last ).count() , historiesLast );
+    last          = now;
+  }
+};
+
+uint64_t Progress::report(double elapsed , double sinceLast , uint64_t historiesLast) {
+  uint64_t total = planned();
+  uint64_t done  = histories();
+  if( total == 0 ) { return( done ); }
+
+  double rate    = done / elapsed;
+  double rateNow = ( done - historiesLast ) / sinceLast;
+
+  // one write, so the line isn't broken up by transport's own output
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1)
+       << "progress: " << done << " of " << total << " histories (" << 100.0 * done / total << "%), "
+       << std::setprecision(0) << rateNow << "/s now, " << rate << "/s average, ";
+  if( done > 0 ) {
+    line << duration( ( total - done ) / rate ) << " left";
+  }
+  else {
+    line << "no estimate of the time left yet";
+  }
+  line << std::setprecision(4);
+  for( size_t t = 0; t < tallyNames.size(); t++ ) {
+    double relErr = relativeError(t);
+    if( relErr >= 0.0 ) { line << ", " << tallyNames[t] << " R = " << relErr; }
+  }
+  line << '\n';
+  std::cout << line.str() << std::flush;
+  return( done );
+};
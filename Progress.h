@@ -0,0 +1,79 @@
+/*
+ * Live progress
+ *
+ * A thread that prints, every few seconds of a long run, the histories done, the rate over the last interval
+ * and over the whole run, the time left at the average rate and the relative error of some tallies.
+ *
+ * Transport stores its history count in a slot after every history, a relaxed atomic store with no lock, and
+ * the relative errors once per batch; the thread only reads the slots. The slots live in shared anonymous
+ * memory made before the workers are forked, one per worker, so the parent's thread sees every worker's count
+ * the same way it sees its own. Atomics of 8 bytes are lock free here, so they work across processes.
+ *
+ * The relative error of a tally is the worst bin over all collections of that name. With several workers it
+ * is combined from each worker's own, sqrt( sum N_w^2 R_w^2 ) / sum N_w, exact for one bin with the same mean
+ * in every worker and an estimate otherwise; the merged result at the end is what counts.
+ */
+
+#ifndef _PROGRESS_HEADER_
+#define _PROGRESS_HEADER_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::vector;
+using std::string;
+
+class Progress {
+  public:
+    static const int maxTallies = 8;
+
+    // written by one process, on a cache line of its own so the workers don't share one
+    struct alignas(64) Slot {
+      std::atomic< uint64_t > planned;        // histories this process is going to run
+      std::atomic< uint64_t > histories;      // done so far
+      std::atomic< uint64_t > tallyHistories; // the relative errors are of this many histories, 0 for none yet
+      std::atomic< double >   relErr[ maxTallies ];
+    };
+
+  private:
+    vector< string >        tallyNames;
+    double                  interval;   // seconds between reports
+    Slot*                   slots;
+    int                     numSlots;
+    size_t                  mappedSize;
+    std::thread             thread;
+    std::mutex              mutex;
+    std::condition_variable wake;
+    bool                    stopping;
+
+    void run();
+    uint64_t report(double elapsed , double sinceLast , uint64_t historiesLast); // returns the histories reported
+
+  public:
+    Progress(vector< string > tallyNamesin , double intervalin , int numSlotsin = 1);
+   ~Progress();
+    Progress(const Progress &) = delete;
+    Progress &operator=(const Progress &) = delete;
+
+    const vector< string > &getTallyNames() { return tallyNames; };
+    int                     getNumSlots()   { return numSlots; };
+    Slot                   &slot(int s)     { return slots[s]; };
+
+    // the reporting thread, started after any workers are forked and stopped when transport is done
+    void start();
+    void stop();
+
+    // the combined figures of all slots, what the reports print
+    uint64_t planned();
+    uint64_t histories();
+    double   relativeError(int tally); // negative until a batch has been published
+
+    static string duration(double seconds); // e.g. 1h 02m 03s
+};
+
+#endif
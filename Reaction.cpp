@@ -4,6 +4,17 @@
 */
 
 #include "Reaction.h"
+#include "Memory.h"
+
+std::string reactionTypeName( ReactionType type )
+{
+  switch( type ) {
+    case captureReaction: return "capture";
+    case scatterReaction: return "scatter";
+    case fissionReaction: return "fission";
+    default:              return "unknown";
+  }
+}
 
 double Capture::getXS( Part_ptr p )
 {
@@ -19,6 +30,7 @@ void Capture::sample( Part_ptr p, std::stack< Part_ptr > &bank )
 Scatter::Scatter( int ng, std::vector< std::vector< double > > scatterXSi ) : Reaction( ng ), scatterXS( scatterXSi )
 {
   rxnName = "Scatter";
+  rxnType = scatterReaction;
 
   // Fill the total scatter vector
   for (int j=0; j < nGroups; ++j) 
@@ -95,4 +107,24 @@ void  Fission::sample( Part_ptr p, std::stack< Part_ptr > &bank ) {
     *p = *q; // figure out how to do this
   }
   
-}
\ No newline at end of file
+}
+
+uint64_t Capture::memoryUsage()
+{
+  return Memory::shared< Capture >() + Memory::bytes( captureXS );
+}
+
+uint64_t Scatter::memoryUsage()
+{
+  uint64_t total = Memory::shared< Scatter >() + Memory::bytes( scatterXS ) + Memory::bytes( scatterTotalXS );
+  for ( const auto &row : scatterXS ) 
+  {
+    total += Memory::bytes( row );
+  }
+  return total;
+}
+
+uint64_t Fission::memoryUsage()
+{
+  return Memory::shared< Fission >() + Memory::bytes( fissionXS ) + Memory::bytes( nu ) + Memory::bytes( chi );
+}
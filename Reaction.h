@@ -12,6 +12,7 @@
 #include <memory>
 #include <stack>
 #include <utility>
+#include <cstdint>
 
 #include "Particle.h"
 #include "Source.h"
@@ -19,20 +20,27 @@
 typedef std::shared_ptr< Particle > Part_ptr;
 typedef std::shared_ptr< Source >   Source_ptr;
 
+// what a reaction does to the particle, collisions are counted by it
+enum ReactionType { captureReaction , scatterReaction , fissionReaction , numReactionTypes };
+std::string reactionTypeName( ReactionType type );
+
 class Reaction 
 // Need to add safety features
 {    
   protected:
-    std::string rxnName;
-    int         nGroups;
+    std::string  rxnName;
+    ReactionType rxnType;
+    int          nGroups;
 
   public:
     Reaction( int ng ) : nGroups( ng ) {};
    ~Reaction() {};
 
     virtual std::string name() final { return rxnName; };
+    ReactionType        type() { return rxnType; };
     virtual double      getXS  ( Part_ptr p ) = 0;
     virtual void        sample ( Part_ptr p, std::stack< Part_ptr > & bank ) = 0;
+    virtual uint64_t    memoryUsage() = 0; // bytes, with the cross sections
 };
 
 class Capture : public Reaction 
@@ -41,12 +49,13 @@ class Capture : public Reaction
     std::vector< double > captureXS; // size g
 
   public:
-    Capture( int ng, std::vector< double > captureXSi ) : Reaction( ng ), captureXS( captureXSi ) { rxnName = "Capture"; };
+    Capture( int ng, std::vector< double > captureXSi ) : Reaction( ng ), captureXS( captureXSi ) { rxnName = "Capture"; rxnType = captureReaction; };
    ~Capture() {};
 
     double getXS( Part_ptr p );
 
     void   sample( Part_ptr p, std::stack< Part_ptr > &bank );
+    uint64_t memoryUsage();
 };
 
 class Scatter : public Reaction 
@@ -62,6 +71,7 @@ class Scatter : public Reaction
     double getXS( Part_ptr p );
 
     void   sample( Part_ptr p, std::stack< Part_ptr > &bank );
+    uint64_t memoryUsage();
 };
 
 class Fission : public Reaction 
@@ -73,12 +83,13 @@ class Fission : public Reaction
 
   public:
     Fission( int ng, std::vector< double > fissionXSi, std::vector< double > nui, std::vector< double > chii ) 
-    : Reaction( ng ), fissionXS( fissionXSi ), nu( nui ), chi( chii ) { rxnName = "Fission"; };
+    : Reaction( ng ), fissionXS( fissionXSi ), nu( nui ), chi( chii ) { rxnName = "Fission"; rxnType = fissionReaction; };
    ~Fission() {};
 
     double getXS ( Part_ptr p );
 
     void   sample( Part_ptr p, std::stack< Part_ptr > &bank );
+    uint64_t memoryUsage();
 };
 
 #endif
\ No newline at end of file
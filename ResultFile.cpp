@@ -0,0 +1,227 @@
+/*
+ * Binary tally result file
+ */
+
+#include "ResultFile.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint64_t headerSize = 64;
+
+static uint64_t padded(uint64_t numBytes) {
+  return( ( numBytes + 7 ) / 8 * 8 );
+}
+
+/* ****************************************************************************************************** *
+ * Result Writer
+ *
+ * ****************************************************************************************************** */
+
+const char ResultWriter::magic[9] = "HMRTALLY";
+
+ResultWriter::ResultWriter(string filenamein , uint64_t numHistoriesin , uint64_t numBatchesin) :
+  filename(filenamein) , numHistories(numHistoriesin) , numBatches(numBatchesin)
+{
+  out.open( filename , std::ios::binary );
+  if( ! out ) {
+    std::cout << " could not open result file " << filename << std::endl;
+    throw;
+  }
+  // header is filled in by close()
+  for(uint64_t i = 0; i < headerSize / 8; ++i) { writeWord(0); }
+};
+
+void ResultWriter::writeWord(uint64_t word) {
+  out.write( reinterpret_cast< const char* >( &word ) , 8 );
+};
+
+void ResultWriter::writeString(const string &s) {
+  writeWord( s.size() );
+  out.write( s.data() , s.size() );
+  for(uint64_t i = s.size(); i < padded( s.size() ); ++i) { out.put(0); }
+};
+
+uint64_t ResultWriter::writeColumn(const vector< double > &column) {
+  uint64_t offset = out.tellp();
+  out.write( reinterpret_cast< const char* >( column.data() ) , 8 * column.size() );
+  return(offset);
+};
+
+void ResultWriter::addTally(const string &name , const string &appliedTo , const vector< string > &labels ,
+                            const vector< double > &mean , const vector< double > &stdErr , const vector< double > &batchMeans) {
+  TallyIndex t;
+  t.name       = name;
+  t.appliedTo  = appliedTo;
+  t.numBins    = labels.size();
+  t.numBatches = t.numBins > 0 ? batchMeans.size() / t.numBins : 0;
+  if( mean.size() != t.numBins || stdErr.size() != t.numBins || batchMeans.size() != t.numBins * t.numBatches ) {
+    std::cout << " tally " << name << " has columns of different lengths, can't write it to " << filename << std::endl;
+    throw;
+  }
+
+  // string offsets relative to the end of the offsets, then the characters
+  t.labelsOffset = out.tellp();
+  uint64_t length = 0;
+  writeWord(0);
+  for(const auto &label : labels) {
+    length += label.size();
+    writeWord(length);
+  }
+  for(const auto &label : labels) {
+    out.write( label.data() , label.size() );
+  }
+  for(uint64_t i = length; i < padded(length); ++i) { out.put(0); }
+
+  t.meanOffset   = writeColumn(mean);
+  t.stdErrOffset = writeColumn(stdErr);
+  t.batchOffset  = writeColumn(batchMeans);
+  index.push_back(t);
+};
+
+void ResultWriter::close() {
+  if( ! out.is_open() ) { return; }
+
+  uint64_t indexOffset = out.tellp();
+  for(const auto &t : index) {
+    writeString( t.name );
+    writeString( t.appliedTo );
+    writeWord( t.numBins );
+    writeWord( t.numBatches );
+    writeWord( t.labelsOffset );
+    writeWord( t.meanOffset );
+    writeWord( t.stdErrOffset );
+    writeWord( t.batchOffset );
+  }
+  uint64_t indexSize = static_cast< uint64_t >( out.tellp() ) - indexOffset;
+
+  out.seekp(0);
+  out.write( magic , 8 );
+  writeWord( version );
+  writeWord( index.size() );
+  writeWord( numHistories );
+  writeWord( numBatches );
+  writeWord( indexOffset );
+  writeWord( indexSize );
+  out.close();
+};
+
+/* ****************************************************************************************************** *
+ * Result Reader
+ *
+ * ****************************************************************************************************** */
+
+ResultReader::ResultReader(string filename) : fd(-1) , data(nullptr) , fileSize(0) {
+  fd = open( filename.c_str() , O_RDONLY );
+  struct stat info;
+  if( fd < 0 || fstat( fd , &info ) != 0 ) {
+    std::cout << " could not open result file " << filename << std::endl;
+    throw;
+  }
+  fileSize = info.st_size;
+  if( fileSize >= headerSize ) {
+    void* map = mmap( nullptr , fileSize , PROT_READ , MAP_PRIVATE , fd , 0 );
+    if( map != MAP_FAILED ) { data = static_cast< const char* >( map ); }
+  }
+  if( ! data || std::memcmp( data , ResultWriter::magic , 8 ) != 0 || word(8) != ResultWriter::version ) {
+    std::cout << " " << filename << " is not a tally result file" << std::endl;
+    throw;
+  }
+
+  uint64_t numTallies  = word(16);
+  numHistories         = word(24);
+  numBatches           = word(32);
+  uint64_t offset      = word(40);
+  for(uint64_t i = 0; i < numTallies; ++i) {
+    TallyIndex t;
+    t.name         = readString(offset);
+    t.appliedTo    = readString(offset);
+    t.numBins      = word(offset);      offset += 8;
+    t.numBatches   = word(offset);      offset += 8;
+    t.labelsOffset = word(offset);      offset += 8;
+    t.meanOffset   = word(offset);      offset += 8;
+    t.stdErrOffset = word(offset);      offset += 8;
+    t.batchOffset  = word(offset);      offset += 8;
+    if( t.meanOffset + 8 * t.numBins > fileSize || t.stdErrOffset + 8 * t.numBins > fileSize ||
+        t.batchOffset + 8 * t.numBins * t.numBatches > fileSize ) {
+      std::cout << " tally " << t.name << " runs past the end of " << filename << std::endl;
+      throw;
+    }
+    tallies.push_back(t);
+  }
+};
+
+ResultReader::~ResultReader() {
+  if( data ) { munmap( const_cast< char* >( data ) , fileSize ); }
+  if( fd >= 0 ) { ::close(fd); }
+};
+
+uint64_t ResultReader::word(uint64_t offset) {
+  if( offset + 8 > fileSize ) {
+    std::cout << " tally result file is truncated" << std::endl;
+    throw;
+  }
+  uint64_t w;
+  std::memcpy( &w , data + offset , 8 );
+  return(w);
+};
+
+string ResultReader::readString(uint64_t &offset) {
+  uint64_t length = word(offset);
+  string   s( data + offset + 8 , length );
+  offset += 8 + padded(length);
+  return(s);
+};
+
+int ResultReader::findTally(string name , string appliedTo) {
+  for(unsigned int t = 0; t < tallies.size(); ++t) {
+    if( tallies[t].name == name && ( appliedTo.empty() || tallies[t].appliedTo == appliedTo ) ) { return(t); }
+  }
+  return(-1);
+};
+
+string ResultReader::getLabel(int t , uint64_t bin) {
+  const TallyIndex &tally = tallies[t];
+  uint64_t chars = tally.labelsOffset + 8 * ( tally.numBins + 1 );
+  uint64_t first = word( tally.labelsOffset + 8 * bin );
+  uint64_t last  = word( tally.labelsOffset + 8 * ( bin + 1 ) );
+  return( string( data + chars + first , last - first ) );
+};
+
+const double* ResultReader::getMean(int t) {
+  return( reinterpret_cast< const double* >( data + tallies[t].meanOffset ) );
+};
+
+const double* ResultReader::getStdErr(int t) {
+  return( reinterpret_cast< const double* >( data + tallies[t].stdErrOffset ) );
+};
+
+const double* ResultReader::getBatchMeans(int t , uint64_t batch) {
+  return( reinterpret_cast< const double* >( data + tallies[t].batchOffset ) + batch * tallies[t].numBins );
+};
+
+void ResultReader::writeCSV(std::ostream &out , int t , bool header) {
+  const TallyIndex &tally = tallies[t];
+  if( header ) {
+    out << "tally,applied_to,bin,label,mean,std_err";
+    for(uint64_t b = 0; b < tally.numBatches; ++b) { out << ",batch_" << b + 1; }
+    out << std::endl;
+  }
+
+  // shortest round trip values, lossless
+  TextWriter    text(out);
+  const double* mean   = getMean(t);
+  const double* stdErr = getStdErr(t);
+  string        prefix = "\"" + tally.name + "\",\"" + tally.appliedTo + "\",";
+  for(uint64_t j = 0; j < tally.numBins; ++j) {
+    text << prefix << j << ",\"" << getLabel( t , j ) << "\"," << mean[j] << ',' << stdErr[j];
+    for(uint64_t b = 0; b < tally.numBatches; ++b) {
+      text << ',' << getBatchMeans( t , b )[j];
+    }
+    text << '\n';
+  }
+};
@@ -0,0 +1,120 @@
+/*
+ * Binary tally result file
+ *
+ * Compact columnar output of every tally in a run. Each tally is stored as contiguous columns: the bin
+ * labels, the mean, the standard error of the mean and the batch history (the mean of every batch, one
+ * column per batch). An index at the end of the file gives the name of each tally and the offsets of its
+ * columns, so a reader maps the file and reads a single tally without touching the rest.
+ *
+ * Layout (little endian, every block padded to 8 bytes):
+ *   header   "HMRTALLY" , version , number of tallies , histories , batches , index offset , index size , 0
+ *   tallies  labels (numBins + 1 uint64 string offsets then the characters) , mean , std error , batches
+ *   index    per tally: name , appliedTo (uint64 length then characters) , numBins , numBatches and the
+ *            offsets of the labels , mean , std error and batch columns
+ *
+ * Only depends on TextWriter and the standard library so the tools can build it on their own.
+ */
+
+#ifndef _RESULTFILE_HEADER_
+#define _RESULTFILE_HEADER_
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TextWriter.h"
+
+using std::vector;
+using std::string;
+
+/* ****************************************************************************************************** *
+ * Result Writer
+ *  tallies are streamed to the file as they are added, the index is written by close()
+ * ****************************************************************************************************** */
+
+// columns of one tally, batchMeans holds one column of labels.size() values per batch
+struct TallyResult {
+  string           name;
+  string           appliedTo;
+  vector< string > labels;
+  vector< double > mean;
+  vector< double > stdErr;
+  vector< double > batchMeans;
+};
+
+struct TallyIndex {
+  string   name;
+  string   appliedTo;
+  uint64_t numBins;
+  uint64_t numBatches;
+  uint64_t labelsOffset;
+  uint64_t meanOffset;
+  uint64_t stdErrOffset;
+  uint64_t batchOffset;  // batch b of bin j at batchOffset + 8 * ( b * numBins + j )
+};
+
+class ResultWriter {
+  private:
+    std::ofstream        out;
+    string               filename;
+    uint64_t             numHistories;
+    uint64_t             numBatches;
+    vector< TallyIndex > index;
+
+    void     writeWord(uint64_t word);
+    void     writeString(const string &s);            // length , characters , padding
+    uint64_t writeColumn(const vector< double > &column);
+
+  public:
+    static const char     magic[9];
+    static const uint64_t version = 1;
+
+    ResultWriter(string filenamein , uint64_t numHistoriesin , uint64_t numBatchesin);
+   ~ResultWriter() { close(); };
+
+    // batchMeans holds numBatches columns of labels.size() values
+    void addTally(const string &name , const string &appliedTo , const vector< string > &labels ,
+                  const vector< double > &mean , const vector< double > &stdErr , const vector< double > &batchMeans);
+    void addTally(const TallyResult &tally) { addTally( tally.name , tally.appliedTo , tally.labels , tally.mean , tally.stdErr , tally.batchMeans ); };
+    void close();
+};
+
+/* ****************************************************************************************************** *
+ * Result Reader
+ *  maps the file, the columns are read in place
+ * ****************************************************************************************************** */
+
+class ResultReader {
+  private:
+    int                  fd;
+    const char*          data;
+    size_t               fileSize;
+    uint64_t             numHistories;
+    uint64_t             numBatches;
+    vector< TallyIndex > tallies;
+
+    uint64_t word(uint64_t offset);
+    string   readString(uint64_t &offset);
+
+  public:
+    ResultReader(string filename);
+   ~ResultReader();
+
+    uint64_t getNumHistories() { return(numHistories);   };
+    uint64_t getNumBatches()   { return(numBatches);     };
+    int      getNumTallies()   { return(tallies.size()); };
+    const TallyIndex& getTally(int t) { return(tallies[t]); };
+    int      findTally(string name , string appliedTo = ""); // first match, any appliedTo if empty, -1 if there is none
+
+    string        getLabel(int t , uint64_t bin);
+    const double* getMean(int t);
+    const double* getStdErr(int t);
+    const double* getBatchMeans(int t , uint64_t batch);
+
+    // bin , label , mean , std error , one column per batch
+    void writeCSV(std::ostream &out , int t , bool header = true);
+};
+
+#endif
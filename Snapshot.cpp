@@ -0,0 +1,104 @@
+/*
+ * Tally snapshots
+ */
+
+#include "Snapshot.h"
+#include "Memory.h"
+#include "Trace.h"
+
+uint64_t Snapshot::memoryUsage() const {
+  uint64_t total = Memory::bytes( tallies ) + Memory::bytes( grids );
+  for( const auto &tally : tallies ) {
+    total += Memory::bytes( tally.labels ) + Memory::bytes( tally.mean ) + Memory::bytes( tally.stdErr ) + Memory::bytes( tally.batchMeans );
+    for( const auto &label : tally.labels ) { total += Memory::bytes( label ); }
+  }
+  for( const auto &grid : grids ) {
+    total += Memory::bytes( grid.cellData );
+    for( const auto &data : grid.cellData ) { total += Memory::bytes( data.second ); }
+  }
+  return( total );
+}
+
+SnapshotWriter::SnapshotWriter(string directoryin , string resultFilenamein) :
+  directory(directoryin) , resultFilename(resultFilenamein) , finished(false) , numWritten(0) , numSkipped(0)
+{
+  thread = std::thread( &SnapshotWriter::run , this );
+};
+
+string SnapshotWriter::snapshotName(string filename , int batch) {
+  char suffix[16];
+  snprintf( suffix , sizeof(suffix) , "_b%04d" , batch );
+  size_t dot = filename.find_last_of('.');
+  if( dot == string::npos ) { return( filename + suffix ); }
+  return( filename.substr( 0 , dot ) + suffix + filename.substr(dot) );
+};
+
+void SnapshotWriter::submit(std::unique_ptr< const Snapshot > snapshot) {
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    if( waiting ) { numSkipped++; }
+    waiting = std::move(snapshot);
+  }
+  wake.notify_one();
+};
+
+void SnapshotWriter::finish() {
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    finished = true;
+  }
+  wake.notify_one();
+  if( thread.joinable() ) { thread.join(); }
+};
+
+void SnapshotWriter::run() {
+  Trace::nameThread( "snapshot writer" );
+  while( true ) {
+    std::unique_ptr< const Snapshot > snapshot;
+    {
+      std::unique_lock< std::mutex > lock(mutex);
+      wake.wait( lock , [this] { return( waiting || finished ); } );
+      if( ! waiting ) { return; }
+      snapshot = std::move(waiting);
+    }
+    // transport fills the next one meanwhile
+    write(*snapshot);
+  }
+};
+
+void SnapshotWriter::write(const Snapshot &snapshot) {
+  TraceScope trace( "write snapshot" , snapshot.batch );
+  {
+    ResultWriter results( directory + snapshotName( resultFilename , snapshot.batch ) , snapshot.numHistories , snapshot.batch );
+    for(const auto &tally : snapshot.tallies) {
+      results.addTally(tally);
+    }
+  }
+
+  for(const auto &grid : snapshot.grids) {
+    string filename = snapshotName( grid.filename , snapshot.batch );
+    VTK::writeUnstructuredGrid( directory + filename , *grid.points , *grid.connectivity , grid.vertsPerCell , grid.cellType , grid.cellData );
+    series[ grid.filename ].push_back( std::make_pair( snapshot.numHistories , filename ) );
+    writeCollection( grid.filename );
+  }
+  numWritten++;
+};
+
+void SnapshotWriter::writeCollection(const string &filename) {
+  // rewritten after every snapshot, renamed into place so ParaView never sees half a file
+  string pvdFilename = directory + filename.substr( 0 , filename.find_last_of('.') ) + ".pvd";
+  string tmpFilename = pvdFilename + ".tmp";
+
+  std::ofstream pvd;
+  pvd.open( tmpFilename );
+  pvd << "<?xml version=\"1.0\"?>" << std::endl;
+  pvd << "<VTKFile type=\"Collection\" version=\"0.1\">" << std::endl;
+  pvd << "  <Collection>" << std::endl;
+  for(const auto &entry : series[filename]) {
+    pvd << "    <DataSet timestep=\"" << entry.first << "\" part=\"0\" file=\"" << entry.second << "\"/>" << std::endl;
+  }
+  pvd << "  </Collection>" << std::endl;
+  pvd << "</VTKFile>" << std::endl;
+  pvd.close();
+  std::rename( tmpFilename.c_str() , pvdFilename.c_str() );
+};
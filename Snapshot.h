@@ -0,0 +1,96 @@
+/*
+ * Tally snapshots
+ *
+ * Output while transport runs. At a batch boundary Transport copies the tally results (means, errors and
+ * batch means, not the Estimators) into a Snapshot and hands it to the SnapshotWriter, whose thread writes
+ * it as a binary result file and the structured mesh VTK files while the next batch runs.
+ *
+ * The writer double buffers: one snapshot being written and at most one waiting. If transport gets ahead
+ * of the disk the waiting snapshot is replaced by the newer one, so transport never waits for output.
+ *
+ * Every VTK grid also gets a .pvd collection of its snapshots, by history count, so ParaView can step
+ * through them to watch the tallies converge.
+ */
+
+#ifndef _SNAPSHOT_HEADER_
+#define _SNAPSHOT_HEADER_
+
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Memory.h"
+#include "ResultFile.h"
+#include "VTKWriter.h"
+
+using std::vector;
+using std::string;
+
+// cell data of one grid, the points and connectivity don't change from snapshot to snapshot
+struct GridSnapshot {
+  string                                    filename;   // of the final output, snapshots add _b<batch>
+  std::shared_ptr< const vector< double > > points;
+  std::shared_ptr< const vector< double > > connectivity;
+  int                                       vertsPerCell;
+  int                                       cellType;
+  vector< VTK::CellData >                   cellData;
+};
+
+struct Snapshot {
+  int                    batch;        // batches completed
+  unsigned long long     numHistories; // histories completed
+  vector< TallyResult >  tallies;
+  vector< GridSnapshot > grids;
+  std::unique_ptr< Memory::Buffer > accounted; // counted as an output buffer until written
+
+  uint64_t memoryUsage() const; // of the copied results, not the shared points and connectivity
+};
+
+/* ****************************************************************************************************** *
+ * Snapshot Writer
+ *  files are written to directory as name_b<batch>.ext
+ * ****************************************************************************************************** */
+
+class SnapshotWriter {
+  private:
+    string                              directory;
+    string                              resultFilename;
+    std::thread                         thread;
+    std::mutex                          mutex;
+    std::condition_variable             wake;
+    std::unique_ptr< const Snapshot >   waiting;
+    bool                                finished;
+    int                                 numWritten;
+    int                                 numSkipped;
+
+    // ( histories , snapshot file ) of every snapshot of each grid, for its .pvd
+    std::map< string , vector< std::pair< unsigned long long , string > > > series;
+
+    void run();
+    void write(const Snapshot &snapshot);
+    void writeCollection(const string &filename);
+
+  public:
+    SnapshotWriter(string directoryin , string resultFilenamein);
+   ~SnapshotWriter() { finish(); };
+
+    // hand a snapshot over, returns without waiting for the disk
+    void submit(std::unique_ptr< const Snapshot > snapshot);
+
+    // write the waiting snapshot, if any, and stop the thread
+    void finish();
+
+    int getNumWritten() { return(numWritten); };
+    int getNumSkipped() { return(numSkipped); };
+
+    // filename with _b<batch> before the extension
+    static string snapshotName(string filename , int batch);
+};
+
+#endif
@@ -0,0 +1,391 @@
+/*
+ * Structured mesh tallies
+ *
+ * Rectilinear x/y/z and cylindrical r/z/theta grids laid over the problem, independent of the cells
+ * and of the tet mesh.
+ */
+
+#include "StructuredMesh.h"
+#include "Memory.h"
+
+/* ****************************************************************************************************** *
+ * Cartesian Grid
+ *
+ * ****************************************************************************************************** */
+
+CartesianGrid::CartesianGrid(double xmin , double xmax , int nx , double ymin , double ymax , int ny , double zmin , double zmax , int nz) {
+  lo[0] = xmin;  width[0] = ( xmax - xmin ) / nx;  n[0] = nx;
+  lo[1] = ymin;  width[1] = ( ymax - ymin ) / ny;  n[1] = ny;
+  lo[2] = zmin;  width[2] = ( zmax - zmin ) / nz;  n[2] = nz;
+};
+
+int CartesianGrid::getIndex(point p) {
+  double pos[3] = { p.x , p.y , p.z };
+  int    idx[3];
+  for(int a = 0; a < 3; ++a) {
+    idx[a] = std::floor( ( pos[a] - lo[a] ) / width[a] );
+    if( idx[a] < 0 || idx[a] >= n[a] ) { return(-1); }
+  }
+  return( idx[0] + n[0] * ( idx[1] + n[1] * idx[2] ) );
+};
+
+void CartesianGrid::getSegments(point start , point dir , double length , vector< Segment > &segments) {
+  segments.clear();
+
+  double s[3] = { start.x , start.y , start.z };
+  double d[3] = { dir.x   , dir.y   , dir.z   };
+
+  // clip the track to the grid one slab at a time
+  double tEnter = 0.0;
+  double tExit  = length;
+  for(int a = 0; a < 3; ++a) {
+    double hi = lo[a] + n[a] * width[a];
+    if( d[a] == 0.0 ) {
+      if( s[a] < lo[a] || s[a] >= hi ) { return; }
+    }
+    else {
+      double t1 = ( lo[a] - s[a] ) / d[a];
+      double t2 = ( hi    - s[a] ) / d[a];
+      tEnter = std::fmax( tEnter , std::fmin( t1 , t2 ) );
+      tExit  = std::fmin( tExit  , std::fmax( t1 , t2 ) );
+    }
+  }
+  if( tEnter >= tExit ) { return; }
+
+  // entry cell, a point on a plane moving down belongs to the cell below it
+  int    idx[3] , step[3];
+  double tMax[3] , tDelta[3];
+  for(int a = 0; a < 3; ++a) {
+    double c = ( s[a] + tEnter * d[a] - lo[a] ) / width[a];
+    idx[a] = std::floor( c );
+    if( d[a] < 0.0 && c == idx[a] ) { idx[a]--; }
+    idx[a] = std::min( std::max( idx[a] , 0 ) , n[a] - 1 );
+
+    if( d[a] > 0.0 ) {
+      step[a]   = 1;
+      tMax[a]   = ( lo[a] + ( idx[a] + 1 ) * width[a] - s[a] ) / d[a];
+      tDelta[a] = width[a] / d[a];
+    }
+    else if( d[a] < 0.0 ) {
+      step[a]   = -1;
+      tMax[a]   = ( lo[a] + idx[a] * width[a] - s[a] ) / d[a];
+      tDelta[a] = -width[a] / d[a];
+    }
+    else {
+      step[a]   = 0;
+      tMax[a]   = std::numeric_limits<double>::max();
+      tDelta[a] = std::numeric_limits<double>::max();
+    }
+  }
+
+  // step into whichever neighbor's plane is crossed first
+  double t = tEnter;
+  while( t < tExit ) {
+    int a = 0;
+    if( tMax[1] < tMax[a] ) { a = 1; }
+    if( tMax[2] < tMax[a] ) { a = 2; }
+
+    double tNext = std::fmin( tMax[a] , tExit );
+    if( tNext > t ) {
+      segments.push_back( std::make_pair( idx[0] + n[0] * ( idx[1] + n[1] * idx[2] ) , tNext - t ) );
+    }
+    t = tNext;
+
+    idx[a] += step[a];
+    if( idx[a] < 0 || idx[a] >= n[a] ) { break; }
+    tMax[a] += tDelta[a];
+  }
+};
+
+void CartesianGrid::getHexahedra(vector< double > &points) {
+  for(int k = 0; k < n[2]; ++k) {
+    for(int j = 0; j < n[1]; ++j) {
+      for(int i = 0; i < n[0]; ++i) {
+        double x[2] = { lo[0] + i * width[0] , lo[0] + ( i + 1 ) * width[0] };
+        double y[2] = { lo[1] + j * width[1] , lo[1] + ( j + 1 ) * width[1] };
+        double z[2] = { lo[2] + k * width[2] , lo[2] + ( k + 1 ) * width[2] };
+        for(int c = 0; c < 2; ++c) {
+          points.insert( points.end() , { x[0] , y[0] , z[c] , x[1] , y[0] , z[c] , x[1] , y[1] , z[c] , x[0] , y[1] , z[c] } );
+        }
+      }
+    }
+  }
+};
+
+/* ****************************************************************************************************** *
+ * Cylindrical Grid
+ *
+ * ****************************************************************************************************** */
+
+CylindricalGrid::CylindricalGrid(double x0i , double y0i , double rmax , int nri , double zmini , double zmax , int nzi , int nti):
+  x0(x0i) , y0(y0i) , dr( rmax / nri ) , zmin(zmini) , dz( ( zmax - zmini ) / nzi ) , dt( 2.0 * M_PI / nti ) , nr(nri) , nz(nzi) , nt(nti) {};
+
+int CylindricalGrid::getIndex(point p) {
+  double u = p.x - x0;
+  double v = p.y - y0;
+  int ir = std::floor( std::sqrt( u*u + v*v ) / dr );
+  int iz = std::floor( ( p.z - zmin ) / dz );
+  if( ir >= nr || iz < 0 || iz >= nz ) { return(-1); }
+
+  double theta = std::atan2( v , u );
+  if( theta < 0.0 ) { theta += 2.0 * M_PI; }
+  int it = std::min( static_cast<int>( theta / dt ) , nt - 1 );
+
+  return( ir + nr * ( iz + nz * it ) );
+};
+
+double CylindricalGrid::getVolume(int cell) {
+  int ir = cell % nr;
+  return( 0.5 * ( std::pow( ( ir + 1 ) * dr , 2 ) - std::pow( ir * dr , 2 ) ) * dt * dz );
+};
+
+// smallest root of a s^2 + b s + c beyond tol, max double if none
+static double smallestRoot(double a , double b , double c , double tol) {
+  double disc = b*b - 4.0*a*c;
+  if( a == 0.0 || disc < 0.0 ) { return( std::numeric_limits<double>::max() ); }
+  double s1 = ( -b - std::sqrt(disc) ) / ( 2.0 * a );
+  double s2 = ( -b + std::sqrt(disc) ) / ( 2.0 * a );
+  if( s1 > tol ) { return(s1); }
+  if( s2 > tol ) { return(s2); }
+  return( std::numeric_limits<double>::max() );
+}
+
+double CylindricalGrid::nextBoundary(point q , point dir , int ir , int iz , int it , double tol) {
+  double u = q.x - x0;
+  double v = q.y - y0;
+  double next = std::numeric_limits<double>::max();
+
+  // inner and outer radius of the shell
+  double a = dir.x*dir.x + dir.y*dir.y;
+  double b = 2.0 * ( u*dir.x + v*dir.y );
+  double c = u*u + v*v;
+  if( ir > 0 ) { next = std::fmin( next , smallestRoot( a , b , c - std::pow( ir * dr , 2 ) , tol ) ); }
+  next = std::fmin( next , smallestRoot( a , b , c - std::pow( ( ir + 1 ) * dr , 2 ) , tol ) );
+
+  // z planes
+  if( dir.z > 0.0 ) { next = std::fmin( next , ( zmin + ( iz + 1 ) * dz - q.z ) / dir.z ); }
+  if( dir.z < 0.0 ) { next = std::fmin( next , ( zmin +   iz       * dz - q.z ) / dir.z ); }
+
+  // theta half planes, only the half on the phi side of the axis is a boundary
+  if( nt > 1 ) {
+    for(int e = 0; e < 2; ++e) {
+      double phi   = ( it + e ) * dt;
+      double denom = -std::sin(phi) * dir.x + std::cos(phi) * dir.y;
+      if( denom == 0.0 ) { continue; }
+      double s = -( -std::sin(phi) * u + std::cos(phi) * v ) / denom;
+      if( s > tol && std::cos(phi) * ( u + s*dir.x ) + std::sin(phi) * ( v + s*dir.y ) > 0.0 ) {
+        next = std::fmin( next , s );
+      }
+    }
+  }
+  return(next);
+};
+
+void CylindricalGrid::getSegments(point start , point dir , double length , vector< Segment > &segments) {
+  segments.clear();
+
+  double rmax = nr * dr;
+  double zmax = zmin + nz * dz;
+  double u    = start.x - x0;
+  double v    = start.y - y0;
+
+  // clip the track to the outer cylinder and the z slab
+  double tEnter = 0.0;
+  double tExit  = length;
+  double a = dir.x*dir.x + dir.y*dir.y;
+  double b = 2.0 * ( u*dir.x + v*dir.y );
+  double c = u*u + v*v - rmax*rmax;
+  if( a == 0.0 ) {
+    if( c > 0.0 ) { return; }
+  }
+  else {
+    double disc = b*b - 4.0*a*c;
+    if( disc < 0.0 ) { return; }
+    tEnter = std::fmax( tEnter , ( -b - std::sqrt(disc) ) / ( 2.0 * a ) );
+    tExit  = std::fmin( tExit  , ( -b + std::sqrt(disc) ) / ( 2.0 * a ) );
+  }
+  if( dir.z == 0.0 ) {
+    if( start.z < zmin || start.z >= zmax ) { return; }
+  }
+  else {
+    double t1 = ( zmin - start.z ) / dir.z;
+    double t2 = ( zmax - start.z ) / dir.z;
+    tEnter = std::fmax( tEnter , std::fmin( t1 , t2 ) );
+    tExit  = std::fmin( tExit  , std::fmax( t1 , t2 ) );
+  }
+  if( tEnter >= tExit ) { return; }
+
+  // step from boundary to boundary of the grid cell just ahead, each segment is binned at its midpoint
+  // so round off at a boundary can't put it in the wrong cell
+  double tol = 1.0e-9 * std::fmax( dr , dz );
+  double t   = tEnter;
+  int    maxSteps = 2 * nr + nz + nt + 8; // a line crosses each shell at most twice and each plane once
+  for(int step = 0; step < maxSteps && t < tExit; ++step) {
+    double tAhead = std::fmin( t + tol , 0.5 * ( t + tExit ) );
+    int    cell   = getIndex( point( start.x + tAhead*dir.x , start.y + tAhead*dir.y , start.z + tAhead*dir.z ) );
+    double tNext  = tExit;
+    if( cell >= 0 ) {
+      point q( start.x + t*dir.x , start.y + t*dir.y , start.z + t*dir.z );
+      tNext = std::fmin( tExit , t + nextBoundary( q , dir , cell % nr , ( cell / nr ) % nz , cell / ( nr * nz ) , tol ) );
+    }
+
+    double tMid = 0.5 * ( t + tNext );
+    cell = getIndex( point( start.x + tMid*dir.x , start.y + tMid*dir.y , start.z + tMid*dir.z ) );
+    if( cell >= 0 ) {
+      segments.push_back( std::make_pair( cell , tNext - t ) );
+    }
+    t = tNext;
+  }
+};
+
+void CylindricalGrid::getHexahedra(vector< double > &points) {
+  for(int it = 0; it < nt; ++it) {
+    for(int iz = 0; iz < nz; ++iz) {
+      for(int ir = 0; ir < nr; ++ir) {
+        double r[2] = { ir * dr , ( ir + 1 ) * dr };
+        double t[2] = { it * dt , ( it + 1 ) * dt };
+        double z[2] = { zmin + iz * dz , zmin + ( iz + 1 ) * dz };
+        for(int c = 0; c < 2; ++c) {
+          points.insert( points.end() , { x0 + r[0] * std::cos(t[0]) , y0 + r[0] * std::sin(t[0]) , z[c] ,
+                                          x0 + r[1] * std::cos(t[0]) , y0 + r[1] * std::sin(t[0]) , z[c] ,
+                                          x0 + r[1] * std::cos(t[1]) , y0 + r[1] * std::sin(t[1]) , z[c] ,
+                                          x0 + r[0] * std::cos(t[1]) , y0 + r[0] * std::sin(t[1]) , z[c] } );
+        }
+      }
+    }
+  }
+};
+
+/* ****************************************************************************************************** *
+ * Structured Mesh Estimator Collection
+ *
+ * ****************************************************************************************************** */
+
+StructuredMeshEstimatorCollection::StructuredMeshEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , std::shared_ptr< StructuredGrid > gridin):
+  EstimatorCollection(label , attributesin) , grid(gridin) , vtkFilename(label + ".vtu")
+{
+  allocate();
+};
+
+void StructuredMeshEstimatorCollection::allocate() {
+  // one row of responses per ( grid cell , bin )
+  estimators.clear();
+  for(unsigned long i = 0; i < (unsigned long)grid->getNumCells() * size * responses.size(); ++i) {
+    estimators.push_back( std::make_shared<Estimator>() );
+  }
+};
+
+void StructuredMeshEstimatorCollection::setResponses(vector< string > names) {
+  EstimatorCollection::setResponses(names);
+  allocate();
+};
+
+void StructuredMeshEstimatorCollection::scoreCell(int cell , int bin , const double* xs , double flux) {
+  int n   = responses.size();
+  int row = cell * size + bin;
+
+  // remember the row so only the scored estimators need to end the history
+  bool fresh = true;
+  for(int r = 0; r < n; ++r) {
+    fresh = fresh && estimators[ row * n + r ]->getCurrentHistTally() == 0.0;
+  }
+  if( fresh ) { touched.push_back(row); }
+
+  scoreRow(row , xs , flux);
+};
+
+string StructuredMeshEstimatorCollection::getBinLabel(int j) {
+  int    n     = responses.size();
+  int    row   = j / n;
+  string label = "cell " + std::to_string( row / size ) + " bin " + std::to_string( row % size );
+  return( n == 1 ? label : label + " " + responses[j % n] );
+};
+
+void StructuredMeshEstimatorCollection::endHist() {
+  int n = responses.size();
+  for(int row : touched) {
+    for(int r = 0; r < n; ++r) {
+      estimators[ row * n + r ]->endHist();
+    }
+  }
+  touched.clear();
+};
+
+void StructuredMeshEstimatorCollection::writeToVTK(unsigned long long nHist) {
+  std::cout << "Writing structured mesh tally " << estimatorName << " to " << "outfiles/" << vtkFilename << "..." << std::endl;
+  VTK::writeUnstructuredGrid( "outfiles/" + vtkFilename , *getVTKPoints() , *getVTKConnectivity() , 8 , VTK::hexahedron , getCellData(nHist) );
+};
+
+std::shared_ptr< const vector< double > > StructuredMeshEstimatorCollection::getVTKPoints() {
+  if( ! vtkPoints ) {
+    auto points = std::make_shared< vector< double > >();
+    grid->getHexahedra(*points);
+    vtkPoints = points;
+  }
+  return(vtkPoints);
+};
+
+std::shared_ptr< const vector< double > > StructuredMeshEstimatorCollection::getVTKConnectivity() {
+  if( ! vtkConnectivity ) {
+    auto connectivity = std::make_shared< vector< double > >();
+    for(int i = 0; i < 8 * grid->getNumCells(); ++i) {
+      connectivity->push_back(i);
+    }
+    vtkConnectivity = connectivity;
+  }
+  return(vtkConnectivity);
+};
+
+vector< VTK::CellData > StructuredMeshEstimatorCollection::getCellData(unsigned long long nHist) {
+  int numCells = grid->getNumCells();
+  int n        = responses.size();
+
+  vector< VTK::CellData > cellData;
+  for(int bin = 0; bin < size; ++bin) {
+    for(int r = 0; r < n; ++r) {
+      string label = estimatorName + ( size > 1 ? " bin " + std::to_string(bin) : "" ) + " " + responses[r];
+      vector< double > mean , relErr;
+      for(int cell = 0; cell < numCells; ++cell) {
+        Estimator_ptr est = estimators[ ( cell * size + bin ) * n + r ];
+        mean.push_back( est->getScalarEstimator(nHist).first );
+        relErr.push_back( est->getRelativeError(nHist) );
+      }
+      cellData.push_back( std::make_pair( label + " mean" , std::move(mean) ) );
+      cellData.push_back( std::make_pair( label + " R" , std::move(relErr) ) );
+    }
+  }
+  vector< double > volume;
+  for(int cell = 0; cell < numCells; ++cell) {
+    volume.push_back( grid->getVolume(cell) );
+  }
+  cellData.push_back( std::make_pair( "volume" , std::move(volume) ) );
+  return(cellData);
+};
+
+void StructuredMeshCollisionEstimatorCollection::scoreCollision(Part_ptr p , const double* xs) {
+  int bin = getLinearIndex(p);
+  if( bin < 0 ) { return; }
+
+  // O(1), the grid cell follows from the position
+  int cell = grid->getIndex( p->getPos() );
+  if( cell < 0 ) { return; }
+
+  scoreCell(cell , bin , xs , 1.0 / xs[0]);
+};
+
+void StructuredMeshTrackLengthEstimatorCollection::scoreTrack(Part_ptr p , const double* xs , double length) {
+  int bin = getLinearIndex(p);
+  if( bin < 0 ) { return; }
+
+  grid->getSegments( p->getPos() , p->getDir() , length , segments );
+  for(auto segment : segments) {
+    scoreCell(segment.first , bin , xs , segment.second);
+  }
+};
+
+uint64_t StructuredMeshEstimatorCollection::memoryUsage() {
+  uint64_t total = EstimatorCollection::memoryUsage() + Memory::bytes( touched );
+  if( vtkPoints )       { total += Memory::bytes( *vtkPoints ); }
+  if( vtkConnectivity ) { total += Memory::bytes( *vtkConnectivity ); }
+  return(total);
+}
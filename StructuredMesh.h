@@ -0,0 +1,147 @@
+/*
+ * Structured mesh tallies
+ *
+ * Rectilinear x/y/z and cylindrical r/z/theta grids laid over the problem, independent of the cells
+ * and of the tet mesh. A point is binned arithmetically and a track is split into per grid cell
+ * segments by stepping from boundary to boundary (3D DDA), so neither needs a search over the mesh.
+ *
+ * Like the cell tallies, the results are volume integrated, the cell volumes are written with them.
+ */
+
+#ifndef _STRUCTUREDMESH_HEADER_
+#define _STRUCTUREDMESH_HEADER_
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "Point.h"
+#include "EstimatorCollection.h"
+#include "VTKWriter.h"
+
+typedef std::pair< int , double > Segment; // ( grid cell , track length in it )
+
+/* ****************************************************************************************************** *
+ * Structured Grid
+ *  grid cells are numbered with the first coordinate fastest
+ * ****************************************************************************************************** */
+
+class StructuredGrid {
+  public:
+    virtual ~StructuredGrid() {};
+
+    virtual int    getNumCells()          = 0;
+    virtual int    getIndex(point p)      = 0; // grid cell containing p, -1 if outside
+    virtual double getVolume(int cell)    = 0;
+
+    // split the track start + t * dir , 0 < t < length into the grid cells it crosses, outside parts dropped
+    virtual void getSegments(point start , point dir , double length , vector< Segment > &segments) = 0;
+
+    // 8 corners of every grid cell in VTK hexahedron order, appended as x y z triplets
+    virtual void getHexahedra(vector< double > &points) = 0;
+};
+
+class CartesianGrid : public StructuredGrid {
+  private:
+    double lo[3];    // lower x y z of the grid
+    double width[3]; // cell width in x y z
+    int    n[3];     // number of cells in x y z
+
+  public:
+    CartesianGrid(double xmin , double xmax , int nx , double ymin , double ymax , int ny , double zmin , double zmax , int nz);
+   ~CartesianGrid() {};
+
+    int    getNumCells()       { return( n[0] * n[1] * n[2] ); };
+    int    getIndex(point p);
+    double getVolume(int)      { return( width[0] * width[1] * width[2] ); };
+    void   getSegments(point start , point dir , double length , vector< Segment > &segments);
+    void   getHexahedra(vector< double > &points);
+};
+
+class CylindricalGrid : public StructuredGrid {
+  private:
+    // axis parallel to z through ( x0 , y0 ), theta measured counter clockwise from +x
+    double x0 , y0;
+    double dr , zmin , dz , dt;
+    int    nr , nz , nt;
+
+    // distance along dir from q to the next boundary of grid cell ( ir , iz , it ), beyond tol
+    double nextBoundary(point q , point dir , int ir , int iz , int it , double tol);
+
+  public:
+    CylindricalGrid(double x0i , double y0i , double rmax , int nri , double zmini , double zmax , int nzi , int nti);
+   ~CylindricalGrid() {};
+
+    int    getNumCells()       { return( nr * nz * nt ); };
+    int    getIndex(point p);
+    double getVolume(int cell);
+    void   getSegments(point start , point dir , double length , vector< Segment > &segments);
+    void   getHexahedra(vector< double > &points);
+};
+
+/* ****************************************************************************************************** *
+ * Structured Mesh Estimator Collection
+ *  one row of responses per ( grid cell , particle attribute bin ), only the rows scored during a
+ *  history are ended. Scoring functions wrapped by scoreCollision and scoreTrack
+ * ****************************************************************************************************** */
+
+class StructuredMeshEstimatorCollection : public EstimatorCollection {
+  protected:
+    std::shared_ptr< StructuredGrid > grid;
+    vector< int >                     touched;     // rows scored during the current history
+    string                            vtkFilename;
+    std::shared_ptr< const vector< double > > vtkPoints , vtkConnectivity; // built on first use
+
+    void allocate();
+    void scoreCell(int cell , int bin , const double* xs , double flux);
+
+  public:
+    StructuredMeshEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , std::shared_ptr< StructuredGrid > gridin);
+   ~StructuredMeshEstimatorCollection() {};
+
+    void scoreSurfaceCurrent(Part_ptr)         {};
+    void scoreSurfaceFluence(Part_ptr , point) {};
+    virtual void scoreTrack(Part_ptr p , const double* xs , double length) = 0; // p at the start of the track
+
+    void   setResponses(vector< string > names);
+    string getBinLabel(int j);
+    void   endHist();
+
+    // every bin and response as a mean and relative error array on the grid
+    void   setVTKFilename(string filename) { vtkFilename = filename; };
+    string getVTKFilename() { return(vtkFilename); };
+    void   writeToVTK(unsigned long long nHist);
+
+    // the pieces of the VTK file, the grid hexahedra don't change and are shared with tally snapshots
+    std::shared_ptr< const vector< double > > getVTKPoints();
+    std::shared_ptr< const vector< double > > getVTKConnectivity();
+    vector< VTK::CellData >                   getCellData(unsigned long long nHist); // mean , R , volume
+    void writeOutput(unsigned long long nHist) { writeToVTK(nHist); };
+
+    uint64_t memoryUsage(); // with the VTK points and connectivity once built
+};
+
+class StructuredMeshCollisionEstimatorCollection : public StructuredMeshEstimatorCollection {
+  public:
+    StructuredMeshCollisionEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , std::shared_ptr< StructuredGrid > gridin):
+      StructuredMeshEstimatorCollection(label , attributesin , gridin) {};
+   ~StructuredMeshCollisionEstimatorCollection() {};
+
+    void scoreCollision(Part_ptr p , const double* xs); // tally response / total cross section
+    void scoreTrack(Part_ptr , const double* , double) {};
+};
+
+class StructuredMeshTrackLengthEstimatorCollection : public StructuredMeshEstimatorCollection {
+  private:
+    vector< Segment > segments; // reused from track to track
+  public:
+    StructuredMeshTrackLengthEstimatorCollection(string label , std::map< string , Bin_ptr > attributesin , std::shared_ptr< StructuredGrid > gridin):
+      StructuredMeshEstimatorCollection(label , attributesin , gridin) {};
+   ~StructuredMeshTrackLengthEstimatorCollection() {};
+
+    void scoreCollision(Part_ptr , const double*) {};
+    void scoreTrack(Part_ptr p , const double* xs , double length); // tally response * track length
+};
+
+#endif
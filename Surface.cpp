@@ -2,12 +2,19 @@
 #include <limits>
 
 #include "Surface.h"
+#include "Memory.h"
 
-void surface::scoreTally(Part_ptr p , double xs) {
-  // for each EstimatorCollection
-    // for each attribute
-      // get the index of the Estimator to score
-      // score the estimator
+uint64_t surface::memoryUsage() {
+  return( Memory::shared< surface >() + Memory::bytes( surface_name ) + Memory::bytes( estimators ) );
+}
+
+void surface::scoreTally(Part_ptr p , point normal) {
+  // called at the crossing point with the normal of this surface
+  // each EstimatorCollection only responds to the wrapper for its own type
+  for(auto est : estimators) {
+    est->scoreSurfaceCurrent(p);
+    est->scoreSurfaceFluence(p , normal);
+  }
 };
 
 void surface::endTallyHist() {
@@ -16,6 +23,28 @@ void surface::endTallyHist() {
     }
 };
 
+point surface::getNormal( point p ) {
+  point grad = gradient(p);
+  double norm = std::sqrt(grad * grad);
+
+  // eval / |gradient| is the (first order) distance from the surface, so the
+  // check doesn't depend on how the surface equation happens to be scaled
+  if( norm > 0.0 && std::fabs( eval(p) ) <= onSurfaceTol * norm ) {
+    return( grad / norm );
+  }
+  else {
+    // if the point is not on the surface, return a null vector
+    // client must check for this condition
+    point null(0 , 0 , 0);
+    return(null);
+  }
+}
+
+point surface::crossingNormal( point p ) {
+  point grad = gradient(p);
+  return( grad / std::sqrt(grad * grad) );
+}
+
 double plane::eval( point p ) {
     return a * p.x  +  b * p.y  +  c * p.z  - d;
 }
@@ -28,17 +57,9 @@ double plane::distance( point p, point u ) {
     
 }
 
-point plane::getNormal(point pt){
-  if(eval(pt) == 0) {
-    point normal(a , b , c);
-    return( normal / std::sqrt(normal * normal) );
-  }
-  else {
-    // if the point is not on the surface, return a null vector
-    // client must check for this condition
-    point p(0 , 0 ,0);
-    return(p);
-  }
+point plane::gradient( point ) {
+  point normal(a , b , c);
+  return(normal);
 }
 
 double sphere::eval( point p ) {
@@ -55,21 +76,10 @@ double sphere::distance( point p, point u ) {
     return Utility::quadSolve( 1.0, b, c );   
 }
 
-point sphere::getNormal(point pt){
-  // check if the crossing point is on the surface
-  if(eval(pt) == 0) {
-    // make a point at the center of the sphere
-    point center(x0 , y0 , z0);
-    // make an outward facing surface normal ray from the center to the edge
-    ray normal(pt , center - pt);
-    return(normal.dir);
-  }
-  else {
-    // if the point is not on the surface, return a null vector
-    // client must check for this condition
-    point p(0 , 0 ,0);
-    return(p);
-  }
+point sphere::gradient( point pt ) {
+  // outward facing ray from the center to the point
+  point normal( 2.0*(pt.x - x0), 2.0*(pt.y - y0), 2.0*(pt.z - z0) );
+  return(normal);
 }
 
 //Requires: a valid cylinder
@@ -156,61 +166,25 @@ double zCylinder::distance (point p, point u ) {
 
 
 //Requires: a valid cylinder
-//Effects: returns the normal vector of the surface at the point or nullptr if
-//point fails to be on the surface
-point  xCylinder::getNormal( point p ) {
-  // check if the crossing point is on the surface
-  if(Utility::FloatZero(eval(p))) {
-    // the gradient vector of the cylinder, general for all orientations
-    point normal( 0, 2.0*(p.y - y0), 2.0*(p.z - z0) );
-
-    // return the unit normal vector
-    return( normal / std::sqrt(normal * normal) );
-  }
-  else {
-    // if the point is not on the surface, return a null vector
-    // client must check for this condition
-    point p(0 , 0 ,0);
-    return(p);
-  }
+//Effects: returns the (unnormalized) gradient vector of the cylinder at the point
+point  xCylinder::gradient( point p ) {
+  // the gradient vector of the cylinder, general for all orientations
+  point normal( 0, 2.0*(p.y - y0), 2.0*(p.z - z0) );
+  return(normal);
 }
 
 //Requires: a valid cylinder
-//Effects: returns the normal vector of the surface at the point or nullptr if
-//point fails to be on the surface
-point  yCylinder::getNormal( point p ) {
-  // check if the crossing point is on the surface
-  if(Utility::FloatZero(eval(p))) {
-    // the gradient vector of the cylinder, general for all orientations
-    point normal( 2.0*(p.x - x0), 0, 2.0*(p.z - z0) );
-
-    // return the unit normal vector
-    return( normal / std::sqrt(normal * normal) );
-  }
-  else {
-    // if the point is not on the surface, return a null vector
-    // client must check for this condition
-    point p(0 , 0 ,0);
-    return(p);
-  }
+//Effects: returns the (unnormalized) gradient vector of the cylinder at the point
+point  yCylinder::gradient( point p ) {
+  // the gradient vector of the cylinder, general for all orientations
+  point normal( 2.0*(p.x - x0), 0, 2.0*(p.z - z0) );
+  return(normal);
 }
 
 //Requires: a valid cylinder
-//Effects: returns the normal vector of the surface at the point or nullptr if
-//point fails to be on the surface
-point  zCylinder::getNormal( point p ) {
-  // check if the crossing point is on the surface
-  if(Utility::FloatZero(eval(p))) {
-    // the gradient vector of the cylinder, general for all orientations
-    point normal( 2.0*(p.x - x0), 2.0*(p.y - y0), 0 );
-
-    // return the unit normal vector
-    return( normal / std::sqrt(normal * normal) );
-  }
-  else {
-    // if the point is not on the surface, return a null vector
-    // client must check for this condition
-    point p(0 , 0 ,0);
-    return(p);
-  }
+//Effects: returns the (unnormalized) gradient vector of the cylinder at the point
+point  zCylinder::gradient( point p ) {
+  // the gradient vector of the cylinder, general for all orientations
+  point normal( 2.0*(p.x - x0), 2.0*(p.y - y0), 0 );
+  return(normal);
 }
\ No newline at end of file
@@ -11,6 +11,10 @@ typedef std::shared_ptr<EstimatorCollection> EstCol_ptr;
 
 class surface {
 private:
+    // distance (cm) from the surface within which a point counts as on it
+    static constexpr double onSurfaceTol = 1.0e-9;
+
+
     std::string surface_name;
     
     // EstimatorCollections
@@ -24,17 +28,24 @@ public:
     // Estimator sets/gets
     void addEstimator( EstCol_ptr newEstimator) { estimators.push_back( newEstimator ); };
     std::vector< EstCol_ptr > getEstimators() { return estimators; };
+    bool hasEstimators() { return ! estimators.empty(); };
     
     virtual std::string name() { return surface_name; };
+    uint64_t memoryUsage(); // bytes, of the base class, the surfaces only add a few doubles
     
-    // returns a normal vector given a point on the surface
-    // and a crossing direction
-    virtual point  getNormal(point p)           = 0;
+    // returns the outward unit normal at a point on the surface, or a null vector
+    // if the point is further than onSurfaceTol from the surface
+    point getNormal( point p );
+    // returns the outward unit normal at a point already known to be on the surface,
+    // e.g. the crossing point found by distance(), without checking
+    point crossingNormal( point p );
+
+    virtual point  gradient( point p )          = 0; // gradient of eval(), points outward
     virtual double eval( point p )              = 0;
     virtual double distance( point p, point u ) = 0;
     
     // Estimator interface
-    void scoreTally(Part_ptr p , double xs); 
+    void scoreTally( Part_ptr p , point normal ); 
     void endTallyHist();
     // TODO get Tally output
 };
@@ -46,7 +57,7 @@ public:
     plane( std::string label, double p1, double p2, double p3, double p4 ) : surface(label), a(p1), b(p2), c(p3), d(p4) {};
     ~plane() {};
     
-    point  getNormal(point p);
+    point  gradient( point p );
     double eval( point p );
     double distance( point p, point u );
 };
@@ -58,7 +69,7 @@ public:
     sphere( std::string label, double p1, double p2, double p3, double p4 ) : surface(label), x0(p1), y0(p2), z0(p3), rad(p4) {};
     ~sphere() {};
     
-    point  getNormal(point p);
+    point  gradient( point p );
     double eval( point p );
     double distance( point p, point u );
 };
@@ -74,7 +85,7 @@ public:
     };
     ~xCylinder() {};
 
-    point  getNormal(point p);
+    point  gradient( point p );
     double eval( point p );
     double distance( point p, point u );
 };
@@ -89,7 +100,7 @@ public:
     };
     ~yCylinder() {};
 
-    point  getNormal(point p);
+    point  gradient( point p );
     double eval( point p );
     double distance( point p, point u );
 };
@@ -104,7 +115,7 @@ public:
     };
     ~zCylinder() {};
 
-    point  getNormal(point p);
+    point  gradient( point p );
     double eval( point p );
     double distance( point p, point u );
 };
@@ -3,6 +3,8 @@
 #include <tgmath.h> 
 #include "../Catch.h"
 #include "../Estimator.h"
+#include "../EstimatorCollection.h"
+#include "../ParticleAttributeBinningStructure.h"
 
 bool close(double a , double b) {
     std::cout << "abs(" << a << " , " << b << ") = " << fabs(a-b) << std::endl;
@@ -86,6 +88,157 @@ TEST_CASE( "Estimator with no scores" , "[Estimator]" ) {
   
 }
 
+TEST_CASE( "Estimator batch statistics" , "[Estimator]" ) {
+
+    Estimator est;
+
+    // two batches of two histories, scores 1 , 3 | 2 , 2
+    est.score(1.0);
+    est.endHist();
+    est.score(3.0);
+    est.endHist();
+    est.endBatch(2);
+    est.score(2.0);
+    est.endHist();
+    est.score(2.0);
+    est.endHist();
+    est.endBatch(2);
+
+    SECTION ( " batch means " ) {
+      REQUIRE( est.getBatchMeans().size() == 2 );
+      REQUIRE( close( est.getBatchMeans()[0] , 2.0 ) );
+      REQUIRE( close( est.getBatchMeans()[1] , 2.0 ) );
+    }
+
+    SECTION ( " running sums " ) {
+      REQUIRE( close( est.getHistTally()     ,  8.0 ) );
+      REQUIRE( close( est.getHistTallySqr()  , 18.0 ) );
+      REQUIRE( close( est.getHistTallyCub()  , 44.0 ) );
+      REQUIRE( close( est.getHistTallyQuad() , 114.0 ) );
+    }
+
+    // sample variance 2/3, std error of the mean sqrt(1/6), mean 2
+    SECTION ( " relative error " ) {
+      REQUIRE( close( est.getRelativeError(4) , std::sqrt( 1.0 / 6.0 ) / 2.0 ) );
+    }
+
+    // sum (x - m)^4 = 2 , ( sum (x - m)^2 )^2 = 4
+    SECTION ( " variance of the variance " ) {
+      REQUIRE( close( est.getVOV(4) , 0.25 ) );
+    }
+
+    SECTION ( " figure of merit " ) {
+      double r = est.getRelativeError(4);
+      REQUIRE( close( est.getFOM(4 , 2.0) , 1.0 / ( r * r * 2.0 ) ) );
+    }
+}
+
+TEST_CASE( "Estimator FOM history" , "[Estimator]" ) {
+
+    Estimator est;
+
+    // identical batches give a constant FOM when the time grows with the history count
+    for ( int b = 1; b <= 6; ++b ) {
+      est.score(1.0);
+      est.endHist();
+      est.score(3.0);
+      est.endHist();
+      est.endBatch(2);
+      est.recordFOM( 2 * b , 1.0 * b );
+    }
+
+    SECTION ( " one FOM per batch " ) {
+      REQUIRE( est.getFOMHistory().size() == 6 );
+      REQUIRE( close( est.getFOMHistory()[5] , est.getFOM( 12 , 6.0 ) ) );
+    }
+
+    SECTION ( " FOM settles " ) {
+      REQUIRE( est.hasStableFOM() );
+    }
+
+    // a late batch with a huge score drags the FOM down
+    est.score(100.0);
+    est.endHist();
+    est.endBatch(1);
+    est.recordFOM( 13 , 6.5 );
+
+    SECTION ( " FOM unstable after a rare large score " ) {
+      REQUIRE( ! est.hasStableFOM() );
+    }
+}
+
+TEST_CASE( "Sparse mesh estimator collection" , "[Estimator]" ) {
+
+    std::map< string , Bin_ptr > attributeMap;
+    attributeMap["Group"] = std::make_shared<GroupBinningStructure>(2);
+    SparseMeshEstimatorCollection col( "flux" , attributeMap );
+
+    Part_ptr g1 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 1 );
+    Part_ptr g2 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 2 );
+
+    SECTION ( " nothing allocated before scoring " ) {
+      REQUIRE( col.getNumAllocated() == 0 );
+      REQUIRE( col.getEstimator( 5 , 0 ) == nullptr );
+    }
+
+    // score a few tets, one of them twice in the same history
+    double xs1[] = { 1.0 };
+    double xs2[] = { 2.0 };
+    double xs4[] = { 4.0 };
+    col.scoreCollision( g1 , xs2 , 5 );
+    col.scoreCollision( g1 , xs4 , 5 );
+    col.scoreCollision( g2 , xs1 , 1000000 );
+    col.endHist();
+    col.endBatch(1);
+
+    SECTION ( " only scored ( tet , bin ) pairs allocated " ) {
+      REQUIRE( col.getNumAllocated() == 2 );
+      REQUIRE( col.getEstimator( 5 , 1 ) == nullptr );
+      REQUIRE( close( col.getEstimator( 5 , 0 )->getHistTally() , 0.75 ) );
+      REQUIRE( close( col.getEstimator( 1000000 , 1 )->getHistTally() , 1.0 ) );
+    }
+
+    // enough new keys to force the table to grow, allocated after the first batch
+    for ( int t = 0; t < 3000; ++t ) {
+      col.scoreCollision( g1 , xs1 , 7 * t + 11 );
+    }
+    col.endHist();
+    col.endBatch(1);
+
+    SECTION ( " late estimators are back filled and survive growth " ) {
+      REQUIRE( col.getNumAllocated() == 3002 );
+      REQUIRE( close( col.getEstimator( 5 , 0 )->getHistTally() , 0.75 ) );
+      REQUIRE( col.getEstimator( 7 * 2999 + 11 , 0 )->getBatchMeans().size() == 2 );
+      REQUIRE( col.getEstimator( 7 * 2999 + 11 , 0 )->getBatchMeans()[0] == 0.0 );
+    }
+}
+
+TEST_CASE( "Multiple responses from one collision" , "[Estimator]" ) {
+
+    std::map< string , Bin_ptr > attributeMap;
+    attributeMap["Group"] = std::make_shared<GroupBinningStructure>(2);
+    CollisionEstimatorCollection col( "rates" , attributeMap );
+    col.setResponses( { "flux" , "Capture" , "total" } );
+
+    // macroscopic xs row laid out as Material::xsNames: total , Capture , Scatter , Fission
+    double xs[] = { 4.0 , 1.0 , 3.0 , 0.0 };
+    Part_ptr g2 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 2 );
+    col.scoreCollision( g2 , xs );
+    col.endHist();
+
+    SECTION ( " one row per bin " ) {
+      REQUIRE( col.getEstimators().size() == 6 );
+      REQUIRE( col.getBinLabel(4) == "1 Capture" );
+    }
+
+    SECTION ( " responses scored in the particle's bin " ) {
+      REQUIRE( close( col.getEstimators()[3]->getHistTally() , 0.25 ) );
+      REQUIRE( close( col.getEstimators()[4]->getHistTally() , 0.25 ) );
+      REQUIRE( close( col.getEstimators()[5]->getHistTally() , 1.0  ) );
+      REQUIRE( col.getEstimators()[0]->getHistTally() == 0.0 );
+    }
+}
+
 //TODO test case for vecSum, std dev and tally system
 //print statements for fer-particle problem to verify tally manually
 
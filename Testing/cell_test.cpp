@@ -0,0 +1,35 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include "Catch.h"
+#include "Cell.h"
+#include "Surface.h"
+
+TEST_CASE( "Cell", "[cell]" ) {
+
+    // the box [0,2]^3 without the ball of radius 0.5 at its middle
+    Cell box( "box" );
+    box.addSurfacePair( std::make_pair( std::make_shared< sphere >( "s" , 1.0 , 1.0 , 1.0 , 0.5 ) , false ) );
+    box.addSurfacePair( std::make_pair( std::make_shared< plane >( "x0" , 1.0 , 0.0 , 0.0 , 0.0 ) , false ) );
+    box.addSurfacePair( std::make_pair( std::make_shared< plane >( "x1" , 1.0 , 0.0 , 0.0 , 2.0 ) , true  ) );
+    box.addSurfacePair( std::make_pair( std::make_shared< plane >( "y0" , 0.0 , 1.0 , 0.0 , 0.0 ) , false ) );
+    box.addSurfacePair( std::make_pair( std::make_shared< plane >( "y1" , 0.0 , 1.0 , 0.0 , 2.0 ) , true  ) );
+    box.addSurfacePair( std::make_pair( std::make_shared< plane >( "z0" , 0.0 , 0.0 , 1.0 , 0.0 ) , false ) );
+    box.addSurfacePair( std::make_pair( std::make_shared< plane >( "z1" , 0.0 , 0.0 , 1.0 , 2.0 ) , true  ) );
+
+    SECTION ( " inside " ) {
+      REQUIRE( box.amIHere( point( 0.2 , 0.2 , 0.2 ) ) );
+      REQUIRE( box.amIHere( point( 1.0 , 1.0 , 1.8 ) ) );
+    }
+
+    SECTION ( " outside one surface " ) {
+      REQUIRE_FALSE( box.amIHere( point( 1.0 , 1.0 , 1.0 ) ) );
+      REQUIRE_FALSE( box.amIHere( point( 3.0 , 0.2 , 0.2 ) ) );
+    }
+
+    // on the wrong side of two surfaces, or of all three planes of a corner
+    SECTION ( " outside several surfaces " ) {
+      REQUIRE_FALSE( box.amIHere( point( 3.0 , 3.0 , 0.2 ) ) );
+      REQUIRE_FALSE( box.amIHere( point( 3.0 , 3.0 , 3.0 ) ) );
+      REQUIRE_FALSE( box.amIHere( point( -1.0 , 1.0 , 3.0 ) ) );
+    }
+}
@@ -0,0 +1,148 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdio>
+#include <fstream>
+
+#include "Catch.h"
+#include "../EstimatorCollection.h"
+#include "../ParticleAttributeBinningStructure.h"
+
+TEST_CASE( "Checkpoint", "[checkpoint]" ) {
+
+    std::map< string , Bin_ptr > attributeMap;
+    attributeMap["Group"] = std::make_shared<GroupBinningStructure>(2);
+
+    Part_ptr g1 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 1 );
+    Part_ptr g2 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 2 );
+    double   xs1[] = { 1.0 };
+    double   xs4[] = { 4.0 };
+
+    // two batches of a sparse collection, the second allocating new keys
+    SparseMeshEstimatorCollection col( "flux" , attributeMap );
+    col.scoreCollision( g1 , xs4 , 5 );
+    col.scoreCollision( g2 , xs1 , 12 );
+    col.endHist();
+    col.endBatch(1);
+    col.recordFOM( 1 , 1.0 );
+    for ( int t = 0; t < 1000; ++t ) {
+      col.scoreCollision( g1 , xs1 , 3 * t + 100 );
+      col.endHist();
+    }
+    col.endBatch(1000);
+    col.recordFOM( 1001 , 2.0 );
+
+    {
+      CheckpointWriter out( "checkpoint_test.bin" );
+      out.writeWord( 1001 );
+      out.writeString( "flux" );
+      col.writeState( out );
+      out.commit();
+    }
+
+    // read back into a collection that has scored something else
+    SparseMeshEstimatorCollection restored( "flux" , attributeMap );
+    restored.scoreCollision( g2 , xs4 , 7 );
+    restored.endHist();
+    {
+      CheckpointReader in( "checkpoint_test.bin" );
+      REQUIRE( in.readWord() == 1001 );
+      REQUIRE( in.readString() == "flux" );
+      restored.readState( in );
+    }
+    std::remove( "checkpoint_test.bin" );
+
+    SECTION ( " same estimators in the same order " ) {
+      REQUIRE( restored.getNumAllocated() == col.getNumAllocated() );
+      REQUIRE( restored.getEstimator( 7 , 1 ) == nullptr );
+      for ( int j = 0; j < col.getNumAllocated(); ++j ) {
+        Estimator_ptr a = col.getEstimators()[j];
+        Estimator_ptr b = restored.getEstimators()[j];
+        REQUIRE( restored.getBinLabel(j) == col.getBinLabel(j) );
+        REQUIRE( b->getHistTally()     == a->getHistTally() );
+        REQUIRE( b->getHistTallySqr()  == a->getHistTallySqr() );
+        REQUIRE( b->getHistTallyCub()  == a->getHistTallyCub() );
+        REQUIRE( b->getHistTallyQuad() == a->getHistTallyQuad() );
+        REQUIRE( b->getBatchMeans()    == a->getBatchMeans() );
+        REQUIRE( b->getFOMHistory()    == a->getFOMHistory() );
+      }
+    }
+
+    // new keys after the restart are back filled for the batches before it
+    SECTION ( " scoring carries on " ) {
+      restored.scoreCollision( g1 , xs1 , 99999 );
+      restored.scoreCollision( g1 , xs4 , 5 );
+      restored.endHist();
+      restored.endBatch(1);
+      REQUIRE( restored.getEstimator( 99999 , 0 )->getBatchMeans().size() == 3 );
+      REQUIRE( restored.getEstimator( 5 , 0 )->getHistTally() == 0.5 );
+    }
+
+    SECTION ( " an uncommitted checkpoint leaves the old one alone " ) {
+      {
+        CheckpointWriter out( "checkpoint_test.bin" );
+        out.writeWord( 1 );
+        out.commit();
+      }
+      {
+        CheckpointWriter out( "checkpoint_test.bin" );
+        out.writeWord( 2 );
+      }
+      CheckpointReader in( "checkpoint_test.bin" );
+      REQUIRE( in.readWord() == 1 );
+      REQUIRE( ! std::ifstream( "checkpoint_test.bin.tmp" ).good() );
+      std::remove( "checkpoint_test.bin" );
+    }
+}
+
+TEST_CASE( "Shard batch sums", "[checkpoint]" ) {
+
+    std::map< string , Bin_ptr > attributeMap;
+    attributeMap["Group"] = std::make_shared<GroupBinningStructure>(2);
+
+    Part_ptr g1 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 1 );
+    Part_ptr g2 = std::make_shared<Particle>( point(0,0,0) , point(1,0,0) , 2 );
+    double   xs[] = { 3.0 };
+
+    // two batches of histories, each history scores a few elements
+    auto runHistory = [&]( SparseMeshEstimatorCollection &col , int h ) {
+      col.scoreCollision( h % 2 ? g1 : g2 , xs , ( 7 * h ) % 23 );
+      col.scoreCollision( g1 , xs , 100 + h % 5 );
+      col.endHist();
+    };
+
+    SparseMeshEstimatorCollection full( "flux" , attributeMap );
+    for ( int h = 0; h < 40; ++h ) {
+      runHistory( full , h );
+      if ( h == 19 || h == 39 ) { full.endBatch(20); }
+    }
+
+    // the second shard allocates the keys it shares with the first in its own order
+    SparseMeshEstimatorCollection shard1( "flux" , attributeMap );
+    SparseMeshEstimatorCollection shard2( "flux" , attributeMap );
+    {
+      CheckpointWriter out( "shard_test.bin" , "HMRSHARD" );
+      for ( int h = 0; h < 20; ++h ) { runHistory( shard1 , h ); }
+      shard1.writeBatchSums( out );
+      for ( int h = 20; h < 40; ++h ) { runHistory( shard2 , h ); }
+      shard2.writeBatchSums( out );
+      out.commit();
+    }
+
+    SparseMeshEstimatorCollection merged( "flux" , attributeMap );
+    {
+      CheckpointReader in( "shard_test.bin" , "HMRSHARD" );
+      merged.addBatchSums( in );
+      merged.endBatch(20);
+      merged.addBatchSums( in );
+      merged.endBatch(20);
+    }
+    std::remove( "shard_test.bin" );
+
+    REQUIRE( merged.getNumAllocated() == full.getNumAllocated() );
+    for ( int j = 0; j < full.getNumAllocated(); ++j ) {
+      REQUIRE( merged.getBinLabel(j) == full.getBinLabel(j) );
+      REQUIRE( merged.getEstimators()[j]->getHistTally()     == full.getEstimators()[j]->getHistTally() );
+      REQUIRE( merged.getEstimators()[j]->getHistTallyQuad() == full.getEstimators()[j]->getHistTallyQuad() );
+      REQUIRE( merged.getEstimators()[j]->getBatchMeans()    == full.getEstimators()[j]->getBatchMeans() );
+    }
+}
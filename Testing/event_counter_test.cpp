@@ -0,0 +1,67 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Catch.h"
+#include "../EventCounter.h"
+
+TEST_CASE( "Event counter", "[counters]" ) {
+
+    EventCounter a;
+    a.sourceParticles = 10;
+    a.histories       = 10;
+    a.collisions[scatterReaction] = 7;
+    a.collisions[fissionReaction] = 2;
+    a.fissionBanked   = 3;
+    a.maxBankDepth    = 4;
+    a.transportTime   = 2.0;
+
+    EventCounter b;
+    b.sourceParticles = 30;
+    b.histories       = 30;
+    b.collisions[captureReaction] = 5;
+    b.crossings       = 11;
+    b.whereAmICalls   = 41;
+    b.lostParticles   = 1;
+    b.maxBankDepth    = 2;
+    b.transportTime   = 6.0;
+
+    SECTION ( " adding workers " ) {
+      a.add( b );
+      REQUIRE( a.histories == 40 );
+      REQUIRE( a.totalCollisions() == 14 );
+      REQUIRE( a.collisions[captureReaction] == 5 );
+      REQUIRE( a.crossings == 11 );
+      REQUIRE( a.maxBankDepth == 4 );
+      REQUIRE( a.transportTime == 6.0 );
+    }
+
+    SECTION ( " shard round trip " ) {
+      {
+        CheckpointWriter out( "event_counter_test.bin" , "HMRSHARD" );
+        b.write( out );
+        out.commit();
+      }
+      CheckpointReader in( "event_counter_test.bin" , "HMRSHARD" );
+      EventCounter c;
+      c.read( in );
+      REQUIRE( c.sourceParticles == 30 );
+      REQUIRE( c.collisions[captureReaction] == 5 );
+      REQUIRE( c.whereAmICalls == 41 );
+      REQUIRE( c.lostParticles == 1 );
+      REQUIRE( c.transportTime == 6.0 );
+      std::remove( "event_counter_test.bin" );
+    }
+
+    SECTION ( " rates in the JSON " ) {
+      a.writeJSON( "event_counter_test.json" );
+      std::ifstream in( "event_counter_test.json" );
+      std::stringstream json;
+      json << in.rdbuf();
+      REQUIRE( json.str().find( "\"scatter\": { \"total\": 7, \"per_history\": 0.7, \"per_second\": 3.5 }" ) != std::string::npos );
+      REQUIRE( json.str().find( "\"max_bank_depth\": 4" ) != std::string::npos );
+      std::remove( "event_counter_test.json" );
+    }
+}
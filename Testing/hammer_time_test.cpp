@@ -0,0 +1,81 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <thread>
+
+#include "Catch.h"
+#include "HammerTime.h"
+
+TEST_CASE( "Hammer time", "[timer]" ) {
+
+    HammerTime timer;
+
+    SECTION ( " ids are interned " ) {
+      TimerId id = timer.getTimerId( "scoring" );
+      REQUIRE( timer.getTimerId( "scoring" ) == id );
+      REQUIRE( timer.getTimerId( "other" ) != id );
+      REQUIRE( timer.getTotalResult( "never started" ) == 0.0 );
+    }
+
+    SECTION ( " scoped timer " ) {
+      TimerId id = timer.getTimerId( "sleep" );
+      for ( int i = 0; i < 3; i++ ) {
+        ScopedTimer scope( timer , id );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+      }
+      REQUIRE( timer.getTotalResult( "sleep" ) >= 0.006 );
+      REQUIRE( timer.getAvgResults()[ "sleep" ] >= 0.002 );
+    }
+
+    // the string shim and the id share the same timer
+    SECTION ( " string shim " ) {
+      timer.startTimer( "block" );
+      timer.endTimer( "block" );
+      timer.start( timer.getTimerId( "block" ) );
+      timer.end( timer.getTimerId( "block" ) );
+      REQUIRE( timer.getAvgResults().count( "block" ) == 1 );
+      REQUIRE( timer.getAvgResults().count( "History" ) == 0 );
+    }
+}
+
+TEST_CASE( "History cost distribution", "[timer]" ) {
+
+    HammerTime timer;
+
+    // a couple of quick histories and one slow one with many events
+    for ( unsigned long long i = 0; i < 30; i++ ) {
+      timer.startHist();
+      if ( i == 17 ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+      }
+      timer.endHist( i , i == 17 ? 1000 : i % 3 );
+    }
+
+    SECTION ( " histograms count every history " ) {
+      uint64_t numTimed = 0 , numEvents = 0;
+      for ( uint64_t n : timer.getTimeBins() )  { numTimed  += n; }
+      for ( uint64_t n : timer.getEventBins() ) { numEvents += n; }
+      REQUIRE( numTimed == 30 );
+      REQUIRE( numEvents == 30 );
+
+      // 0 and 1 events share bin 0, 2 events is bin 1, 1000 is in [ 512 , 1024 )
+      REQUIRE( timer.getEventBins()[0] == 20 );
+      REQUIRE( timer.getEventBins()[1] == 9 );
+      REQUIRE( timer.getEventBins()[9] == 1 );
+
+      // 5 ms is 4.7 decades above 1e-7 s, sleep may oversleep by any amount so count up to the last bin
+      uint64_t numSlow = 0;
+      vector< uint64_t > timeBins = timer.getTimeBins();
+      for ( size_t b = 46; b < timeBins.size(); b++ ) { numSlow += timeBins[b]; }
+      REQUIRE( numSlow == 1 );
+    }
+
+    SECTION ( " slowest histories " ) {
+      vector< HistoryCost > slowest = timer.getSlowest();
+      REQUIRE( slowest.size() == HammerTime::numSlowest );
+      REQUIRE( slowest.front().history == 17 );
+      REQUIRE( slowest.front().events == 1000 );
+      for ( size_t k = 1; k < slowest.size(); k++ ) {
+        REQUIRE( slowest[k - 1].ns >= slowest[k].ns );
+      }
+    }
+}
@@ -0,0 +1,47 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <vector>
+
+#include "Catch.h"
+#include "Memory.h"
+
+TEST_CASE( "Memory", "[memory]" ) {
+
+    SECTION ( " container sizes " ) {
+        std::vector< double > v;
+        v.reserve( 100 );
+        REQUIRE( Memory::bytes( v ) == 100 * sizeof(double) );
+        REQUIRE( Memory::bytes( std::string( "short" ) ) == 0 );
+        REQUIRE( Memory::bytes( std::string( 100 , 'x' ) ) >= 101 );
+        REQUIRE( Memory::shared< double >() > sizeof(double) );
+    }
+
+    SECTION ( " current and peak " ) {
+        Memory::set( Memory::geometry , 1000 );
+        REQUIRE( Memory::current( Memory::geometry ) == 1000 );
+        Memory::set( Memory::geometry , 400 );
+        REQUIRE( Memory::current( Memory::geometry ) == 400 );
+        REQUIRE( Memory::peak( Memory::geometry ) == 1000 );
+
+        // a peak handed in, e.g. the deepest the bank got
+        Memory::set( Memory::banks , 0 , 5000 );
+        REQUIRE( Memory::current( Memory::banks ) == 0 );
+        REQUIRE( Memory::peak( Memory::banks ) == 5000 );
+    }
+
+    SECTION ( " buffers " ) {
+        Memory::set( Memory::output , 100 );
+        {
+            Memory::Buffer first( Memory::output , 2000 );
+            Memory::Buffer second( Memory::output , 3000 );
+            REQUIRE( Memory::current( Memory::output ) == 5100 );
+        }
+        REQUIRE( Memory::current( Memory::output ) == 100 );
+        REQUIRE( Memory::peak( Memory::output ) >= 5100 );
+    }
+
+    SECTION ( " resident size " ) {
+        REQUIRE( Memory::residentSize() > 0 );
+        REQUIRE( Memory::peakResidentSize() >= Memory::residentSize() );
+    }
+}
@@ -0,0 +1,30 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include "Catch.h"
+#include "Mesh.h"
+
+TEST_CASE( "Mesh", "[mesh]" ) {
+
+    std::shared_ptr< Constants > constants = std::make_shared< Constants > ();
+    constants->setNumGroups( 2 );
+    Mesh mesh( "berpinpolyinair.thrm" , false , constants );
+    std::vector< Tet_ptr > tets = mesh.getTets();
+
+    // a point inside a tet is found in it, whatever was found before
+    SECTION ( " centroids " ) {
+      for ( unsigned int i = 0; i < tets.size(); i += 97 ) {
+        std::vector< double > c = tets[i]->getCentroid();
+        point p( c[0] , c[1] , c[2] );
+        REQUIRE( mesh.locate( p ) == (int)i );
+        REQUIRE( mesh.whereAmI( p ) == tets[i] );
+      }
+      std::vector< double > c = tets.front()->getCentroid();
+      REQUIRE( mesh.locate( point( c[0] , c[1] , c[2] ) ) == 0 );
+      REQUIRE( mesh.locate( point( c[0] , c[1] , c[2] ) ) == 0 );
+    }
+
+    SECTION ( " outside " ) {
+      REQUIRE( mesh.locate( point( 1000.0 , 0.0 , 0.0 ) ) == -1 );
+      REQUIRE( mesh.whereAmI( point( 1000.0 , 0.0 , 0.0 ) ) == nullptr );
+    }
+}
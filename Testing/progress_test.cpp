@@ -0,0 +1,63 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cmath>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Catch.h"
+#include "Progress.h"
+
+TEST_CASE( "Progress", "[progress]" ) {
+
+    Progress progress( { "flux" , "rates" } , 0.0 , 2 );
+
+    SECTION ( " durations " ) {
+        REQUIRE( Progress::duration( 42.4 ) == "42s" );
+        REQUIRE( Progress::duration( 125 ) == "2m 05s" );
+        REQUIRE( Progress::duration( 3723 ) == "1h 02m 03s" );
+    }
+
+    SECTION ( " slots add up " ) {
+        REQUIRE( progress.planned() == 0 );
+        REQUIRE( progress.relativeError(0) < 0.0 );
+
+        progress.slot(0).planned   = 100;
+        progress.slot(1).planned   = 50;
+        progress.slot(0).histories = 30;
+        progress.slot(1).histories = 20;
+        REQUIRE( progress.planned() == 150 );
+        REQUIRE( progress.histories() == 50 );
+    }
+
+    // sqrt( sum N_w^2 R_w^2 ) / sum N_w, the relative error of the mean of both samples of one bin
+    SECTION ( " relative errors combine " ) {
+        progress.slot(0).relErr[0]      = 0.1;
+        progress.slot(0).tallyHistories = 100;
+        REQUIRE( progress.relativeError(0) == Approx( 0.1 ) );
+
+        progress.slot(1).relErr[0]      = 0.1;
+        progress.slot(1).tallyHistories = 100;
+        REQUIRE( progress.relativeError(0) == Approx( 0.1 / std::sqrt( 2.0 ) ) );
+    }
+
+    // the slots are shared with forked workers
+    SECTION ( " workers " ) {
+        pid_t pid = fork();
+        if ( pid == 0 ) {
+            progress.slot(1).planned   = 40;
+            progress.slot(1).histories = 40;
+            _exit( 0 );
+        }
+        int status;
+        waitpid( pid , &status , 0 );
+        REQUIRE( progress.planned() == 40 );
+        REQUIRE( progress.histories() == 40 );
+    }
+
+    // an interval of 0 is off
+    SECTION ( " no thread " ) {
+        progress.start();
+        progress.stop();
+        REQUIRE( progress.getNumSlots() == 2 );
+    }
+}
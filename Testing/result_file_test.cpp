@@ -0,0 +1,53 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdio>
+#include <sstream>
+
+#include "Catch.h"
+#include "ResultFile.h"
+
+TEST_CASE( "Tally result file", "[results]" ) {
+
+    // two tallies of the same name on different cells, 3 bins and 2 batches in the second
+    {
+      ResultWriter results( "result_file_test.bin", 1000, 2 );
+      results.addTally( "flux", "cell a", { "0" }, { 1.5 }, { 0.25 }, { 1.0, 2.0 } );
+      results.addTally( "flux", "cell b", { "0", "1 Capture", "" }, { 1.0, 2.0, 3.0 }, { 0.1, 0.2, 0.3 },
+                        { 0.5, 1.5, 2.5, 1.5, 2.5, 3.5 } );
+      results.close();
+    }
+    ResultReader results( "result_file_test.bin" );
+
+    // test the header and the index
+    SECTION ( " index " ) {
+      REQUIRE( results.getNumTallies() == 2 );
+      REQUIRE( results.getNumHistories() == 1000 );
+      REQUIRE( results.getNumBatches() == 2 );
+      REQUIRE( results.getTally(1).appliedTo == "cell b" );
+      REQUIRE( results.getTally(1).numBins == 3 );
+      REQUIRE( results.getTally(1).numBatches == 2 );
+      REQUIRE( results.findTally( "flux" ) == 0 );
+      REQUIRE( results.findTally( "flux", "cell b" ) == 1 );
+      REQUIRE( results.findTally( "current" ) == -1 );
+    }
+
+    // test the columns of one tally read in place
+    SECTION ( " columns " ) {
+      int t = results.findTally( "flux", "cell b" );
+      REQUIRE( results.getLabel( t, 1 ) == "1 Capture" );
+      REQUIRE( results.getLabel( t, 2 ) == "" );
+      REQUIRE( results.getMean( t )[2] == 3.0 );
+      REQUIRE( results.getStdErr( t )[1] == 0.2 );
+      REQUIRE( results.getBatchMeans( t, 0 )[2] == 2.5 );
+      REQUIRE( results.getBatchMeans( t, 1 )[0] == 1.5 );
+    }
+
+    // test a csv row
+    SECTION ( " csv " ) {
+      std::ostringstream csv;
+      results.writeCSV( csv, 0, false );
+      REQUIRE( csv.str() == "\"flux\",\"cell a\",0,\"0\",1.5,0.25,1,2\n" );
+    }
+
+    std::remove( "result_file_test.bin" );
+}
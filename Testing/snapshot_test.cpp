@@ -0,0 +1,69 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Catch.h"
+#include "Snapshot.h"
+
+TEST_CASE( "Snapshot writer", "[snapshot]" ) {
+
+    SECTION ( " names " ) {
+      REQUIRE( SnapshotWriter::snapshotName( "grid.vtu", 7 ) == "grid_b0007.vtu" );
+      REQUIRE( SnapshotWriter::snapshotName( "results", 12 ) == "results_b0012" );
+    }
+
+    // submit snapshots of a one cell grid faster than they can be written, every one is either written or skipped
+    SECTION ( " series " ) {
+      auto points = std::make_shared< const std::vector< double > >( std::vector< double > {
+                      0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,  0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1 } );
+      auto connectivity = std::make_shared< const std::vector< double > >( std::vector< double > { 0, 1, 2, 3, 4, 5, 6, 7 } );
+
+      int numSubmitted = 10;
+      SnapshotWriter writer( "", "snapshot_test.bin" );
+      for ( int b = 1; b <= numSubmitted; b++ ) {
+        std::unique_ptr< Snapshot > snapshot( new Snapshot );
+        snapshot->batch        = b;
+        snapshot->numHistories = 100 * b;
+        snapshot->tallies.push_back( TallyResult { "flux", "cell", { "1" }, { 1.0 / b }, { 0.1 }, std::vector< double >( b, 1.0 / b ) } );
+
+        GridSnapshot grid;
+        grid.filename     = "snapshot_test.vtu";
+        grid.points       = points;
+        grid.connectivity = connectivity;
+        grid.vertsPerCell = 8;
+        grid.cellType     = VTK::hexahedron;
+        grid.cellData.push_back( VTK::CellData( "mean", { 1.0 / b } ) );
+        snapshot->grids.push_back( std::move( grid ) );
+        writer.submit( std::move( snapshot ) );
+      }
+      writer.finish();
+
+      REQUIRE( writer.getNumWritten() + writer.getNumSkipped() == numSubmitted );
+      REQUIRE( writer.getNumWritten() >= 1 );
+
+      std::ifstream pvd( "snapshot_test.pvd" );
+      REQUIRE( pvd.good() );
+      std::stringstream contents;
+      contents << pvd.rdbuf();
+
+      // the last snapshot is never skipped
+      REQUIRE( contents.str().find( "timestep=\"1000\" part=\"0\" file=\"snapshot_test_b0010.vtu\"" ) != std::string::npos );
+
+      int numListed = 0;
+      for ( int b = 1; b <= numSubmitted; b++ ) {
+        std::string vtu = SnapshotWriter::snapshotName( "snapshot_test.vtu", b );
+        std::string bin = SnapshotWriter::snapshotName( "snapshot_test.bin", b );
+        if ( contents.str().find( vtu ) != std::string::npos ) {
+          numListed++;
+          REQUIRE( std::ifstream( vtu ).good() );
+          REQUIRE( ResultReader( bin ).getMean( 0 )[0] == 1.0 / b );
+        }
+        std::remove( vtu.c_str() );
+        std::remove( bin.c_str() );
+      }
+      REQUIRE( numListed == writer.getNumWritten() );
+      std::remove( "snapshot_test.pvd" );
+    }
+}
@@ -88,5 +88,36 @@ TEST_CASE( "Sphere", "[sphere]" ) {
       REQUIRE( theSphere.distance( p, d ) == Approx( eval_result ) );
     } 
 
+    // test outward normal at a point on the sphere
+    SECTION ( " normal on sphere " ) {
+      point p( 1.0, 2.0, 1.0 );
+      point n = theSphere.getNormal( p );
+      REQUIRE( n.x == Approx( 0.0 ) );
+      REQUIRE( n.y == Approx( 0.0 ) );
+      REQUIRE( n.z == Approx( 1.0 ) );
+    }
+
+    // test normal at the crossing point found by distance (not exactly on the sphere after the move)
+    SECTION ( " normal at crossing point " ) {
+      point p( -4.0, 2.5, -2.5 );
+      point d( 1.0, 0.3, -0.2 );
+      d = d / std::sqrt( d * d );
+      point x = p + d * theSphere.distance( p, d );
+      point n = theSphere.getNormal( x );
+      point c = theSphere.crossingNormal( x );
+      REQUIRE( n * n == Approx( 1.0 ) );
+      REQUIRE( n.x == Approx( c.x ) );
+      REQUIRE( n.y == Approx( c.y ) );
+      REQUIRE( n.z == Approx( c.z ) );
+      REQUIRE( n * d < 0.0 ); // entering the sphere, against the outward normal
+    }
+
+    // test normal for a point off the sphere
+    SECTION ( " normal off sphere " ) {
+      point p( 1.0, 2.0, 1.1 );
+      point n = theSphere.getNormal( p );
+      REQUIRE( n * n == 0.0 );
+    }
+
 }
 
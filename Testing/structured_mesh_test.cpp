@@ -0,0 +1,128 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <map>
+
+#include "Catch.h"
+#include "StructuredMesh.h"
+#include "Random.h"
+
+// total length of a track that lies in the grid, walked in small steps
+double bruteForceLength( StructuredGrid &grid, point start, point dir, double length, int cell ) {
+  int    nSteps = 100000;
+  double ds     = length / nSteps;
+  double total  = 0.0;
+  for ( int i = 0; i < nSteps; i++ ) {
+    double t = ( i + 0.5 ) * ds;
+    int    c = grid.getIndex( point( start.x + t*dir.x, start.y + t*dir.y, start.z + t*dir.z ) );
+    if ( c >= 0 && ( cell < 0 || c == cell ) ) { total += ds; }
+  }
+  return total;
+}
+
+TEST_CASE( "Cartesian grid", "[structured]" ) {
+
+    CartesianGrid grid( -2.0, 2.0, 4, -1.0, 1.0, 2, 0.0, 3.0, 3 );
+
+    // test cell indices, x fastest
+    SECTION ( " index of a point " ) {
+      REQUIRE( grid.getNumCells() == 24 );
+      REQUIRE( grid.getIndex( point( -1.5, -0.5, 0.5 ) ) == 0 );
+      REQUIRE( grid.getIndex( point(  1.5,  0.5, 2.5 ) ) == 3 + 4 * ( 1 + 2 * 2 ) );
+      REQUIRE( grid.getIndex( point(  2.5,  0.0, 1.0 ) ) == -1 );
+    }
+
+    // test a track along x through the middle of a row of cells
+    SECTION ( " segments along an axis " ) {
+      vector< Segment > segments;
+      grid.getSegments( point( -3.0, 0.5, 1.5 ), point( 1.0, 0.0, 0.0 ), 10.0, segments );
+      REQUIRE( segments.size() == 4 );
+      for ( int i = 0; i < 4; i++ ) {
+        REQUIRE( segments[i].first  == i + 4 * ( 1 + 2 * 1 ) );
+        REQUIRE( segments[i].second == Approx( 1.0 ) );
+      }
+    }
+
+    // test random oblique tracks against walking them in small steps
+    SECTION ( " random tracks " ) {
+      vector< Segment > segments;
+      for ( int n = 0; n < 20; n++ ) {
+        point  start( 6.0 * rng->Urand() - 3.0, 3.0 * rng->Urand() - 1.5, 4.0 * rng->Urand() - 0.5 );
+        double mu  = 2.0 * rng->Urand() - 1.0;
+        double phi = 2.0 * M_PI * rng->Urand();
+        point  dir( std::sqrt( 1.0 - mu*mu ) * std::cos( phi ), std::sqrt( 1.0 - mu*mu ) * std::sin( phi ), mu );
+        double length = 5.0 * rng->Urand();
+
+        // a track can leave and come back into a cell, compare the total in each
+        grid.getSegments( start, dir, length, segments );
+        std::map< int, double > cellLength;
+        double total = 0.0;
+        for ( auto s : segments ) {
+          total += s.second;
+          cellLength[ s.first ] += s.second;
+        }
+        for ( auto c : cellLength ) {
+          REQUIRE( c.second == Approx( bruteForceLength( grid, start, dir, length, c.first ) ).epsilon( 0.001 ).margin( 1.0e-4 ) );
+        }
+        REQUIRE( total == Approx( bruteForceLength( grid, start, dir, length, -1 ) ).epsilon( 0.001 ).margin( 1.0e-4 ) );
+      }
+    }
+}
+
+TEST_CASE( "Cylindrical grid", "[structured]" ) {
+
+    CylindricalGrid grid( 1.0, 1.0, 2.0, 2, -1.0, 1.0, 2, 4 );
+
+    // test cell indices, r fastest then z then theta
+    SECTION ( " index of a point " ) {
+      REQUIRE( grid.getNumCells() == 16 );
+      REQUIRE( grid.getIndex( point( 1.5, 1.1, -0.5 ) ) == 0 );
+      REQUIRE( grid.getIndex( point( 1.0, 2.5,  0.5 ) ) == 1 + 2 * ( 1 + 2 * 1 ) );
+      REQUIRE( grid.getIndex( point( 0.5, 0.9, -0.5 ) ) == 2 * 2 * 2 );
+      REQUIRE( grid.getIndex( point( 3.5, 1.0,  0.0 ) ) == -1 );
+      REQUIRE( grid.getIndex( point( 1.0, 1.0,  1.5 ) ) == -1 );
+    }
+
+    // test volumes add up to the cylinder
+    SECTION ( " volumes " ) {
+      double total = 0.0;
+      for ( int c = 0; c < grid.getNumCells(); c++ ) {
+        total += grid.getVolume( c );
+      }
+      REQUIRE( total == Approx( M_PI * 4.0 * 2.0 ) );
+    }
+
+    // test a diameter along x, through both shells on either side of the axis
+    SECTION ( " segments through the axis " ) {
+      vector< Segment > segments;
+      grid.getSegments( point( -2.0, 1.3, 0.5 ), point( 1.0, 0.0, 0.0 ), 10.0, segments );
+      double total = 0.0;
+      for ( auto s : segments ) { total += s.second; }
+      REQUIRE( segments.size() == 4 );
+      REQUIRE( total == Approx( 2.0 * std::sqrt( 4.0 - 0.09 ) ) );
+    }
+
+    // test random oblique tracks against walking them in small steps
+    SECTION ( " random tracks " ) {
+      vector< Segment > segments;
+      for ( int n = 0; n < 20; n++ ) {
+        point  start( 6.0 * rng->Urand() - 2.0, 6.0 * rng->Urand() - 2.0, 3.0 * rng->Urand() - 1.5 );
+        double mu  = 2.0 * rng->Urand() - 1.0;
+        double phi = 2.0 * M_PI * rng->Urand();
+        point  dir( std::sqrt( 1.0 - mu*mu ) * std::cos( phi ), std::sqrt( 1.0 - mu*mu ) * std::sin( phi ), mu );
+        double length = 5.0 * rng->Urand();
+
+        // a track can leave and come back into a cell, compare the total in each
+        grid.getSegments( start, dir, length, segments );
+        std::map< int, double > cellLength;
+        double total = 0.0;
+        for ( auto s : segments ) {
+          total += s.second;
+          cellLength[ s.first ] += s.second;
+        }
+        for ( auto c : cellLength ) {
+          REQUIRE( c.second == Approx( bruteForceLength( grid, start, dir, length, c.first ) ).epsilon( 0.001 ).margin( 1.0e-4 ) );
+        }
+        REQUIRE( total == Approx( bruteForceLength( grid, start, dir, length, -1 ) ).epsilon( 0.001 ).margin( 1.0e-4 ) );
+      }
+    }
+}
@@ -0,0 +1,80 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#include "Catch.h"
+#include "TextWriter.h"
+
+TEST_CASE( "Shortest round trip text", "[text]" ) {
+
+    // test the format of a few values, %g style
+    SECTION ( " known values " ) {
+      REQUIRE( Text::shortest( 0.1 ) == "0.1" );
+      REQUIRE( Text::shortest( 1.0 / 3.0 ) == "0.3333333333333333" );
+      REQUIRE( Text::shortest( 100.0 ) == "100" );
+      REQUIRE( Text::shortest( -123456.789 ) == "-123456.789" );
+      REQUIRE( Text::shortest( 2.5e-5 ) == "2.5e-05" );
+      REQUIRE( Text::shortest( 0.0001 ) == "0.0001" );
+      REQUIRE( Text::shortest( 1.0e17 ) == "1e+17" );
+      REQUIRE( Text::shortest( 5.0e-324 ) == "5e-324" );
+      REQUIRE( Text::shortest( 1.7976931348623157e308 ) == "1.7976931348623157e+308" );
+      REQUIRE( Text::shortest( 0.0 ) == "0" );
+      REQUIRE( Text::shortest( -0.0 ) == "-0" );
+      REQUIRE( Text::shortest( 1.0 / 0.0 ) == "inf" );
+    }
+
+    // test random bit patterns, normals and subnormals, read back to the same double
+    SECTION ( " round trip " ) {
+      std::mt19937_64 bits( 12345 );
+      int numWrong = 0;
+      for ( int i = 0; i < 200000; i++ ) {
+        uint64_t u = bits();
+        double   d;
+        std::memcpy( &d, &u, 8 );
+        if ( ! std::isfinite( d ) ) { continue; }
+        if ( std::strtod( Text::shortest( d ).c_str(), nullptr ) != d ) { numWrong++; }
+      }
+      REQUIRE( numWrong == 0 );
+    }
+
+    SECTION ( " integers " ) {
+      char buffer[ Text::maxLength ];
+      REQUIRE( std::string( buffer, Text::integer( 0, buffer ) ) == "0" );
+      REQUIRE( std::string( buffer, Text::integer( -9223372036854775807LL - 1, buffer ) ) == "-9223372036854775808" );
+    }
+}
+
+TEST_CASE( "Text writer", "[text]" ) {
+
+    // test an array large enough to be formatted in parallel chunks comes out in order
+    SECTION ( " array " ) {
+      std::vector< double > values;
+      for ( int i = 0; i < 300000; i++ ) { values.push_back( 1.0 / ( i + 1 ) ); }
+
+      std::string expected = "  ";
+      for ( int i = 0; i < 300000; i++ ) {
+        if ( i > 0 && i % 7 == 0 ) { expected += "\n  "; }
+        expected += Text::shortest( values[i] ) + " ";
+      }
+
+      std::ostringstream out;
+      {
+        TextWriter text( out );
+        text.setNumThreads( 4 );
+        text.writeArray( [&values]( size_t i ) { return values[i]; }, values.size(), 7, "  ", false );
+      }
+      REQUIRE( out.str() == expected );
+    }
+
+    SECTION ( " mixed " ) {
+      std::ostringstream out;
+      {
+        TextWriter text( out );
+        text << "tally " << 3 << ' ' << 0.5 << ' ' << 12ULL;
+      }
+      REQUIRE( out.str() == "tally 3 0.5 12" );
+    }
+}
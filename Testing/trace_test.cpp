@@ -0,0 +1,71 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "Catch.h"
+#include "Trace.h"
+
+static std::string readFile( std::string filename ) {
+    std::ifstream in( filename );
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+static int count( const std::string &text , const std::string &what ) {
+    int n = 0;
+    for ( size_t at = text.find( what ); at != std::string::npos; at = text.find( what , at + 1 ) ) { n++; }
+    return n;
+}
+
+TEST_CASE( "Trace", "[trace]" ) {
+
+    // the trace is global and Catch runs the case once per section
+    Trace::clear();
+
+    // nothing is recorded until enabled
+    { TraceScope scope( "before" ); }
+    Trace::enable();
+    Trace::nameThread( "main" );
+
+    { TraceScope scope( "batch" , 3 ); }
+
+    // another thread records into its own buffer, which overflows
+    std::thread other( [] {
+      Trace::nameThread( "other" );
+      for ( size_t i = 0; i < Trace::bufferSize + 10; i++ ) {
+        TraceScope scope( "many" );
+      }
+    } );
+    other.join();
+
+    SECTION ( " chrome trace " ) {
+      Trace::write( "trace_test.json" );
+      std::string json = readFile( "trace_test.json" );
+      REQUIRE( json.find( "{\"traceEvents\":[" ) == 0 );
+      REQUIRE( count( json , "\"before\"" ) == 0 );
+      REQUIRE( count( json , "\"name\":\"batch\",\"ph\":\"X\"" ) == 1 );
+      REQUIRE( count( json , "\"args\":{\"n\":3}" ) == 1 );
+      REQUIRE( count( json , "\"args\":{\"name\":\"main\"}" ) == 1 );
+      REQUIRE( count( json , "\"args\":{\"name\":\"other\"}" ) == 1 );
+      REQUIRE( count( json , "\"many\"" ) == static_cast<int>( Trace::bufferSize ) );
+      std::remove( "trace_test.json" );
+    }
+
+    // a worker's events come back through a fragment, the worker starts empty
+    SECTION ( " fragments " ) {
+      Trace::writeFragment( "trace_test.fragment" );
+      Trace::clear();
+      { TraceScope scope( "merge" ); }
+      Trace::readFragment( "trace_test.fragment" );
+      Trace::write( "trace_test.json" );
+      std::string json = readFile( "trace_test.json" );
+      REQUIRE( count( json , "\"batch\"" ) == 1 );
+      REQUIRE( count( json , "\"merge\"" ) == 1 );
+      REQUIRE( std::ifstream( "trace_test.fragment" ).good() == false );
+      std::remove( "trace_test.json" );
+    }
+}
@@ -11,6 +11,28 @@ TEST_CASE( "Utility", "[utility]" ) {
 
 
 
+/* ****************************************************************************************************** * 
+ * Binning Structure
+ *
+ * ****************************************************************************************************** */ 
+
+  // integer max is one past the largest value, double max belongs to the last bin
+  SECTION ( " binning structure bounds " ) {
+    Utility::BinningStructure<int> one( 0 , 1 , 1 );
+    REQUIRE( one.getIndex( 0 ) == std::make_pair( 0 , true ) );
+    REQUIRE( one.getIndex( 1 ).second == false );
+
+    Utility::BinningStructure<int> four( 0 , 4 , 4 );
+    REQUIRE( four.getIndex( 3 ) == std::make_pair( 3 , true ) );
+    REQUIRE( four.getIndex( 4 ).second == false );
+    REQUIRE( four.getIndex( 5 ).second == false );
+    REQUIRE( four.getIndex( -1 ).second == false );
+
+    Utility::BinningStructure<double> histogram( 0.0 , 1.0 , 4 );
+    REQUIRE( histogram.getIndex( 1.0 ) == std::make_pair( 3 , true ) );
+    REQUIRE( histogram.getIndex( 1.0 + 1e-12 ).second == false );
+  }
+
 /* ****************************************************************************************************** * 
  * Generic Vector and Point Operations
  *
@@ -106,4 +128,35 @@ TEST_CASE( "Utility", "[utility]" ) {
     REQUIRE( Utility::twoDeterminant(v1, v2) == -2);
   }
 
+/* ****************************************************************************************************** * 
+ * Orthogonal Polynomials
+ *
+ * ****************************************************************************************************** */ 
+  // test Legendre recurrence against the closed forms
+  SECTION ( " Legendre polynomials " ) {
+    vector<double> P;
+    Utility::legendre( 4, 0.5, P );
+    REQUIRE( P.size() == 5 );
+    REQUIRE( P[0] == Approx( 1.0 ) );
+    REQUIRE( P[1] == Approx( 0.5 ) );
+    REQUIRE( P[2] == Approx( -0.125 ) );
+    REQUIRE( P[3] == Approx( -0.4375 ) );
+    REQUIRE( P[4] == Approx( ( 35.0 * 0.0625 - 30.0 * 0.25 + 3.0 ) / 8.0 ) );
+  }
+
+  // test Zernike ordering and values against the closed forms
+  SECTION ( " Zernike polynomials " ) {
+    vector<double> Z;
+    double rho = 0.6, theta = 0.7;
+    Utility::zernike( 4, rho, theta, Z );
+    REQUIRE( Z.size() == Utility::numZernike( 4 ) );
+    REQUIRE( Z.size() == 15 );
+    REQUIRE( Z[0] == Approx( 1.0 ) );                                                         // Z(0,0)
+    REQUIRE( Z[1] == Approx( rho * std::sin( theta ) ) );                                     // Z(1,-1)
+    REQUIRE( Z[2] == Approx( rho * std::cos( theta ) ) );                                     // Z(1,1)
+    REQUIRE( Z[4] == Approx( 2.0 * rho * rho - 1.0 ) );                                       // Z(2,0)
+    REQUIRE( Z[8] == Approx( ( 3.0 * pow( rho, 3 ) - 2.0 * rho ) * std::cos( theta ) ) );     // Z(3,1)
+    REQUIRE( Z[12] == Approx( 6.0 * pow( rho, 4 ) - 6.0 * rho * rho + 1.0 ) );                // Z(4,0)
+  }
+
 }
@@ -0,0 +1,151 @@
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef HAMMER_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Catch.h"
+#include "VTKWriter.h"
+
+std::string readFile( std::string filename ) {
+  std::ifstream in( filename, std::ios::binary );
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+std::string base64Decode( std::string encoded ) {
+  std::string table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string decoded;
+  for ( size_t i = 0; i + 3 < encoded.size(); i += 4 ) {
+    int q[4];
+    for ( int j = 0; j < 4; j++ ) { q[j] = encoded[i+j] == '=' ? 0 : table.find( encoded[i+j] ); }
+    decoded += (char) ( ( q[0] << 2 ) | ( q[1] >> 4 ) );
+    if ( encoded[i+2] != '=' ) { decoded += (char) ( ( ( q[1] & 0x0f ) << 4 ) | ( q[2] >> 2 ) ); }
+    if ( encoded[i+3] != '=' ) { decoded += (char) ( ( ( q[2] & 0x03 ) << 6 ) | q[3] ); }
+  }
+  return decoded;
+}
+
+uint64_t word( std::string bytes, int i ) {
+  uint64_t w;
+  std::memcpy( &w, bytes.data() + 8*i, 8 );
+  return w;
+}
+
+// read the Float64 array called name back from a file written by VTK::writeUnstructuredGrid
+std::vector< double > readArray( std::string filename, std::string name ) {
+  std::string file = readFile( filename );
+  size_t tag = file.find( "Name=\"" + name + "\"" );
+  size_t end = file.find( ">", tag );
+  std::string bytes;
+
+  if ( file.find( "format=\"ascii\"", tag ) < end ) {
+    std::istringstream values( file.substr( end + 1, file.find( "</DataArray>", end ) - end - 1 ) );
+    std::vector< double > result;
+    double v;
+    while ( values >> v ) { result.push_back( v ); }
+    return result;
+  }
+
+  size_t offsetAt = file.find( "offset=\"", tag ) + 8;
+  size_t offset   = std::stoul( file.substr( offsetAt, file.find( "\"", offsetAt ) - offsetAt ) );
+  bool   encoded  = file.find( "encoding=\"base64\"" ) != std::string::npos;
+  bool   zlib     = file.find( "compressor=" ) != std::string::npos;
+  std::string data = file.substr( file.find( "_", file.find( "<AppendedData" ) ) + 1 + offset );
+
+  if ( ! zlib ) {
+    std::string header = encoded ? base64Decode( data.substr( 0, 12 ) ) : data;
+    uint64_t numBytes = word( header, 0 );
+    bytes = encoded ? base64Decode( data.substr( 0, 4 * ( ( 8 + numBytes + 2 ) / 3 ) ) ).substr( 8 ) : data.substr( 8, numBytes );
+  }
+#ifdef HAMMER_ZLIB
+  else {
+    // the header is encoded on its own, its length follows from the number of blocks
+    std::string header = encoded ? base64Decode( data.substr( 0, 32 ) ) : data;
+    uint64_t numBlocks  = word( header, 0 );
+    uint64_t blockSize  = word( header, 1 );
+    uint64_t lastBlock  = word( header, 2 );
+    size_t   headerSize = 8 * ( 3 + numBlocks );
+    size_t   headerLength = encoded ? 4 * ( ( headerSize + 2 ) / 3 ) : headerSize;
+    if ( encoded ) { header = base64Decode( data.substr( 0, headerLength ) ); }
+    size_t compressedSize = 0;
+    for ( uint64_t b = 0; b < numBlocks; b++ ) { compressedSize += word( header, 3 + b ); }
+    std::string blocks = encoded ? base64Decode( data.substr( headerLength, 4 * ( ( compressedSize + 2 ) / 3 ) ) )
+                                 : data.substr( headerLength, compressedSize );
+    size_t at = 0;
+    for ( uint64_t b = 0; b < numBlocks; b++ ) {
+      uLongf size = ( b == numBlocks - 1 && lastBlock > 0 ) ? lastBlock : blockSize;
+      std::vector< Bytef > block( size );
+      uncompress( block.data(), &size, (const Bytef*) blocks.data() + at, word( header, 3 + b ) );
+      bytes.append( (const char*) block.data(), size );
+      at += word( header, 3 + b );
+    }
+  }
+#endif
+
+  std::vector< double > result( bytes.size() / 8 );
+  std::memcpy( result.data(), bytes.data(), bytes.size() );
+  return result;
+}
+
+TEST_CASE( "VTK writer", "[VTK]" ) {
+
+    // many tets on the same four points, enough cell data to span several blocks
+    std::vector< double > points = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    std::vector< double > connectivity;
+    std::vector< double > values;
+    for ( int i = 0; i < 10000; i++ ) {
+      for ( int v = 0; v < 4; v++ ) { connectivity.push_back( v ); }
+      values.push_back( 1.0 / ( i + 1 ) );
+    }
+    std::vector< VTK::CellData > cellData = { std::make_pair( "values", values ) };
+
+    // test each encoding reads back to the same numbers
+    SECTION ( " ascii " ) {
+      VTK::setEncoding( "ascii", "none" );
+      VTK::writeUnstructuredGrid( "vtk_test.vtu", points, connectivity, 4, VTK::tetrahedron, cellData );
+      std::vector< double > read = readArray( "vtk_test.vtu", "values" );
+      REQUIRE( read.size() == values.size() );
+      REQUIRE( read[9999] == Approx( values[9999] ) );
+      REQUIRE( readArray( "vtk_test.vtu", "Points" ) == points );
+    }
+
+    SECTION ( " raw " ) {
+      VTK::setEncoding( "raw", "none" );
+      VTK::writeUnstructuredGrid( "vtk_test.vtu", points, connectivity, 4, VTK::tetrahedron, cellData );
+      REQUIRE( readArray( "vtk_test.vtu", "values" ) == values );
+      REQUIRE( readArray( "vtk_test.vtu", "Points" ) == points );
+    }
+
+    SECTION ( " base64 " ) {
+      VTK::setEncoding( "base64", "none" );
+      VTK::writeUnstructuredGrid( "vtk_test.vtu", points, connectivity, 4, VTK::tetrahedron, cellData );
+      REQUIRE( readArray( "vtk_test.vtu", "values" ) == values );
+      REQUIRE( readArray( "vtk_test.vtu", "Points" ) == points );
+    }
+
+#ifdef HAMMER_ZLIB
+    SECTION ( " raw zlib " ) {
+      VTK::setEncoding( "raw", "zlib" );
+      VTK::writeUnstructuredGrid( "vtk_test.vtu", points, connectivity, 4, VTK::tetrahedron, cellData );
+      REQUIRE( readArray( "vtk_test.vtu", "values" ) == values );
+      REQUIRE( readArray( "vtk_test.vtu", "Points" ) == points );
+    }
+
+    SECTION ( " base64 zlib " ) {
+      VTK::setEncoding( "base64", "zlib" );
+      VTK::writeUnstructuredGrid( "vtk_test.vtu", points, connectivity, 4, VTK::tetrahedron, cellData );
+      REQUIRE( readArray( "vtk_test.vtu", "values" ) == values );
+      REQUIRE( readArray( "vtk_test.vtu", "Points" ) == points );
+    }
+#endif
+
+    std::remove( "vtk_test.vtu" );
+}
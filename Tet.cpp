@@ -7,6 +7,7 @@
 //
 
 #include "Tet.h"
+#include "Memory.h"
 
 using namespace Utility;
 
@@ -151,11 +152,11 @@ bool Tet::amIHere( const std::vector< double >& testPoint )
 
 // Estimator interface
 
-void Tet::scoreTally(Part_ptr p , double xs) {
-  // for each EstimatorCollection
-    // for each attribute
-      // get the index of the Estimator to score
-      // score the estimator
+void Tet::scoreTally(Part_ptr p , const double* xs) {
+  // each EstimatorCollection finds the index of its Estimator to score from the particle attributes
+  for(auto est : estimators) {
+      est->scoreCollision(p , xs);
+  }
 }
 
 void Tet::endTallyHist() {
@@ -168,3 +169,13 @@ void Tet::endTallyHist() {
 void Tet::addEstimator( EstCol_ptr newEstimator ) {
 	estimators.push_back( newEstimator );
 }
+
+uint64_t Tet::memoryUsage()
+{
+	uint64_t total = Memory::shared< Tet >() + Memory::bytes( tetName ) + Memory::bytes( estimators );
+	for ( const vector< double >* v : { &vert1 , &vert2 , &vert3 , &vert4 , &A1 , &A2 , &A3 , &A4 } )
+	{
+		total += Memory::bytes( *v );
+	}
+	return total;
+}
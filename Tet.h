@@ -66,8 +66,10 @@ public:
     
     bool amIHere( const std::vector< double >& testPoint );
 
+    uint64_t memoryUsage(); // bytes of the tet, its vertices and determinants
+
     // Estimator interface
-    void scoreTally(Part_ptr p , double xs); 
+    void scoreTally(Part_ptr p , const double* xs); // xs is the material macroscopic xs row
     void endTallyHist();
   
 };
@@ -0,0 +1,344 @@
+/*
+ * Text output of doubles
+ */
+
+#include "TextWriter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+/* ****************************************************************************************************** *
+ * Grisu2
+ *  a double v = f 2^e is scaled by a cached power of ten c ~ 10^k into a 64 bit window where its digits
+ *  come out of integer arithmetic, between the boundaries of v shrunk by one unit so every digit string
+ *  produced reads back to v
+ * ****************************************************************************************************** */
+
+// 64 bit significand and binary exponent, f 2^e
+struct DiyFp {
+  uint64_t f;
+  int      e;
+  DiyFp(uint64_t fin = 0 , int ein = 0) : f(fin) , e(ein) {};
+};
+
+static DiyFp multiply(DiyFp x , DiyFp y) {
+  // upper 64 bits of the 128 bit product, rounded
+  unsigned __int128 p = static_cast< unsigned __int128 >(x.f) * y.f;
+  uint64_t h = static_cast< uint64_t >( p >> 64 ) + static_cast< uint64_t >( ( p >> 63 ) & 1 );
+  return( DiyFp( h , x.e + y.e + 64 ) );
+}
+
+static DiyFp normalize(DiyFp x) {
+  while( ( x.f >> 63 ) == 0 ) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return(x);
+}
+
+// the scaled w has its binary exponent in [ minScaledExponent , maxScaledExponent ], so the integer part fits 32 bits
+static const int minScaledExponent = -60;
+static const int maxScaledExponent = -32;
+
+/* ****************************************************************************************************** *
+ * Cached powers of ten
+ *  10^k for k = -348 , -340 , ... , 340 as normalized 64 bit significands, rounded from the exact value
+ *  with a small bignum when the table is first used
+ * ****************************************************************************************************** */
+
+struct CachedPower {
+  uint64_t f;
+  int      e;
+  int      k;
+};
+
+typedef std::vector< uint32_t > BigNum; // little endian 32 bit limbs
+
+static int bitLength(const BigNum &a) {
+  for(int i = a.size() - 1; i >= 0; --i) {
+    if( a[i] ) { return( 32 * i + 32 - __builtin_clz( a[i] ) ); }
+  }
+  return(0);
+}
+
+static bool getBit(const BigNum &a , int bit) {
+  return( ( a[ bit / 32 ] >> ( bit % 32 ) ) & 1 );
+}
+
+static void multiplySmall(BigNum &a , uint32_t m) {
+  uint64_t carry = 0;
+  for(auto &limb : a) {
+    uint64_t p = static_cast< uint64_t >(limb) * m + carry;
+    limb  = static_cast< uint32_t >(p);
+    carry = p >> 32;
+  }
+  if( carry ) { a.push_back( carry ); }
+}
+
+// top 64 bits of a starting at bit length, rounded half up; the exponent is bumped if rounding carries out
+static CachedPower topBits(const BigNum &a , int length , int exponentOffset) {
+  CachedPower c;
+  c.f = 0;
+  for(int i = 0; i < 64; ++i) {
+    int bit = length - 1 - i;
+    c.f = ( c.f << 1 ) | ( bit >= 0 && getBit( a , bit ) ? 1 : 0 );
+  }
+  c.e = length - 64 + exponentOffset;
+  if( length > 64 && getBit( a , length - 65 ) ) {
+    c.f++;
+    if( c.f == 0 ) {
+      c.f = uint64_t(1) << 63;
+      c.e++;
+    }
+  }
+  return(c);
+}
+
+static CachedPower exactPower(int k) {
+  BigNum ten( 1 , 1 );
+  for(int i = 0; i < std::abs(k); ++i) { multiplySmall( ten , 10 ); }
+  if( k >= 0 ) {
+    CachedPower c = topBits( ten , bitLength(ten) , 0 );
+    c.k = k;
+    return(c);
+  }
+
+  // 10^k = 2^-s ( 2^s / 10^-k ), s large enough that the quotient has 66 bits, by long division
+  int    s = bitLength(ten) + 65;
+  BigNum quotient( s / 32 + 1 , 0 );
+  BigNum remainder( ten.size() + 1 , 0 );
+  for(int bit = s; bit >= 0; --bit) {
+    // remainder = 2 remainder + ( bit of 2^s )
+    uint32_t carry = ( bit == s ) ? 1 : 0;
+    for(auto &limb : remainder) {
+      uint32_t next = limb >> 31;
+      limb  = ( limb << 1 ) | carry;
+      carry = next;
+    }
+    // subtract the divisor if it fits
+    bool fits = true;
+    for(int i = remainder.size() - 1; i >= 0; --i) {
+      uint32_t d = i < static_cast< int >( ten.size() ) ? ten[i] : 0;
+      if( remainder[i] != d ) { fits = remainder[i] > d; break; }
+    }
+    if( fits ) {
+      int64_t borrow = 0;
+      for(unsigned int i = 0; i < remainder.size(); ++i) {
+        int64_t d = static_cast< int64_t >( remainder[i] ) - ( i < ten.size() ? ten[i] : 0 ) - borrow;
+        borrow       = d < 0 ? 1 : 0;
+        remainder[i] = static_cast< uint32_t >( d + ( borrow << 32 ) );
+      }
+      quotient[ bit / 32 ] |= uint32_t(1) << ( bit % 32 );
+    }
+  }
+  CachedPower c = topBits( quotient , bitLength(quotient) , -s );
+  c.k = k;
+  return(c);
+}
+
+static const std::vector< CachedPower > &cachedPowers() {
+  static const std::vector< CachedPower > powers = [] {
+    std::vector< CachedPower > p;
+    for(int k = -348; k <= 340; k += 8) { p.push_back( exactPower(k) ); }
+    return(p);
+  }();
+  return(powers);
+}
+
+// cached power c such that minScaledExponent <= e + c.e + 64 <= maxScaledExponent, the table steps by ~26.6 < 28
+static CachedPower getCachedPower(int e) {
+  const std::vector< CachedPower > &powers = cachedPowers();
+  int minExponent = minScaledExponent - 64 - e;
+  auto c = std::lower_bound( powers.begin() , powers.end() , minExponent ,
+                             [](const CachedPower &p , int exponent) { return( p.e < exponent ); } );
+  return(*c);
+}
+
+/* ****************************************************************************************************** *
+ * Digit generation
+ * ****************************************************************************************************** */
+
+// move the last digit down while that brings it closer to w and stays inside the boundaries
+static void roundWeed(char* buffer , int length , uint64_t dist , uint64_t delta , uint64_t rest , uint64_t tenK) {
+  while( rest < dist && delta - rest >= tenK && ( rest + tenK < dist || dist - rest > rest + tenK - dist ) ) {
+    buffer[ length - 1 ]--;
+    rest += tenK;
+  }
+}
+
+// digits of a number in ( Mminus , Mplus ) as close to w as possible, all scaled to the same exponent
+static void generateDigits(char* buffer , int &length , int &decimalExponent , DiyFp Mminus , DiyFp w , DiyFp Mplus) {
+  uint64_t delta = Mplus.f - Mminus.f;
+  uint64_t dist  = Mplus.f - w.f;
+
+  // integer and fractional parts of Mplus
+  int      shift = -Mplus.e;
+  uint64_t one   = uint64_t(1) << shift;
+  uint32_t p1    = static_cast< uint32_t >( Mplus.f >> shift );
+  uint64_t p2    = Mplus.f & ( one - 1 );
+
+  // largest power of ten <= p1
+  uint32_t pow10 = 1;
+  int      k     = 1;
+  while( k < 10 && pow10 * uint64_t(10) <= p1 ) {
+    pow10 *= 10;
+    k++;
+  }
+
+  length = 0;
+  int n = k;
+  while( n > 0 ) {
+    buffer[ length++ ] = '0' + p1 / pow10;
+    p1 %= pow10;
+    n--;
+    uint64_t rest = ( static_cast< uint64_t >(p1) << shift ) + p2;
+    if( rest <= delta ) {
+      decimalExponent += n;
+      roundWeed( buffer , length , dist , delta , rest , static_cast< uint64_t >(pow10) << shift );
+      return;
+    }
+    pow10 /= 10;
+  }
+
+  int m = 0;
+  while( true ) {
+    p2 *= 10;
+    buffer[ length++ ] = '0' + ( p2 >> shift );
+    p2 &= one - 1;
+    m++;
+    delta *= 10;
+    dist  *= 10;
+    if( p2 <= delta ) { break; }
+  }
+  decimalExponent -= m;
+  roundWeed( buffer , length , dist , delta , p2 , one );
+}
+
+// digits and decimal exponent of a finite positive v, v = digits 10^decimalExponent
+static void grisu2(double v , char* buffer , int &length , int &decimalExponent) {
+  uint64_t bits;
+  std::memcpy( &bits , &v , 8 );
+  uint64_t F = bits & ( ( uint64_t(1) << 52 ) - 1 );
+  int      E = static_cast< int >( bits >> 52 );
+
+  DiyFp w = E == 0 ? DiyFp( F , 1 - 1075 ) : DiyFp( F + ( uint64_t(1) << 52 ) , E - 1075 );
+
+  // boundaries halfway to the neighbors, the lower one is closer at a power of two
+  bool  lowerCloser = F == 0 && E > 1;
+  DiyFp plus  = normalize( DiyFp( 2 * w.f + 1 , w.e - 1 ) );
+  DiyFp minus = lowerCloser ? DiyFp( 4 * w.f - 1 , w.e - 2 ) : DiyFp( 2 * w.f - 1 , w.e - 1 );
+  minus.f <<= minus.e - plus.e;
+  minus.e   = plus.e;
+  w = normalize(w);
+
+  CachedPower cached = getCachedPower( plus.e );
+  DiyFp c( cached.f , cached.e );
+  DiyFp scaledW     = multiply( w , c );
+  DiyFp scaledMinus = multiply( minus , c );
+  DiyFp scaledPlus  = multiply( plus , c );
+
+  // one unit in from each boundary covers the rounding of the multiplication
+  decimalExponent = -cached.k;
+  generateDigits( buffer , length , decimalExponent , DiyFp( scaledMinus.f + 1 , scaledMinus.e ) , scaledW ,
+                  DiyFp( scaledPlus.f - 1 , scaledPlus.e ) );
+}
+
+/* ****************************************************************************************************** *
+ * Text
+ * ****************************************************************************************************** */
+
+int Text::integer(long long value , char* buffer) {
+  char digits[24];
+  int  n = 0;
+  unsigned long long u = value < 0 ? 0ULL - static_cast< unsigned long long >(value) : value;
+  do {
+    digits[ n++ ] = '0' + u % 10;
+    u /= 10;
+  } while( u > 0 );
+
+  int length = 0;
+  if( value < 0 ) { buffer[ length++ ] = '-'; }
+  while( n > 0 ) { buffer[ length++ ] = digits[ --n ]; }
+  return(length);
+}
+
+int Text::shortest(double value , char* buffer) {
+  int length = 0;
+  if( std::signbit(value) ) {
+    buffer[ length++ ] = '-';
+    value = -value;
+  }
+  if( std::isnan(value) ) { std::memcpy( buffer , "nan" , 3 ); return(3); }
+  if( std::isinf(value) ) { std::memcpy( buffer + length , "inf" , 3 ); return( length + 3 ); }
+  if( value == 0.0 )      { buffer[ length ] = '0'; return( length + 1 ); }
+
+  char digits[20];
+  int  numDigits , decimalExponent;
+  grisu2( value , digits , numDigits , decimalExponent );
+
+  // exponent of the leading digit, d.ddd 10^x
+  int x = numDigits + decimalExponent - 1;
+  char* out = buffer + length;
+  if( x >= -4 && x < 17 ) {
+    if( x >= numDigits - 1 ) {
+      // integer, pad with zeros
+      std::memcpy( out , digits , numDigits );
+      std::memset( out + numDigits , '0' , x + 1 - numDigits );
+      return( length + x + 1 );
+    }
+    if( x >= 0 ) {
+      std::memcpy( out , digits , x + 1 );
+      out[ x + 1 ] = '.';
+      std::memcpy( out + x + 2 , digits + x + 1 , numDigits - x - 1 );
+      return( length + numDigits + 1 );
+    }
+    out[0] = '0';
+    out[1] = '.';
+    std::memset( out + 2 , '0' , -x - 1 );
+    std::memcpy( out + 1 - x , digits , numDigits );
+    return( length + 1 - x + numDigits );
+  }
+
+  int n = 0;
+  out[ n++ ] = digits[0];
+  if( numDigits > 1 ) {
+    out[ n++ ] = '.';
+    std::memcpy( out + n , digits + 1 , numDigits - 1 );
+    n += numDigits - 1;
+  }
+  out[ n++ ] = 'e';
+  out[ n++ ] = x < 0 ? '-' : '+';
+  if( std::abs(x) < 10 ) { out[ n++ ] = '0'; }
+  n += integer( std::abs(x) , out + n );
+  return( length + n );
+}
+
+std::string Text::shortest(double value) {
+  char buffer[ maxLength ];
+  return( std::string( buffer , shortest( value , buffer ) ) );
+}
+
+/* ****************************************************************************************************** *
+ * Text Writer
+ *
+ * ****************************************************************************************************** */
+
+void TextWriter::flush() {
+  out.write( buffer.data() , buffer.size() );
+  buffer.clear();
+}
+
+TextWriter& TextWriter::operator<<(double value) {
+  char number[ Text::maxLength ];
+  buffer.append( number , Text::shortest( value , number ) );
+  if( buffer.size() > bufferSize ) { flush(); }
+  return(*this);
+}
+
+TextWriter& TextWriter::operator<<(long long value) {
+  char number[ Text::maxLength ];
+  buffer.append( number , Text::integer( value , number ) );
+  if( buffer.size() > bufferSize ) { flush(); }
+  return(*this);
+}
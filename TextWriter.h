@@ -0,0 +1,134 @@
+/*
+ * Text output of doubles
+ *
+ * Text::shortest writes a double with digits that always read back to exactly the same double, and are
+ * the fewest possible for all but ~0.1% of doubles (Grisu2, F. Loitsch, "Printing floating-point numbers
+ * quickly and accurately with integers", 2010). Text output is lossless without the 17 digits of
+ * setprecision( max_digits10 ), and working on 64 bit integers is much faster than an ostream.
+ *
+ * TextWriter buffers a stream and formats large arrays in chunks on several threads, written in order.
+ */
+
+#ifndef _TEXTWRITER_HEADER_
+#define _TEXTWRITER_HEADER_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Memory.h"
+
+namespace Text {
+
+  // longest result of shortest(), e.g. -2.2250738585072014e-308
+  const int maxLength = 32;
+
+  // shortest round trip text of value into buffer, returns the number of characters (not terminated)
+  // written as %g would: fixed for decimal exponents -4 to 16, d.ddde+XX otherwise
+  int shortest(double value , char* buffer);
+  std::string shortest(double value);
+
+  // integer into buffer, returns the number of characters
+  int integer(long long value , char* buffer);
+}
+
+/* ****************************************************************************************************** *
+ * Text Writer
+ *  output is collected in a buffer and handed to the stream in large writes
+ * ****************************************************************************************************** */
+
+class TextWriter {
+  private:
+    std::ostream &out;
+    std::string   buffer;
+    Memory::Buffer accounted; // the buffer's reserve, as an output buffer
+    unsigned int  numThreads; // formatting writeArray, one per core by default
+
+    static const size_t bufferSize = 1 << 20;
+    static const size_t chunkSize  = 1 << 16; // values formatted by each thread at a time
+
+    // values [ first , last ) as text, a line break before every perLine'th value
+    template< class Values >
+    static void formatChunk(const Values &values , size_t first , size_t last , int perLine , const std::string &indent ,
+                            bool isInt , std::string &text);
+
+  public:
+    TextWriter(std::ostream &outin) : out(outin) , accounted( Memory::output , bufferSize + 1024 ) , numThreads( std::max( 1u , std::thread::hardware_concurrency() ) ) {
+      buffer.reserve( bufferSize + 1024 );
+    };
+   ~TextWriter() { flush(); };
+
+    void setNumThreads(unsigned int n) { numThreads = std::max( 1u , n ); };
+    void flush();
+    TextWriter& operator<<(const std::string &s) { buffer += s; if( buffer.size() > bufferSize ) { flush(); } return(*this); };
+    TextWriter& operator<<(const char* s)        { return( *this << std::string(s) ); };
+    TextWriter& operator<<(char c)               { buffer += c; return(*this); };
+    TextWriter& operator<<(double value);
+    TextWriter& operator<<(int value)                { return( *this << static_cast< long long >(value) ); };
+    TextWriter& operator<<(unsigned int value)       { return( *this << static_cast< long long >(value) ); };
+    TextWriter& operator<<(long value)               { return( *this << static_cast< long long >(value) ); };
+    TextWriter& operator<<(unsigned long value)      { return( *this << static_cast< long long >(value) ); };
+    TextWriter& operator<<(unsigned long long value) { return( *this << static_cast< long long >(value) ); };
+    TextWriter& operator<<(long long value);
+
+    // values(i) for i < n, each followed by a space, perLine to a line that starts with indent
+    // integer arrays are rounded
+    template< class Values >
+    void writeArray(const Values &values , size_t n , int perLine , const std::string &indent , bool isInt);
+};
+
+template< class Values >
+void TextWriter::formatChunk(const Values &values , size_t first , size_t last , int perLine , const std::string &indent ,
+                             bool isInt , std::string &text) {
+  char number[ Text::maxLength ];
+  text.clear();
+  text.reserve( ( last - first ) * ( isInt ? 8 : 24 ) );
+  for(size_t i = first; i < last; ++i) {
+    if( i > 0 && i % perLine == 0 ) {
+      text += '\n';
+      text += indent;
+    }
+    int length = isInt ? Text::integer( std::llround( values(i) ) , number ) : Text::shortest( values(i) , number );
+    text.append( number , length );
+    text += ' ';
+  }
+};
+
+template< class Values >
+void TextWriter::writeArray(const Values &values , size_t n , int perLine , const std::string &indent , bool isInt) {
+  *this << indent;
+
+  // small arrays aren't worth the threads
+  if( n < 2 * chunkSize || numThreads == 1 ) {
+    std::string text;
+    for(size_t first = 0; first < n; first += chunkSize) {
+      formatChunk( values , first , std::min( n , first + chunkSize ) , perLine , indent , isInt , text );
+      *this << text;
+    }
+    return;
+  }
+
+  // one chunk per thread at a time, so only numThreads chunks of text are held at once
+  flush();
+  std::vector< std::string > text( numThreads );
+  for(size_t first = 0; first < n; first += numThreads * chunkSize) {
+    std::vector< std::thread > threads;
+    for(unsigned int t = 0; t < numThreads; ++t) {
+      size_t begin = std::min( n , first + t * chunkSize );
+      size_t end   = std::min( n , begin + chunkSize );
+      threads.push_back( std::thread( formatChunk< Values > , std::cref(values) , begin , end , perLine ,
+                                      std::cref(indent) , isInt , std::ref( text[t] ) ) );
+    }
+    for(unsigned int t = 0; t < numThreads; ++t) {
+      threads[t].join();
+      out.write( text[t].data() , text[t].size() );
+    }
+  }
+};
+
+#endif
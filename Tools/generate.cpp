@@ -0,0 +1,289 @@
+/*
+ * Generator of large synthetic problems, for stress testing
+ *
+ *   generate <name> [--lattice N] [--pitch cm] [--radius cm] [--materials M] [--groups G] [--tallies T]
+ *                   [--tet-tallies K] [--sparse] [--mesh box|sphere] [--divisions n] [--histories H]
+ *
+ * Writes inputfiles/<name>.xml and meshfiles/<name>.thrm, run from the top of the repository.
+ *
+ * The geometry is an N x N x N lattice (default 10) of balls, one in the middle of each pitch (default 4 cm)
+ * wide box, so 2 N^3 cells: ball_i_j_k inside its sphere and mod_i_j_k, the rest of the box, bounded by its
+ * sphere and 6 of the 3 (N + 1) planes shared between neighbouring boxes. Particles leaving the lattice are
+ * lost. The moderator is material0 and the balls cycle through the other M - 1 materials (default 4), each of
+ * one nuclide with G groups (default 2) of capture and down (and in group) scattering cross sections drawn
+ * from a fixed seed: total cross sections of 0.2 to 1 /cm and scattering ratios of 0.5 to 0.95, no fission,
+ * so every history ends. The source is a point at the centre of the ball nearest the middle (setSourceSphere
+ * samples about the origin, whatever its centre).
+ *
+ * The mesh fills the lattice (box) or the ball inscribed in it (sphere) with n x n x n cubes (default 10)
+ * each split into 6 tets along its diagonal, 6 n^3 tets: n = 55 is a million, n = 100 six million. The
+ * sphere maps the cubes' vertices out radially, so it is the same tets, bent. Vertices are written with the
+ * +101.6 the mesh reader takes off.
+ *
+ * There are T (default 1) collision tallies on all_cells and K (default 1) on all_tets, storage="sparse" with
+ * --sparse. The problem runs as usual, ./a.out <name>.xml, and through the benchmarks with
+ * Benchmarks/endtoend --input <name>.xml --meshes <name> and Benchmarks/microbench --input <name>.xml.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  struct Options {
+    int         lattice    = 10;
+    double      pitch      = 4.0;
+    double      radius     = 0.0;   // 0.35 of the pitch unless given
+    int         materials  = 4;
+    int         groups     = 2;
+    int         tallies    = 1;
+    int         tetTallies = 1;
+    bool        sparse     = false;
+    std::string mesh       = "box";
+    int         divisions  = 10;
+    long        histories  = 1000;
+  };
+
+  const double meshOffset = 101.6;  // taken off every vertex by Mesh::readFile
+
+  std::string index(int i , int j , int k) {
+    return( std::to_string(i) + "_" + std::to_string(j) + "_" + std::to_string(k) );
+  }
+
+  std::string values(const std::vector< double > &v) {
+    std::ostringstream out;
+    out << std::scientific << std::setprecision(6);
+    for ( size_t i = 0; i < v.size(); i++ ) { out << ( i > 0 ? " " : "" ) << v[i]; }
+    return( out.str() );
+  }
+
+  void writeInput(const std::string &name , const Options &options) {
+    std::string   filename = "inputfiles/" + name + ".xml";
+    std::ofstream out( filename );
+    if ( ! out ) {
+      std::cout << " could not open " << filename << std::endl;
+      throw;
+    }
+    int    n    = options.lattice;
+    double p    = options.pitch;
+    double half = 0.5 * n * p;
+    out << std::setprecision(10);
+
+    out << "<?xml version = '1.0' encoding = 'UTF-8'?>\n\n"
+        << "<!-- generated by Tools/generate: " << n << "^3 lattice, " << options.materials << " materials, "
+        << options.divisions << "^3 cube " << options.mesh << " mesh -->\n\n"
+        << "<setup nhistories=\"" << options.histories << "\" ngroups=\"" << options.groups
+        << "\" xsfile=\"none\" meshfile=\"" << name << ".thrm\" loud=\"false\"/>\n"
+        << "<outfiles outfile=\"" << name << ".out\" vtkfile=\"" << name << ".vtu\" timefile=\"" << name << "_time.out\"/>\n\n";
+
+    // the same cross sections for the same options
+    std::mt19937_64 engine( 20190501 );
+    auto uniform = [&]( double a , double b ) { return( std::uniform_real_distribution< double >( a , b )( engine ) ); };
+
+    int G = options.groups;
+    out << "<nuclides>\n";
+    for ( int m = 0; m < options.materials; m++ ) {
+      std::vector< double >                capture( G );
+      std::vector< std::vector< double > > scatter( G , std::vector< double >( G , 0.0 ) );
+      for ( int g = 0; g < G; g++ ) {
+        double total = uniform( 0.2 , 1.0 );
+        double c     = uniform( 0.5 , 0.95 );
+        capture[g] = ( 1.0 - c ) * total;
+        // in group and down, the in group the largest
+        std::vector< double > w( G , 0.0 );
+        double sum = 0.0;
+        for ( int h = g; h < G; h++ ) {
+          w[h] = uniform( 0.0 , 1.0 ) + ( h == g ? 1.0 : 0.0 );
+          sum += w[h];
+        }
+        for ( int h = g; h < G; h++ ) { scatter[g][h] = c * total * w[h] / sum; }
+      }
+      out << "  <nuclide name=\"nuclide" << m << "\">\n"
+          << "    <Capture>\n      <xs value=\"" << values( capture ) << "\"/>\n    </Capture>\n"
+          << "    <Scatter>\n";
+      for ( int g = 0; g < G; g++ ) {
+        out << "      <xs incident_group=\"" << g + 1 << "\" value=\"" << values( scatter[g] ) << "\"/>\n";
+      }
+      out << "    </Scatter>\n  </nuclide>\n";
+    }
+    out << "</nuclides>\n\n<materials>\n";
+    for ( int m = 0; m < options.materials; m++ ) {
+      out << "  <material name=\"material" << m << "\" density=\"1.0\">\n"
+          << "    <nuclide name=\"nuclide" << m << "\" frac=\"1.0\"/>\n  </material>\n";
+    }
+    out << "</materials>\n\n<surfaces>\n";
+
+    const char *axes[3] = { "x" , "y" , "z" };
+    for ( int a = 0; a < 3; a++ ) {
+      for ( int i = 0; i <= n; i++ ) {
+        out << "  <plane name=\"" << axes[a] << i << "\" a=\"" << ( a == 0 ) << ".0\" b=\"" << ( a == 1 ) << ".0\" c=\""
+            << ( a == 2 ) << ".0\" d=\"" << -half + i * p << "\"/>\n";
+      }
+    }
+    for ( int k = 0; k < n; k++ ) {
+      for ( int j = 0; j < n; j++ ) {
+        for ( int i = 0; i < n; i++ ) {
+          out << "  <sphere name=\"s" << index( i , j , k ) << "\" x0=\"" << -half + ( i + 0.5 ) * p << "\" y0=\""
+              << -half + ( j + 0.5 ) * p << "\" z0=\"" << -half + ( k + 0.5 ) * p << "\" rad=\"" << options.radius << "\"/>\n";
+        }
+      }
+    }
+    out << "</surfaces>\n\n<cells>\n";
+
+    for ( int k = 0; k < n; k++ ) {
+      for ( int j = 0; j < n; j++ ) {
+        for ( int i = 0; i < n; i++ ) {
+          std::string ijk  = index( i , j , k );
+          int         ball = options.materials > 1 ? 1 + ( i + j + k ) % ( options.materials - 1 ) : 0;
+          out << "  <cell name=\"ball_" << ijk << "\" material=\"material" << ball << "\">\n"
+              << "    <surface name=\"s" << ijk << "\" sense=\"-1\"/>\n  </cell>\n"
+              << "  <cell name=\"mod_" << ijk << "\" material=\"material0\">\n"
+              << "    <surface name=\"s" << ijk << "\" sense=\"+1\"/>\n"
+              << "    <surface name=\"x" << i << "\" sense=\"+1\"/>\n    <surface name=\"x" << i + 1 << "\" sense=\"-1\"/>\n"
+              << "    <surface name=\"y" << j << "\" sense=\"+1\"/>\n    <surface name=\"y" << j + 1 << "\" sense=\"-1\"/>\n"
+              << "    <surface name=\"z" << k << "\" sense=\"+1\"/>\n    <surface name=\"z" << k + 1 << "\" sense=\"-1\"/>\n"
+              << "  </cell>\n";
+        }
+      }
+    }
+    out << "</cells>\n\n<estimators>\n";
+    for ( int t = 1; t <= options.tallies; t++ ) {
+      out << "  <CollisionTally name=\"flux" << t << "\" apply=\"cell\" applyName=\"all_cells\"/>\n";
+    }
+    for ( int t = 1; t <= options.tetTallies; t++ ) {
+      out << "  <CollisionTally name=\"tetFlux" << t << "\" apply=\"tet\" applyName=\"all_tets\""
+          << ( options.sparse ? " storage=\"sparse\"" : "" ) << "/>\n";
+    }
+    out << "</estimators>\n\n";
+
+    double middle = -half + ( n / 2 + 0.5 ) * p;
+    out << "<sources>\n  <setSourcePoint name=\"middle\" distribution=\"hardcoded\" xSource=\"" << middle << "\" ySource=\""
+        << middle << "\" zSource=\"" << middle << "\"/>\n</sources>\n";
+  }
+
+  double tetVolume(const std::vector< double > &a , const std::vector< double > &b ,
+                   const std::vector< double > &c , const std::vector< double > &d) {
+    double u[3] , v[3] , w[3];
+    for ( int i = 0; i < 3; i++ ) { u[i] = b[i] - a[i]; v[i] = c[i] - a[i]; w[i] = d[i] - a[i]; }
+    return( std::fabs( u[0] * ( v[1] * w[2] - v[2] * w[1] ) - u[1] * ( v[0] * w[2] - v[2] * w[0] )
+                     + u[2] * ( v[0] * w[1] - v[1] * w[0] ) ) / 6.0 );
+  }
+
+  // returns the volume meshed, a check of the tets
+  double writeMesh(const std::string &name , const Options &options) {
+    std::string   filename = "meshfiles/" + name + ".thrm";
+    std::ofstream out( filename );
+    if ( ! out ) {
+      std::cout << " could not open " << filename << std::endl;
+      throw;
+    }
+    int    n      = options.divisions;
+    long   nv     = long( n + 1 ) * ( n + 1 ) * ( n + 1 );
+    long   nt     = 6L * n * n * n;
+    double half   = 0.5 * options.lattice * options.pitch;
+    bool   sphere = options.mesh == "sphere";
+
+    std::vector< std::vector< double > > vertices;
+    vertices.reserve( nv );
+    for ( int k = 0; k <= n; k++ ) {
+      for ( int j = 0; j <= n; j++ ) {
+        for ( int i = 0; i <= n; i++ ) {
+          std::vector< double > q = { 2.0 * i / n - 1.0 , 2.0 * j / n - 1.0 , 2.0 * k / n - 1.0 };
+          double scale = half;
+          if ( sphere ) {
+            // the cube's surface onto the sphere's, and every cube inside it onto a sphere
+            double length = std::sqrt( q[0] * q[0] + q[1] * q[1] + q[2] * q[2] );
+            double inf    = std::max( std::fabs( q[0] ) , std::max( std::fabs( q[1] ) , std::fabs( q[2] ) ) );
+            scale *= length > 0.0 ? inf / length : 1.0;
+          }
+          vertices.push_back( { scale * q[0] , scale * q[1] , scale * q[2] } );
+        }
+      }
+    }
+
+    out << nv << "\n" << nt << "\n1\n1\n" << std::scientific << std::setprecision(16);
+    for ( long v = 0; v < nv; v++ ) {
+      out << v + 1 << " " << vertices[v][0] + meshOffset << " " << vertices[v][1] + meshOffset << " "
+          << vertices[v][2] + meshOffset << "\n";
+    }
+    // the lines the reader skips
+    for ( long t = 1; t <= nt; t++ ) { out << t << " 0 0\n"; }
+
+    // from the cube's lowest corner to its highest along each order of the axes, so neighbouring cubes'
+    // faces are split the same way
+    const int paths[6][3] = { { 0 , 1 , 2 } , { 0 , 2 , 1 } , { 1 , 0 , 2 } , { 1 , 2 , 0 } , { 2 , 0 , 1 } , { 2 , 1 , 0 } };
+    auto id = [&]( int i , int j , int k ) { return( 1 + i + ( n + 1 ) * ( j + long( n + 1 ) * k ) ); };
+    double volume = 0.0;
+    long   t      = 0;
+    for ( int k = 0; k < n; k++ ) {
+      for ( int j = 0; j < n; j++ ) {
+        for ( int i = 0; i < n; i++ ) {
+          for ( auto &path : paths ) {
+            int  corner[3] = { i , j , k };
+            long ids[4];
+            ids[0] = id( corner[0] , corner[1] , corner[2] );
+            for ( int s = 0; s < 3; s++ ) {
+              corner[ path[s] ]++;
+              ids[ s + 1 ] = id( corner[0] , corner[1] , corner[2] );
+            }
+            out << ++t << " " << ids[0] << " " << ids[1] << " " << ids[2] << " " << ids[3] << "\n";
+            volume += tetVolume( vertices[ ids[0] - 1 ] , vertices[ ids[1] - 1 ] , vertices[ ids[2] - 1 ] , vertices[ ids[3] - 1 ] );
+          }
+        }
+      }
+    }
+    return( volume );
+  }
+}
+
+int main(int argc , char *argv[])
+{
+    Options     options;
+    std::string name;
+    for ( int i = 1; i < argc; i++ ) {
+        std::string arg = argv[i];
+        if      ( arg == "--lattice"     && i + 1 < argc ) { options.lattice    = std::stoi( argv[++i] ); }
+        else if ( arg == "--pitch"       && i + 1 < argc ) { options.pitch      = std::stod( argv[++i] ); }
+        else if ( arg == "--radius"      && i + 1 < argc ) { options.radius     = std::stod( argv[++i] ); }
+        else if ( arg == "--materials"   && i + 1 < argc ) { options.materials  = std::stoi( argv[++i] ); }
+        else if ( arg == "--groups"      && i + 1 < argc ) { options.groups     = std::stoi( argv[++i] ); }
+        else if ( arg == "--tallies"     && i + 1 < argc ) { options.tallies    = std::stoi( argv[++i] ); }
+        else if ( arg == "--tet-tallies" && i + 1 < argc ) { options.tetTallies = std::stoi( argv[++i] ); }
+        else if ( arg == "--sparse"                      ) { options.sparse     = true; }
+        else if ( arg == "--mesh"        && i + 1 < argc ) { options.mesh       = argv[++i]; }
+        else if ( arg == "--divisions"   && i + 1 < argc ) { options.divisions  = std::stoi( argv[++i] ); }
+        else if ( arg == "--histories"   && i + 1 < argc ) { options.histories  = std::stol( argv[++i] ); }
+        else if ( name.empty() && arg[0] != '-'          ) { name = arg; }
+        else                                               { name.clear(); break; }
+    }
+    if ( options.radius <= 0.0 ) { options.radius = 0.35 * options.pitch; }
+
+    if ( name.empty() || options.lattice < 1 || options.materials < 1 || options.groups < 1 || options.divisions < 1
+         || options.tallies < 0 || options.tetTallies < 0 || options.histories < 1 || 2.0 * options.radius >= options.pitch
+         || ( options.mesh != "box" && options.mesh != "sphere" ) ) {
+        std::cout << "usage: generate <name> [--lattice N] [--pitch cm] [--radius cm] [--materials M] [--groups G] [--tallies T]\n"
+                  << "                       [--tet-tallies K] [--sparse] [--mesh box|sphere] [--divisions n] [--histories H]\n"
+                  << "the balls must fit in their boxes, radius < pitch / 2" << std::endl;
+        return 1;
+    }
+
+    writeInput( name , options );
+    double volume = writeMesh( name , options );
+
+    long   cells  = 2L * options.lattice * options.lattice * options.lattice;
+    double side   = options.lattice * options.pitch;
+    double meshed = options.mesh == "sphere" ? 3.14159265358979 * side * side * side / 6.0 : side * side * side;
+    std::cout << "inputfiles/" << name << ".xml: " << cells << " cells, " << cells / 2 + 3 * ( options.lattice + 1 )
+              << " surfaces, " << options.materials << " materials, " << options.tallies + options.tetTallies << " tallies" << std::endl;
+    std::cout << "meshfiles/" << name << ".thrm: " << long( options.divisions + 1 ) * ( options.divisions + 1 ) * ( options.divisions + 1 )
+              << " vertices, " << 6L * options.divisions * options.divisions * options.divisions << " tets, " << volume << " cm^3 of " << options.mesh << " ("
+              << meshed << " cm^3 exactly)" << std::endl;
+    return 0;
+}
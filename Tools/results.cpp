@@ -0,0 +1,79 @@
+/*
+ * Reader for the binary tally result file
+ *
+ *   results <file>                  list the tallies in the file
+ *   results <file> <tally> [where]  print one tally, where picks between tallies of the same name
+ *                                   by what they are applied to, e.g. "tet tet12"
+ *   results <file> <tally> --csv    one tally as csv
+ *   results <file> --csv            every tally as csv
+ *
+ * The file is mapped, only the columns of the tallies asked for are read.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "ResultFile.h"
+
+int main(int argc , char *argv[])
+{
+    if ( argc < 2 ) {
+        std::cout << "usage: results <file> [tally] [where] [--csv]" << std::endl;
+        return 1;
+    }
+
+    std::string filename = argv[1];
+    std::string tally    = "";
+    std::string where    = "";
+    bool        csv      = false;
+    for ( int i = 2; i < argc; i++ ) {
+        std::string arg = argv[i];
+        if      ( arg == "--csv"  ) { csv = true;   }
+        else if ( tally.empty()   ) { tally = arg;  }
+        else                        { where = arg;  }
+    }
+
+    ResultReader results( filename );
+
+    // every tally, one after the other under a single header
+    if ( tally.empty() && csv ) {
+        for ( int t = 0; t < results.getNumTallies(); t++ ) {
+            results.writeCSV( std::cout, t, t == 0 );
+        }
+        return 0;
+    }
+
+    if ( tally.empty() ) {
+        std::cout << filename << ": " << results.getNumTallies() << " tallies, " << results.getNumHistories() << " histories in "
+                  << results.getNumBatches() << " batches" << std::endl;
+        std::cout << "tally   applied to   bins   batches" << std::endl;
+        for ( int t = 0; t < results.getNumTallies(); t++ ) {
+            const TallyIndex &index = results.getTally(t);
+            std::cout << index.name << "   " << index.appliedTo << "   " << index.numBins << "   " << index.numBatches << std::endl;
+        }
+        return 0;
+    }
+
+    int t = results.findTally( tally, where );
+    if ( t < 0 ) {
+        std::cout << "no tally called " << tally << ( where.empty() ? "" : " on " + where ) << " in " << filename << std::endl;
+        return 1;
+    }
+
+    if ( csv ) {
+        results.writeCSV( std::cout, t );
+        return 0;
+    }
+
+    const TallyIndex &index = results.getTally(t);
+    const double* mean   = results.getMean(t);
+    const double* stdErr = results.getStdErr(t);
+    std::cout << index.name << " (" << index.appliedTo << ")" << std::endl;
+    std::cout << "bin   mean   std err   R" << std::endl;
+    for ( uint64_t j = 0; j < index.numBins; j++ ) {
+        std::cout << results.getLabel( t, j ) << "   " << mean[j] << "   " << stdErr[j] << "   "
+                  << ( mean[j] != 0.0 ? stdErr[j] / std::abs( mean[j] ) : 1.0 ) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Timeline tracing
+ */
+
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <unistd.h>
+
+#include "TextWriter.h"
+
+namespace {
+
+  struct Event {
+    const char* name;
+    uint64_t    start;
+    uint64_t    end;
+    long long   arg;
+  };
+
+  // one thread's events, events[ n % bufferSize ] is the n'th recorded
+  struct Buffer {
+    std::vector< Event > events;
+    uint64_t             count;
+    int                  tid;
+    std::string          name;
+  };
+
+  bool                                        on = false;
+  std::mutex                                  registry;  // only taken the first time a thread records
+  std::vector< std::unique_ptr< Buffer > >    buffers;
+  thread_local Buffer*                        mine = nullptr;
+  std::string                                 processName = "hammer";
+  std::vector< std::string >                  fragments;  // event lines of the workers
+
+  Buffer* buffer() {
+    if( ! mine ) {
+      std::lock_guard< std::mutex > lock(registry);
+      std::unique_ptr< Buffer > b( new Buffer );
+      b->events.resize( Trace::bufferSize );
+      b->count = 0;
+      b->tid   = buffers.size();
+      b->name  = "thread " + std::to_string( b->tid );
+      mine = b.get();
+      buffers.push_back( std::move(b) );
+    }
+    return(mine);
+  }
+
+  std::string quoted(const std::string &s) {
+    std::string q = "\"";
+    for( char c : s ) {
+      if( c == '"' || c == '\\' ) { q += '\\'; }
+      q += c;
+    }
+    return( q + "\"" );
+  }
+
+  // chrome trace times are in microseconds
+  std::string micro(uint64_t ns) {
+    return( Text::shortest( 1.0e-3 * ns ) );
+  }
+
+  // this process's events, one JSON object per line
+  std::vector< std::string > eventLines() {
+    std::string pid = std::to_string( getpid() );
+    std::vector< std::string > lines;
+    lines.push_back( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"args\":{\"name\":" + quoted(processName) + "}}" );
+
+    std::lock_guard< std::mutex > lock(registry);
+    for( const auto &b : buffers ) {
+      if( b->count == 0 ) { continue; }
+      std::string tid = std::to_string( b->tid );
+      lines.push_back( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":" + quoted(b->name) + "}}" );
+      if( b->count > Trace::bufferSize ) {
+        std::cout << "Trace of " << b->name << " dropped its first " << b->count - Trace::bufferSize << " events." << std::endl;
+      }
+      uint64_t first = b->count > Trace::bufferSize ? b->count - Trace::bufferSize : 0;
+      for( uint64_t n = first; n < b->count; n++ ) {
+        const Event &e = b->events[ n % Trace::bufferSize ];
+        std::string line = "{\"name\":" + quoted(e.name) + ",\"ph\":\"X\",\"pid\":" + pid + ",\"tid\":" + tid
+                         + ",\"ts\":" + micro(e.start) + ",\"dur\":" + micro(e.end - e.start);
+        if( e.arg >= 0 ) { line += ",\"args\":{\"n\":" + std::to_string(e.arg) + "}"; }
+        lines.push_back( line + "}" );
+      }
+    }
+    return(lines);
+  }
+}
+
+void Trace::enable() { on = true; }
+
+bool Trace::enabled() { return(on); }
+
+uint64_t Trace::now() {
+  return( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+void Trace::record(const char* name , uint64_t start , uint64_t end , long long arg) {
+  Buffer* b = buffer();
+  Event  &e = b->events[ b->count % bufferSize ];
+  e.name  = name;
+  e.start = start;
+  e.end   = end;
+  e.arg   = arg;
+  b->count++;
+}
+
+void Trace::nameThread(const std::string &name) {
+  if( on ) { buffer()->name = name; }
+}
+
+void Trace::nameProcess(const std::string &name) {
+  processName = name;
+}
+
+void Trace::clear() {
+  std::lock_guard< std::mutex > lock(registry);
+  for( auto &b : buffers ) { b->count = 0; }
+  fragments.clear();
+}
+
+void Trace::writeFragment(const std::string &filename) {
+  std::ofstream out( filename );
+  for( const auto &line : eventLines() ) {
+    out << line << '\n';
+  }
+}
+
+void Trace::readFragment(const std::string &filename) {
+  std::ifstream in( filename );
+  std::string line;
+  while( std::getline( in , line ) ) {
+    fragments.push_back( line );
+  }
+  in.close();
+  std::remove( filename.c_str() );
+}
+
+void Trace::write(const std::string &filename) {
+  std::cout << "Writing the trace to " << filename << "..." << std::endl;
+
+  std::vector< std::string > lines = eventLines();
+  lines.insert( lines.end() , fragments.begin() , fragments.end() );
+
+  std::ofstream out( filename );
+  out << "{\"traceEvents\":[\n";
+  for( size_t l = 0; l < lines.size(); l++ ) {
+    out << lines[l] << ( l + 1 < lines.size() ? ",\n" : "\n" );
+  }
+  out << "],\"displayTimeUnit\":\"ms\"}\n";
+}
@@ -0,0 +1,63 @@
+/*
+ * Timeline tracing
+ *
+ * Begin and end of the coarse phases of a run (batches, tally reductions, checkpoints, snapshot and output
+ * writes, shard merges) as a Chrome trace (chrome://tracing or ui.perfetto.dev), to see load imbalance
+ * between workers, stalls at reductions and long output phases that averages hide. Off unless the input
+ * names a tracefile, and then a phase costs two clock reads.
+ *
+ * Every thread records into a ring buffer of its own, registered under a lock the first time the thread
+ * records and never shared after that, so recording takes no lock. When a buffer is full the oldest
+ * events are overwritten and counted as dropped. Buffers are read only once the threads writing them have
+ * finished (the snapshot writer is joined before output).
+ *
+ * Forked workers start from an empty trace, write theirs to a fragment file when they finish and the parent
+ * reads the fragments back, so the file has one process per worker on the same (monotonic) clock.
+ */
+
+#ifndef _TRACE_HEADER_
+#define _TRACE_HEADER_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Trace {
+
+  // events kept per thread before the oldest are overwritten
+  const size_t bufferSize = 1 << 16;
+
+  void enable();
+  bool enabled();
+
+  // a phase that ran from start to end (ns of the steady clock), name must be a literal or outlive the trace
+  void record(const char* name , uint64_t start , uint64_t end , long long arg = -1);
+  uint64_t now();
+
+  // labels for the timeline
+  void nameThread(const std::string &name);
+  void nameProcess(const std::string &name);
+
+  // forget everything recorded, in a forked worker
+  void clear();
+
+  // a worker's events, and reading them back (and removing the file) in the parent
+  void writeFragment(const std::string &filename);
+  void readFragment(const std::string &filename);
+
+  // the trace of this process and the fragments read
+  void write(const std::string &filename);
+}
+
+// records the rest of the enclosing scope as a phase, arg (e.g. the batch) is shown with it if not -1
+class TraceScope {
+  private:
+    const char* name;
+    long long   arg;
+    uint64_t    start;
+  public:
+    TraceScope(const char* namein , long long argin = -1) : name(namein) , arg(argin) , start( Trace::enabled() ? Trace::now() : 0 ) {};
+   ~TraceScope() { if( Trace::enabled() ) { Trace::record( name , start , Trace::now() , arg ); } };
+};
+
+#endif
@@ -9,111 +9,757 @@
 using std::make_shared;
 
 //constructor
-Transport::Transport(Geom_ptr geoin, Cons_ptr consti, Mesh_ptr meshin , Time_ptr timein): geometry(geoin) , constants(consti), mesh(meshin) , timer(timein) {}
+Transport::Transport(Geom_ptr geoin, Cons_ptr consti, Mesh_ptr meshin , Time_ptr timein): numHis(0) , fomFilename("fom.out") , resultFilename("results.bin") , counterFilename("counters.json") , snapshotEvery(0) , checkpointFilename("checkpoint.bin") , checkpointEvery(0) , restart(false) , planStart(0) , planBatch(0) , histTimeOffset(0.0) , sharding(false) , shardStart(0) , shardEnd(0) , trace(false) , scoreMesh(false) , geometry(geoin) , constants(consti), mesh(meshin) , timer(timein) , progressSlot(0) 
+{
+    // timers of the scoring blocks, named once here so timing them is just an index
+    structuredTimer = timer->getTimerId( "scoring structured mesh tally" );
+    collisionTimer  = timer->getTimerId( "scoring collision tally" );
+    meshTimer       = timer->getTimerId( "scoring mesh tally" );
+    whereAmITimer   = timer->getTimerId( "whereAmI" );
+}
  
 void Transport::runTransport()
 {
-    numHis = constants->getNumHis();
-    double tally = 0;
+    unsigned long long maxHis     = constants->getNumHis();
+    int                numBatches = constants->getNumBatches();
+    double             wallLimit  = constants->getWallTimeLimit();
+
+    // the estimators that have a relative error target decide when the run is converged
+    vector< EstCol_ptr > targets;
+    for( auto est : geometry->getEstimators() ) {
+        if( est->getRelErrTarget() > 0.0 ) {
+            targets.push_back( est );
+        }
+    }
+
+    scoreMesh = mesh->hasEstimators();
+    structured = geometry->getStructuredEstimators();
 
-    for( unsigned long long i = 0; i < numHis; i++ )
+    // tally snapshots are written on their own thread while transport goes on, not of part of a run
+    if( snapshotEvery > 0 && ! sharding ) {
+        snapshots.reset( new SnapshotWriter( "outfiles/", resultFilename ) );
+    }
+
+    // pick up the tallies, history count and batches where the checkpoint left off
+    if( restart ) {
+        readCheckpoint( maxHis , numBatches );
+    }
+
+    // a shard runs the batches of histories [ shardStart , shardEnd ) of the full run and writes the sums of each 
+    // batch, merging adds them back up in batch order so the result is the same as running it all at once
+    int firstBatch = batchHistories.size();
+    int lastBatch  = numBatches;
+    std::unique_ptr< CheckpointWriter > shard;
+    if( sharding ) {
+        firstBatch = -1;
+        lastBatch  = -1;
+        for( int b = 0; b <= numBatches; b++ ) {
+            if( maxHis * b / numBatches == shardStart ) { firstBatch = b; }
+            if( maxHis * b / numBatches == shardEnd   ) { lastBatch  = b; }
+        }
+        if( firstBatch < 0 || lastBatch <= firstBatch ) {
+            cout << " shard histories [" << shardStart << ", " << shardEnd << ") have to start and end on a batch boundary, "
+                 << "multiples of " << maxHis << " / " << numBatches << " histories" << endl;
+            throw;
+        }
+        numHis = shardStart;
+        if( ! targets.empty() ) {
+            cout << "Relative error targets aren't checked in a shard, all of its histories are run." << endl;
+        }
+
+        vector< EstCol_ptr > estimators = geometry->getEstimators();
+        shard.reset( new CheckpointWriter( shardFilename , "HMRSHARD" ) );
+        shard->writeWord( maxHis );
+        shard->writeWord( numBatches );
+        shard->writeWord( shardStart );
+        shard->writeWord( shardEnd );
+        shard->writeWord( firstBatch );
+        shard->writeWord( lastBatch );
+        shard->writeWord( estimators.size() );
+        for( auto est : estimators ) {
+            shard->writeString( est->name() );
+            shard->writeString( est->getAppliedTo() );
+        }
+    }
+
+    // what the progress thread reports, the tallies are picked by name
+    if( progress ) {
+        const vector< std::string > &names = progress->getTallyNames();
+        progressTallies.assign( names.size() , vector< EstCol_ptr >() );
+        for( auto est : geometry->getEstimators() ) {
+            for( size_t t = 0; t < names.size(); t++ ) {
+                if( est->name() == names[t] ) { progressTallies[t].push_back( est ); }
+            }
+        }
+        progress->slot( progressSlot ).planned = ( sharding ? shardEnd : maxHis ) - numHis;
+    }
+
+    transportStart = std::chrono::steady_clock::now();
+
+    unsigned long long i = numHis;
+    unsigned long long firstHistory = i;
+    bool stop = false;
+    for( int b = firstBatch; b < lastBatch && !stop; b++ )
     {
+        // batch b covers histories [ maxHis * b / numBatches , maxHis * (b+1) / numBatches ), or the same split 
+        // of what's left after planBatch batches if a checkpoint is being extended
+        TraceScope batchTrace( "batch" , b );
+        unsigned long long batchStart = i;
+        unsigned long long batchEnd   = planStart + ( maxHis - planStart ) * ( b + 1 - planBatch ) / ( numBatches - planBatch );
+
+        uint64_t historiesStart = Trace::enabled() ? Trace::now() : 0;
+        while( i < batchEnd )
+        {
+            runHistory( i );
+            i++;
+            if( progress ) {
+                progress->slot( progressSlot ).histories.store( i - firstHistory , std::memory_order_relaxed );
+            }
+
+            // stop mid batch if we've run out of time, a shard has to run all of its histories
+            if( wallLimit > 0.0 && ! sharding && getTransportTime() > wallLimit )
+            {
+                cout << "Wall clock limit of " << wallLimit << " s reached after " << i << " histories." << endl;
+                stop = true;
+                break;
+            }
+        }
+
+        numHis = i;
+        if( Trace::enabled() ) {
+            Trace::record( "histories" , historiesStart , Trace::now() , b );
+        }
+
+        // FOM as a function of history count, with the transport time from the History timer
+        double histTime = histTimeOffset + timer->getTotalResult( "History" );
+
+        if( shard ) {
+            TraceScope trace( "write batch sums" , b );
+            shard->writeWord( i - batchStart );
+            shard->writeDouble( histTime );
+            for( auto est : geometry->getEstimators() ) {
+                est->writeBatchSums( *shard );
+            }
+        }
+        {
+            TraceScope trace( "reduce tallies" , b );
+            endBatch( i - batchStart );
+
+            batchHistories.push_back( numHis );
+            batchTimes.push_back( histTime );
+            for( auto est : geometry->getEstimators() ) {
+                est->recordFOM( numHis , histTime );
+            }
+        }
+
+        accountMemory();
+
+        // a shard's tallies only hold its own histories
+        if( progress ) {
+            publishProgress( sharding ? i - firstHistory : numHis );
+        }
+
+        if( snapshots && ( b + 1 ) % snapshotEvery == 0 ) {
+            takeSnapshot( b + 1 );
+        }
+
+        // report on and check the tallies with relative error targets, a shard can't tell on its own
+        if( ! targets.empty() && ! sharding )
+        {
+            bool   converged = true;
+            double time      = getTransportTime();
+            cout << "batch " << b + 1 << " of " << numBatches << ", " << numHis << " histories:" << endl;
+            for( auto est : targets ) 
+            {
+                // the figure of merit of the worst bin, 1 / ( R^2 T )
+                double relErr = est->getMaxRelativeError( numHis );
+                double fom    = relErr > 0.0 ? 1.0 / ( relErr * relErr * time ) : 0.0;
+                cout << "    " << est->name() << ": max relative error " << relErr 
+                     << " (target " << est->getRelErrTarget() << "), max VOV " << est->getMaxVOV( numHis )
+                     << ", FOM " << fom << endl;
+                converged = converged && est->isConverged( numHis );
+            }
+            if( converged && i < maxHis )
+            {
+                cout << "All relative error targets met after " << numHis << " histories." << endl;
+                stop = true;
+            }
+        }
+
+        // always at the end of the run, so it can be extended
+        if( checkpointEvery > 0 && ! sharding && ( ( b + 1 ) % checkpointEvery == 0 || b + 1 == numBatches || stop ) ) {
+            writeCheckpoint();
+        }
+    }
+
+    counters.histories     = i - firstHistory;
+    counters.transportTime = getTransportTime();
+    counters.whereAmITime  = timer->getTotalResult( "whereAmI" );
+
+    if( shard ) {
+        TraceScope trace( "write shard" );
+        counters.write( *shard );
+        if( profile ) {
+            profile->write( *shard );
+        }
+        shard->commit();
+        cout << "Shard of histories [" << shardStart << ", " << shardEnd << ") written to " << shardFilename << endl;
+    }
+
+    if( snapshots ) {
+        TraceScope trace( "wait for snapshot writer" );
+        snapshots->finish();
+        cout << snapshots->getNumWritten() << " tally snapshots written to outfiles/";
+        if( snapshots->getNumSkipped() > 0 ) {
+            cout << ", " << snapshots->getNumSkipped() << " skipped while the writer caught up";
+        }
+        cout << endl;
+    }
+}
+
+void Transport::accountMemory()
+{
+    Memory::set( Memory::geometry  , geometry->memoryUsage() );
+    Memory::set( Memory::materials , geometry->materialMemoryUsage() );
+    Memory::set( Memory::mesh      , mesh->memoryUsage() );
+
+    uint64_t tallies = profile ? profile->memoryUsage() : 0;
+    for( auto est : geometry->getEstimators() ) {
+        tallies += est->memoryUsage();
+    }
+    Memory::set( Memory::tallies , tallies );
+
+    // the bank is empty between histories, its peak is the deepest it got
+    Memory::set( Memory::banks , pstack.size() * Memory::shared< Particle >() , counters.maxBankDepth * Memory::shared< Particle >() );
+    Memory::set( Memory::output , mesh->vtkMemoryUsage() );
+}
+
+void Transport::publishProgress( unsigned long long nHist )
+{
+    Progress::Slot &slot = progress->slot( progressSlot );
+    for( size_t t = 0; t < progressTallies.size(); t++ ) {
+        double relErr = 0.0;
+        for( auto est : progressTallies[t] ) {
+            relErr = std::max( relErr , est->getMaxRelativeError( nHist ) );
+        }
+        slot.relErr[t].store( relErr , std::memory_order_relaxed );
+    }
+    slot.tallyHistories.store( nHist , std::memory_order_release );
+}
+
+void Transport::endBatch( unsigned long long nBatchHist )
+{
+    for( auto est : geometry->getEstimators() ) {
+        est->endBatch( nBatchHist );
+    }
+}
+
+void Transport::takeSnapshot( int batch )
+{
+    // copy the results out, the writer thread never touches the Estimators
+    TraceScope trace( "copy snapshot" , batch );
+    std::unique_ptr< Snapshot > snapshot( new Snapshot );
+    snapshot->batch        = batch;
+    snapshot->numHistories = numHis;
+    for( auto est : geometry->getEstimators() ) {
+        snapshot->tallies.push_back( est->getResults( numHis ) );
+    }
+    for( auto est : structured ) {
+        GridSnapshot grid;
+        grid.filename     = est->getVTKFilename();
+        grid.points       = est->getVTKPoints();
+        grid.connectivity = est->getVTKConnectivity();
+        grid.vertsPerCell = 8;
+        grid.cellType     = VTK::hexahedron;
+        grid.cellData     = est->getCellData( numHis );
+        snapshot->grids.push_back( std::move( grid ) );
+    }
+    snapshot->accounted.reset( new Memory::Buffer( Memory::output , snapshot->memoryUsage() ) );
+    snapshots->submit( std::move( snapshot ) );
+}
+
+void Transport::writeCheckpoint()
+{
+    TraceScope trace( "checkpoint" , batchHistories.size() );
+    CheckpointWriter out( "outfiles/" + checkpointFilename );
+    out.writeWord( numHis );
+    out.writeWord( constants->getNumHis() );
+    out.writeWord( constants->getNumBatches() );
+    out.writeWord( planStart );
+    out.writeWord( planBatch );
+    out.writeArray( vector< uint64_t >( batchHistories.begin() , batchHistories.end() ) );
+    out.writeArray( batchTimes );
+
+    vector< EstCol_ptr > estimators = geometry->getEstimators();
+    out.writeWord( estimators.size() );
+    for( auto est : estimators ) {
+        out.writeString( est->name() );
+        out.writeString( est->getAppliedTo() );
+        est->writeState( out );
+    }
+    out.commit();
+    cout << "Checkpoint after " << numHis << " histories written to outfiles/" << checkpointFilename << endl;
+}
+
+void Transport::readCheckpoint( unsigned long long maxHis , int numBatches )
+{
+    CheckpointReader in( "outfiles/" + checkpointFilename );
+    numHis = in.readWord();
+    unsigned long long oldMaxHis     = in.readWord();
+    int                oldNumBatches = in.readWord();
+    planStart = in.readWord();
+    planBatch = in.readWord();
+    vector< uint64_t > histories = in.readWords();
+    batchHistories.assign( histories.begin() , histories.end() );
+    batchTimes = in.readDoubles();
+    histTimeOffset = batchTimes.empty() ? 0.0 : batchTimes.back();
+
+    vector< EstCol_ptr > estimators = geometry->getEstimators();
+    if( in.readWord() != estimators.size() ) {
+        cout << " checkpoint " << in.getFilename() << " has a different number of estimators than the input" << endl;
+        throw;
+    }
+    for( auto est : estimators ) {
+        string name      = in.readString();
+        string appliedTo = in.readString();
+        if( name != est->name() || appliedTo != est->getAppliedTo() ) {
+            cout << " checkpoint " << in.getFilename() << " has estimator " << name << " (" << appliedTo << ") where the input has "
+                 << est->name() << " (" << est->getAppliedTo() << ")" << endl;
+            throw;
+        }
+        est->readState( in );
+    }
+
+    int batchesDone = batchHistories.size();
+    cout << "Restarting from " << in.getFilename() << " after " << numHis << " histories in " << batchesDone << " batches." << endl;
+
+    // more histories or batches than the run that wrote it, the rest are split over the batches still to come
+    if( maxHis != oldMaxHis || numBatches != oldNumBatches ) {
+        if( maxHis <= numHis || numBatches <= batchesDone ) {
+            cout << " extending a checkpoint of " << numHis << " histories in " << batchesDone 
+                 << " batches needs more histories and more batches" << endl;
+            throw;
+        }
+        planStart = numHis;
+        planBatch = batchesDone;
+        cout << "Extending the run to " << maxHis << " histories in " << numBatches << " batches." << endl;
+    }
+}
+
+void Transport::mergeShards( vector< std::string > filenames )
+{
+    unsigned long long   maxHis     = constants->getNumHis();
+    int                  numBatches = constants->getNumBatches();
+    vector< EstCol_ptr > estimators = geometry->getEstimators();
+
+    // order the shards by their first history and check they cover the run exactly once
+    vector< std::pair< unsigned long long , std::string > > shards;
+    for( auto filename : filenames ) {
+        CheckpointReader in( filename , "HMRSHARD" );
+        unsigned long long shardMaxHis     = in.readWord();
+        int                shardNumBatches = in.readWord();
+        if( shardMaxHis != maxHis || shardNumBatches != numBatches ) {
+            cout << " shard " << filename << " is part of a run of " << shardMaxHis << " histories in " << shardNumBatches 
+                 << " batches, the input has " << maxHis << " in " << numBatches << endl;
+            throw;
+        }
+        shards.push_back( std::make_pair( in.readWord() , filename ) );
+    }
+    std::sort( shards.begin() , shards.end() );
+
+    unsigned long long next = 0;
+    for( auto s : shards ) {
+        TraceScope shardTrace( "merge shard" , s.first );
+        CheckpointReader in( s.second , "HMRSHARD" );
+        in.readWord();
+        in.readWord();
+        unsigned long long start      = in.readWord();
+        unsigned long long end        = in.readWord();
+        int                firstBatch = in.readWord();
+        int                lastBatch  = in.readWord();
+        if( start != next ) {
+            cout << " shard " << s.second << " starts at history " << start << ", the shards so far end at " << next << endl;
+            throw;
+        }
+        if( in.readWord() != estimators.size() ) {
+            cout << " shard " << s.second << " has a different number of estimators than the input" << endl;
+            throw;
+        }
+        for( auto est : estimators ) {
+            std::string name      = in.readString();
+            std::string appliedTo = in.readString();
+            if( name != est->name() || appliedTo != est->getAppliedTo() ) {
+                cout << " shard " << s.second << " has estimator " << name << " (" << appliedTo << ") where the input has "
+                     << est->name() << " (" << est->getAppliedTo() << ")" << endl;
+                throw;
+            }
+        }
+
+        // the same steps as the end of each batch in runTransport, with the shard's sums in place of transport
+        double shardTime = 0.0;
+        for( int b = firstBatch; b < lastBatch; b++ ) {
+            TraceScope trace( "reduce tallies" , b );
+            unsigned long long nBatchHist = in.readWord();
+            shardTime = in.readDouble();
+            for( auto est : estimators ) {
+                est->addBatchSums( in );
+            }
+            numHis += nBatchHist;
+            endBatch( nBatchHist );
+
+            double histTime = histTimeOffset + shardTime;
+            batchHistories.push_back( numHis );
+            batchTimes.push_back( histTime );
+            for( auto est : estimators ) {
+                est->recordFOM( numHis , histTime );
+            }
+        }
+        histTimeOffset += shardTime;
+        EventCounter shardCounters;
+        shardCounters.read( in );
+        counters.add( shardCounters );
+        if( profile ) {
+            profile->add( in );
+        }
+        next = end;
+        cout << "Merged shard " << s.second << ", histories [" << start << ", " << end << ")" << endl;
+    }
+    if( next != maxHis ) {
+        cout << " the shards end at history " << next << " of " << maxHis << endl;
+        throw;
+    }
+}
+
+double Transport::getTransportTime()
+{
+    std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - transportStart;
+    return elapsed.count();
+}
+
+static std::string traceString( point p )
+{
+    std::ostringstream out;
+    out << "(" << p.x << ", " << p.y << ", " << p.z << ")";
+    return out.str();
+}
+
+void Transport::replayHistory( unsigned long long i )
+{
+    // same random numbers as in the run, RN_init_particle seeds the history from its index alone
+    scoreMesh  = mesh->hasEstimators();
+    structured = geometry->getStructuredEstimators();
+    trace = true;
+    runHistory( i );
+    trace = false;
+}
+
+void Transport::runHistory( unsigned long long i )
+{
         //start a timer
         timer->startHist();
+        unsigned long long numEvents = 0; // collisions and surface crossings
 	    rng->RN_init_particle(i);
         //sample src 
         Part_ptr p_new = geometry->sampleSource();
         //Part_ptr p_new = make_shared<Particle>(point(0,0,0), point(0,0,1), 1);
-        Cell_ptr startingCell = geometry->whereAmI(p_new->getPos());
+        Cell_ptr startingCell;
+        {
+            HAMMER_TIME_EVENT( *timer , whereAmITimer );
+            startingCell = geometry->whereAmI(p_new->getPos());
+        }
+        counters.sourceParticles++;
+        counters.whereAmICalls++;
         p_new->setCell(startingCell);
+        if( profile ) {
+            profile->source( startingCell , p_new->getPos() );
+        }
         pstack.push(p_new);
+        if( trace ) {
+            cout << "history " << i << " source at " << traceString( p_new->getPos() ) << " direction " << traceString( p_new->getDir() )
+                 << " group " << p_new->getGroup() << " in cell " << ( startingCell ? startingCell->name() : "(none)" ) << endl;
+        }
           
         //run history
+        // take the particle off the bank before running it, secondaries it banks go on top and run after it
+        // (last banked first), so the order only depends on the history's own random numbers
         while(!pstack.empty())
         {
            Part_ptr p = pstack.top();
+           pstack.pop();
+           if( profile && p != p_new ) {
+               profile->startFlight();
+           }
+           if( trace && p != p_new ) {
+               cout << "  from the bank: at " << traceString( p->getPos() ) << " direction " << traceString( p->getDir() ) 
+                    << " group " << p->getGroup() << endl;
+           }
             while(p->isAlive())
             {
             //p->printState();
                 Cell_ptr current_Cell = p->getCell();
 
-                double d2s = current_Cell->distToSurface(p);
+                // keep the surface that gives d2s so a crossing can be scored without another geometry query
+                Surf_ptr d2sSurface;
+                double   d2s;
+                std::tie( d2sSurface , d2s ) = current_Cell->closestSurface(p);
                 double d2c = current_Cell->distToCollision(p);
             //cout << "d2s: " << d2s << "  d2c: " << d2c << endl;
                 
+                numEvents++;
                 if(d2s > d2c) //collision!
                 {
-                    // score collision tally in current cell
-                    timer->startTimer("scoring collision tally");
-                    current_Cell->scoreTally(p , current_Cell->getMat()->getMacroXS( p ) ); 
-                    tally++;
-                    timer->endTimer("scoring collision tally");
-
-                    timer->startTimer("scoring mesh tally");
-                    //std::cout << "About to score mesh tally " << std::endl;
-                    // score mesh tally
-                    //mesh->scoreTally( p , current_Cell->getMat()->getMacroXS( p ) ); // TODO: uncomment this line (for testing only)
-                    //std::cout << "We scored that mesh tally! " << std::endl;
-                    timer->endTimer("scoring mesh tally");
+                    // every response of every tally scores from the same row of macroscopic cross sections
+                    const double* xs = current_Cell->getMat()->getMacroXSRow( p );
+
+                    // track length through the structured meshes up to the collision
+                    if( ! structured.empty() ) {
+                        HAMMER_TIME_EVENT( *timer , structuredTimer );
+                        for( auto est : structured ) {
+                            est->scoreTrack( p , xs , d2c );
+                        }
+                    }
 
+                    // score at the collision site
                     p->move(d2c);
-                    current_Cell->getMat()->sampleCollision( p, pstack );
+
+                    // score structured mesh collision tallies, the grid cell follows from the position
+                    if( ! structured.empty() ) {
+                        HAMMER_TIME_EVENT( *timer , structuredTimer );
+                        for( auto est : structured ) {
+                            est->scoreCollision( p , xs );
+                        }
+                    }
+
+                    // score collision tally in current cell
+                    {
+                        HAMMER_TIME_EVENT( *timer , collisionTimer );
+                        current_Cell->scoreTally(p , xs ); 
+                    }
+
+                    // score mesh tally, locating the tet is expensive so only when the mesh has tallies
+                    if( scoreMesh ) {
+                        HAMMER_TIME_EVENT( *timer , meshTimer );
+                        mesh->scoreTally( p , xs );
+                    }
+
+                    size_t banked = pstack.size();
+                    Reaction_ptr reaction = current_Cell->getMat()->sampleCollision( p, pstack );
                     p->kill(); //TODO: make this not awful
+                    counters.collisions[ reaction->type() ]++;
+                    if( profile ) {
+                        profile->collision( current_Cell , p->getPos() );
+                    }
+                    if( reaction->type() == fissionReaction ) {
+                        counters.fissionBanked += pstack.size() - banked;
+                        counters.maxBankDepth   = std::max< uint64_t >( counters.maxBankDepth , pstack.size() );
+                    }
+                    if( trace ) {
+                        cout << "  collision in cell " << current_Cell->name() << " at " << traceString( p->getPos() ) 
+                             << " after " << d2c << " cm, group " << p->getGroup() << ", " << pstack.size() - banked << " banked" << endl;
+                    }
                 }
                 else //hit surface
                 {
+                    // track length through the structured meshes up to the surface
+                    if( ! structured.empty() ) {
+                        HAMMER_TIME_EVENT( *timer , structuredTimer );
+                        const double* xs = current_Cell->getMat()->getMacroXSRow( p );
+                        for( auto est : structured ) {
+                            est->scoreTrack( p , xs , d2s );
+                        }
+                    }
 
-                    p->move(d2s + 0.00000001);
-                    Cell_ptr newCell = geometry->whereAmI(p->getPos());
+                    // score surface tallies at the crossing point, before nudging across
+                    p->move(d2s);
+                    if( d2sSurface->hasEstimators() ) {
+                        d2sSurface->scoreTally( p , d2sSurface->crossingNormal( p->getPos() ) );
+                    }
+
+                    p->move(0.00000001);
+                    Cell_ptr newCell;
+                    {
+                        HAMMER_TIME_EVENT( *timer , whereAmITimer );
+                        newCell = geometry->whereAmI(p->getPos());
+                    }
+                    counters.crossings++;
+                    counters.whereAmICalls++;
+                if( profile ) {
+                    profile->crossing( current_Cell , newCell , p->getPos() );
+                }
                 if(newCell == nullptr)
                 {
+                    counters.lostParticles++;
                     p->kill();
                 }
                 else
                 {
                     p->setCell(newCell);
                 }
+                if( trace ) {
+                    cout << "  crossed surface " << d2sSurface->name() << " at " << traceString( p->getPos() ) << " after " << d2s << " cm into " 
+                         << ( newCell ? "cell " + newCell->name() : "no cell, lost" ) << endl;
+                }
                 }
             }
-            pstack.pop();
         }
         //tell all estimators that the history has ended
          for( auto cell : geometry->getCells() ) {
         cell->endTallyHist();
+         }
+         for( auto surf : geometry->getSurfaces() ) {
+        surf->endTallyHist();
          }
 
            // end histories in the mesh
            mesh->endTallyHist();
+           for( auto est : structured ) {
+               est->endHist();
+           }
 
         // end the history timer
-        timer->endHist();
-    }
-    tally /= numHis;
-    //cout << "tally " << tally << endl;
+        timer->endHist( i , numEvents );
+        if( trace ) {
+            cout << "history " << i << " ended after " << numEvents << " collisions and surface crossings" << endl;
+        }
 }
 
 void Transport::output() {
+    TraceScope trace( "output" );
     cout << std::endl << "Total Number of Histories: " << numHis << endl;
 
-    int i = 0;
-    /*
+    // cell tallies are small enough to print
     for( Cell_ptr cell : geometry->getCells() ) {
-        ++i;
-        std::cout << "Collision tally in cell " << i << std::endl;
-        for( int j = 1; j <= constants->getNumGroups(); ++j) {
-            std::cout << " group: " << j << ", tally = " << cell->getSingleGroupTally(j, numHis).first 
-                      << ", stddev = " << cell->getSingleGroupTally(j, numHis).second << std::endl;
+        for( auto est : cell->getEstimators() ) {
+            std::cout << std::endl << "Tally " << est->name() << " in cell " << cell->name() << std::endl;
+            vector< Estimator_ptr > bins = est->getEstimators();
+            for( unsigned int j = 0; j < bins.size(); ++j) {
+                std::cout << " bin: " << est->getBinLabel(j) << ", tally = " << bins[j]->getScalarEstimator(numHis).first 
+                          << ", R = " << bins[j]->getRelativeError(numHis) << std::endl;
+            }
         }
-        cout << std::endl;
     }
-    */
 
     // print timing information
-    timer->printAvgResults();
+    {
+        TraceScope trace( "timing reports" );
+        timer->printAvgResults();
+        counters.writeJSON( "outfiles/" + counterFilename );
+        printFOMReport();
+    }
+    {
+        TraceScope trace( "write results" );
+        writeResults();
+    }
+
+    // estimators with output files of their own (structured meshes, functional expansions)
+    {
+        TraceScope trace( "write estimator output" );
+        for( auto est : geometry->getEstimators() ) {
+            est->writeOutput( numHis );
+        }
+    }
+
+    // the cost profile goes on the mesh, with the tet tallies
+    if ( profile ) {
+        profile->writeTable( "outfiles/profile.out" );
+        profile->addCellData();
+    }
 
     // print mesh estimators to file
-    mesh->printMeshTallies();
-    if ( constants->getAllTets() ) {
-        mesh->writeToVTK();
+    TraceScope meshTrace( "write mesh output" );
+    mesh->printMeshTallies( numHis );
+    if ( constants->getAllTets() || profile ) {
+        mesh->writeToVTK( numHis );
     }
 }
+
+void Transport::writeResults() {
+    cout << "Writing tally results to " << "outfiles/" << resultFilename << "..." << endl;
+
+    ResultWriter results( "outfiles/" + resultFilename, numHis, batchHistories.size() );
+    for( auto est : geometry->getEstimators() ) {
+        results.addTally( est->getResults( numHis ) );
+    }
+    results.close();
+}
+
+void Transport::printFOMReport() {
+    cout << std::endl << "Printing figure of merit report to " << "outfiles/" << fomFilename << "..." << endl;
+
+    std::ofstream fomOut;
+    fomOut.open( "outfiles/" + fomFilename );
+
+    fomOut << "Figure of merit FOM = 1 / ( R^2 T ), T = transport time (s) from the History timer" << endl;
+    fomOut << "batch   histories   T" << endl;
+    for( unsigned int b = 0; b < batchHistories.size(); b++ ) {
+        fomOut << b + 1 << "   " << batchHistories[b] << "   " << batchTimes[b] << endl;
+    }
+    fomOut << endl;
+
+    // bin by bin only for the cell and surface tallies, the tet and mesh tallies have bins for every element
+    // and are summed up per tally
+    auto perBin = []( const EstCol_ptr &est ) {
+        std::string where = est->getAppliedTo();
+        return( where.compare( 0 , 4 , "tet " ) != 0 && where.compare( 0 , 5 , "mesh " ) != 0 );
+    };
+    std::map< std::string , std::pair< int , int > > elementBins; // bins and unstable bins of each element tally
+
+    // summary: bins whose FOM hasn't settled over the last half of the batches
+    int numBins     = 0;
+    int numUnstable = 0;
+    fomOut << "Bins with an unstable FOM (spread over the last half of the batches > " 
+           << Estimator::fomTolerance * 100 << "% of its mean):" << endl;
+    for( auto est : geometry->getEstimators() ) {
+        vector< Estimator_ptr > bins = est->getEstimators();
+        std::pair< int , int > *element = nullptr;
+        if( ! perBin( est ) ) {
+            std::string where = est->getAppliedTo();
+            element = &elementBins[ est->name() + " (" + ( where.compare( 0 , 4 , "tet " ) == 0 ? "tets" : where ) + ")" ];
+        }
+        for( unsigned int j = 0; j < bins.size(); j++ ) {
+            numBins++;
+            if( element ) { element->first++; }
+            if( ! bins[j]->hasStableFOM() ) {
+                numUnstable++;
+                if( element ) {
+                    element->second++;
+                    continue;
+                }
+                fomOut << "  " << est->name() << " (" << est->getAppliedTo() << ") bin " << est->getBinLabel(j) 
+                       << ", R = " << bins[j]->getRelativeError( numHis ) << endl;
+            }
+        }
+    }
+    for( auto &element : elementBins ) {
+        if( element.second.second > 0 ) {
+            fomOut << "  " << element.first << ": " << element.second.second << " of " << element.second.first << " bins" << endl;
+        }
+    }
+    if( numUnstable == 0 ) {
+        fomOut << "  none" << endl;
+    }
+    fomOut << endl;
+
+    // FOM history of every cell and surface tally bin
+    for( auto est : geometry->getEstimators() ) {
+        if( ! perBin( est ) ) { continue; }
+        fomOut << est->name() << " (" << est->getAppliedTo() << ")" << endl;
+        fomOut << "bin   mean   R   VOV   FOM by batch" << endl;
+        vector< Estimator_ptr > bins = est->getEstimators();
+        for( unsigned int j = 0; j < bins.size(); j++ ) {
+            fomOut << est->getBinLabel(j) << "   " << bins[j]->getScalarEstimator( numHis ).first << "   " 
+                   << bins[j]->getRelativeError( numHis ) << "   " << bins[j]->getVOV( numHis ) << "  ";
+            for( double fom : bins[j]->getFOMHistory() ) {
+                fomOut << " " << fom;
+            }
+            if( ! bins[j]->hasStableFOM() ) {
+                fomOut << "   *** unstable";
+            }
+            fomOut << endl;
+        }
+        fomOut << endl;
+    }
+    fomOut.close();
+
+    cout << numUnstable << " of " << numBins << " tally bins have an unstable figure of merit." << endl;
+}
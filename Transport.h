@@ -7,11 +7,17 @@
 #ifndef __TRANSPORT_H__
 #define __TRANSPORT_H__
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <stack>
 #include <limits>
+#include <map>
 #include <string>
+#include <tuple>
+#include <chrono>
+#include <fstream>
+#include <sstream>
 
 
 #include "Cell.h"
@@ -25,6 +31,13 @@
 #include "Mesh.h"
 #include "Tet.h"
 #include "HammerTime.h"
+#include "Snapshot.h"
+#include "Checkpoint.h"
+#include "EventCounter.h"
+#include "CostProfile.h"
+#include "Trace.h"
+#include "Memory.h"
+#include "Progress.h"
 
 using std::vector;
 using std::stack;
@@ -40,19 +53,58 @@ typedef std::shared_ptr<Mesh>       Mesh_ptr;
 typedef std::shared_ptr<HammerTime> Time_ptr;
 typedef std::shared_ptr<Geometry>   Geom_ptr;
 typedef std::shared_ptr<Constants>  Cons_ptr;
+typedef std::shared_ptr<EstimatorCollection> EstCol_ptr;
 
 class Transport {
 private:
-    int numHis;
+    unsigned long long numHis; // histories actually run, may stop short of constants->getNumHis()
+    std::chrono::steady_clock::time_point transportStart;
+    vector< unsigned long long > batchHistories; // cumulative histories at the end of each batch
+    vector< double >             batchTimes;     // cumulative History timer total at the end of each batch
+    std::string fomFilename;
+    std::string resultFilename;
+    std::string counterFilename;
+    int snapshotEvery; // batches between tally snapshots, 0 for none
+    std::unique_ptr< SnapshotWriter > snapshots;
+    std::string checkpointFilename;
+    int checkpointEvery; // batches between checkpoints, 0 for none
+    bool restart;        // carry on from the checkpoint instead of starting over
+    unsigned long long planStart; // batches from planBatch on split [ planStart , nhistories ) evenly,
+    int planBatch;                // from 0 unless a checkpoint was extended with more histories
+    double histTimeOffset;        // History timer total of the runs before a restart
+    bool sharding;                // run only histories [ shardStart , shardEnd ) and write their batch sums
+    unsigned long long shardStart;
+    unsigned long long shardEnd;
+    std::string shardFilename;
+    bool trace;                   // print every event of a history, for replaying one
+    bool scoreMesh; // whether any tet or mesh wide estimators need the collision tet
+    vector< StructEstCol_ptr > structured; // structured mesh tallies, scored on every flight and collision
     //vector<Mat_ptr> mats;
     //vector<Cell_ptr> cells;    //vector of cells (to be moved into Geometry)
     //vector<Surf_ptr> surfaces; //vector of surfaces '
     stack<Part_ptr> pstack;
-    vector<double> tallies;
     Cons_ptr constants;
     Geom_ptr geometry; 
     Mesh_ptr mesh;
     Time_ptr timer;
+    TimerId structuredTimer;
+    TimerId collisionTimer;
+    TimerId meshTimer;
+    TimerId whereAmITimer;
+    EventCounter counters; // of the histories run in this process, and of the shards merged
+    std::unique_ptr< CostProfile > profile; // where the time goes, only if asked for
+    std::shared_ptr< Progress > progress;   // counts for the progress thread, none if it's off
+    int progressSlot;                       // this process's
+    vector< vector< EstCol_ptr > > progressTallies; // the collections of each tally name progress reports
+
+    void runHistory( unsigned long long i );
+    void endBatch( unsigned long long nBatchHist );
+    void publishProgress( unsigned long long nHist );
+    void printFOMReport();
+    void writeResults();
+    void takeSnapshot( int batch );
+    void writeCheckpoint();
+    void readCheckpoint( unsigned long long maxHis , int numBatches );
     
 public:
     //constructor
@@ -64,6 +116,31 @@ public:
     //void setup();
     void runTransport();
     void output();
+
+    void setFOMFilename( std::string filename ) { fomFilename = filename; };
+    void setResultFilename( std::string filename ) { resultFilename = filename; };
+    void setCounterFilename( std::string filename ) { counterFilename = filename; };
+    void setProfile( bool on ) { profile.reset( on ? new CostProfile( geometry , mesh ) : nullptr ); };
+    void setProgress( std::shared_ptr< Progress > progressin , int slot = 0 ) { progress = progressin; progressSlot = slot; };
+    void setSnapshotInterval( int batches ) { snapshotEvery = batches; };
+    void setCheckpoint( std::string filename , int batches ) { checkpointFilename = filename; checkpointEvery = batches; };
+    void setRestart( bool restartin ) { restart = restartin; };
+    void setShard( unsigned long long start , unsigned long long end , std::string filename = "" ) {
+        sharding = true; shardStart = start; shardEnd = end; 
+        shardFilename = filename.empty() ? "outfiles/shard_" + std::to_string( start ) + "_" + std::to_string( end ) + ".bin" : filename;
+    };
+
+    // the tallies of a run from the shard files of its histories, in place of runTransport
+    void mergeShards( vector< std::string > filenames );
+
+    // bytes held by each subsystem, for Memory::print
+    void accountMemory();
+
+    // rerun one history of the run with every source, collision, crossing and banked particle printed
+    void replayHistory( unsigned long long i );
+
+    unsigned long long getNumHis() { return numHis; };
+    double             getTransportTime(); // wall clock seconds since runTransport started
 };
 
 #endif
@@ -107,18 +107,10 @@ int Utility::linearizeIndices( std::vector<int> indices , std::vector<int> binSi
     std::cerr << "Error in Utility::linearizeIndices! indices and binSizes must be the same size" << std::endl;
     throw;
   }
+  // row major: the last index varies fastest
   int n = 0;
-  if(binSizes.size() == 1) {
-    return(indices.at(0));
-  }
-  else {
-    for(int i = 1; i < indices.size(); ++i) {
-      int add = indices.at(i);
-      for(int j = i-1; j < 0; --j) {
-        add *= binSizes.at(j);
-      }
-      n += add;
-    }
+  for(int i = 0; i < indices.size(); ++i) {
+    n = n * binSizes.at(i) + indices.at(i);
   }
 
   return(n);
@@ -151,3 +143,47 @@ double pointL2( point a , point b ) {
   return( (a - b)*(a - b) );
 }
 
+/* ****************************************************************************************************** * 
+ * Orthogonal Polynomials
+ *
+ * ****************************************************************************************************** */ 
+
+void Utility::legendre( int order, double x, vector< double > &values ) {
+  values.resize( order + 1 );
+  values[0] = 1.0;
+  if ( order > 0 ) { values[1] = x; }
+  // ( n + 1 ) P_n+1 = ( 2n + 1 ) x P_n - n P_n-1
+  for ( int n = 1; n < order; ++n ) {
+    values[n+1] = ( ( 2*n + 1 ) * x * values[n] - n * values[n-1] ) / ( n + 1 );
+  }
+}
+
+int Utility::numZernike( int order ) {
+  return ( order + 1 ) * ( order + 2 ) / 2;
+}
+
+void Utility::zernike( int order, double rho, double theta, vector< double > &values ) {
+  values.resize( numZernike( order ) );
+
+  // powers of rho and factorials for the radial polynomials
+  vector< double > rhoPow( order + 1, 1.0 );
+  vector< double > fact  ( order + 1, 1.0 );
+  for ( int i = 1; i <= order; ++i ) {
+    rhoPow[i] = rhoPow[i-1] * rho;
+    fact[i]   = fact[i-1] * i;
+  }
+
+  int j = 0;
+  for ( int n = 0; n <= order; ++n ) {
+    for ( int m = -n; m <= n; m += 2 ) {
+      int ma = std::abs( m );
+      // R_n^m = sum_k (-1)^k ( n - k )! / ( k! ( (n+m)/2 - k )! ( (n-m)/2 - k )! ) rho^( n - 2k )
+      double radial = 0.0;
+      for ( int k = 0; k <= ( n - ma ) / 2; ++k ) {
+        double c = fact[n-k] / ( fact[k] * fact[ (n+ma)/2 - k ] * fact[ (n-ma)/2 - k ] );
+        radial += ( k % 2 == 0 ? c : -c ) * rhoPow[ n - 2*k ];
+      }
+      values[j++] = radial * ( m >= 0 ? std::cos( ma * theta ) : std::sin( ma * theta ) );
+    }
+  }
+}
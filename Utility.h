@@ -17,9 +17,10 @@ namespace Utility {
  * This namespace collects all of the functions and abstract classes that are widely used in MC-Hammer
  *  There is 1 class:
  *    - Binning Structure
- *  and 3 function groups:
+ *  and 4 function groups:
  *    - Matrix Operations
  *    - Generic Vector Operations
+ *    - Orthogonal Polynomials
  *    - Miscellaneous
  *
  * ****************************************************************************************************** */ 
@@ -28,9 +29,10 @@ namespace Utility {
  * Binning Structure
  *  A class template dealing with binning over an attribute of varying data types
  *    - Constructed with a min, max, and integer size
+ *    - For integer attributes pass max one past the largest value, so that binWidth is exact
  *    - getIndex is constant lookup time, 
  *        - returns < n , true >, where n is the index where 'value' falls in the binning structure 
- *          if 'value' is in [min , max]
+ *          if 'value' is in [min , max] ( [min , max) for integer attributes )
  *        - returns < 0 , false > otherwise
  *    - attributeType should typically be either an int, float or double; must be castable both to/from int
  *    - attributeType must have comparator operators >= and <= overloaded
@@ -50,8 +52,12 @@ namespace Utility {
       std::pair<int , bool> getIndex(attributeType value)
       {
         std::pair <int , bool> out;
-        if (value <= max and value >= min) {
-          out.first  = static_cast<int>(value / binWidth);
+        // integer max is one past the largest value, so it is outside
+        bool belowMax = std::numeric_limits<attributeType>::is_integer ? value < max : value <= max;
+        if (belowMax and value >= min) {
+          out.first  = static_cast<int>( (value - min) / binWidth );
+          // value == max belongs to the last bin
+          if (out.first == size) { out.first = size - 1; }
           out.second = true;
         }
         else{
@@ -157,6 +163,19 @@ namespace Utility {
   // L2 norm of two points
   double pointL2( point a , point b );
 
+/* ****************************************************************************************************** * 
+ * Orthogonal Polynomials
+ *   Bases for the functional expansion tallies, each fills values with every term up to order
+ * ****************************************************************************************************** */ 
+
+  // Legendre polynomials P_0(x) ... P_order(x) on [-1 , 1]
+  void legendre( int order, double x, vector< double > &values );
+
+  // Zernike polynomials on the unit disc for n = 0 ... order, m = -n , -n+2 ... n, ordered by n then m
+  // Z_n^m = R_n^m(rho) cos(m theta) for m >= 0 and R_n^|m|(rho) sin(|m| theta) for m < 0
+  void zernike( int order, double rho, double theta, vector< double > &values );
+  int  numZernike( int order );
+
 /* ****************************************************************************************************** * 
  * Miscellaneous                      
  *
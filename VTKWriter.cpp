@@ -0,0 +1,371 @@
+/*
+ VTK (xml) unstructured grid writer, shared by the tet mesh and the structured mesh tallies
+ */
+
+#include "VTKWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifdef HAMMER_ZLIB
+#include <zlib.h>
+#endif
+
+// settings for the files written after setEncoding
+static VTK::Encoding vtkEncoding = VTK::raw;
+#ifdef HAMMER_ZLIB
+static bool          vtkCompress = true;
+#else
+static bool          vtkCompress = false;
+#endif
+
+// uncompressed size of the blocks an appended array is split into, the VTK default
+static const size_t blockSize = 32768;
+
+// shortest text that reads back to the same value
+static std::string toString( double value ) {
+    return Text::shortest( value );
+}
+
+static size_t base64Length( size_t numBytes ) {
+    return 4 * ( ( numBytes + 2 ) / 3 );
+}
+
+/* ****************************************************************************************************** *
+ * Data arrays
+ *  value i is values[i], or start + step * i for the arrays that are generated (offsets and types)
+ * ****************************************************************************************************** */
+
+struct Array {
+    std::string   name;
+    std::string   type;        // Float64 , Int64 or UInt8
+    int           components;
+    size_t        count;       // number of values
+    const double* values;
+    double        start , step;
+
+    Array( std::string n , std::string t , int c , const std::vector< double > &v ) :
+        name(n) , type(t) , components(c) , count( v.size() ) , values( v.data() ) , start(0.0) , step(0.0) {};
+    Array( std::string n , std::string t , size_t c , double s , double d ) :
+        name(n) , type(t) , components(1) , count(c) , values(nullptr) , start(s) , step(d) {};
+
+    double value( size_t i ) const { return values ? values[i] : start + step * i; };
+    size_t typeSize()        const { return type == "UInt8" ? 1 : 8; };
+    size_t numBytes()        const { return count * typeSize(); };
+};
+
+// bytes of the values in [ first , first + n ) in the file type, converted into buffer when needed
+// (the file is little endian, as is every machine this runs on)
+static const char* getBytes( const Array &a , size_t first , size_t n , std::vector< char > &buffer ) {
+    if ( a.type == "Float64" && a.values ) {
+        return reinterpret_cast< const char* >( a.values + first );
+    }
+    buffer.resize( n * a.typeSize() );
+    if ( a.type == "Float64" ) {
+        double* out = reinterpret_cast< double* >( buffer.data() );
+        for ( size_t i = 0; i < n; i++ ) { out[i] = a.value( first + i ); }
+    }
+    else if ( a.type == "Int64" ) {
+        int64_t* out = reinterpret_cast< int64_t* >( buffer.data() );
+        for ( size_t i = 0; i < n; i++ ) { out[i] = std::llround( a.value( first + i ) ); }
+    }
+    else {
+        uint8_t* out = reinterpret_cast< uint8_t* >( buffer.data() );
+        for ( size_t i = 0; i < n; i++ ) { out[i] = std::lround( a.value( first + i ) ); }
+    }
+    return buffer.data();
+}
+
+// the array as zlib compressed blocks and the header VTK reads them with:
+// number of blocks , block size , size of a partial last block (0 if full) , compressed size of each block
+struct CompressedArray {
+    std::vector< uint64_t > header;
+    std::string             data;
+};
+
+static CompressedArray compressArray( const Array &a ) {
+    CompressedArray c;
+    size_t numBytes  = a.numBytes();
+    size_t numBlocks = ( numBytes + blockSize - 1 ) / blockSize;
+    c.header = { numBlocks , blockSize , numBytes % blockSize };
+
+#ifdef HAMMER_ZLIB
+    size_t perBlock = blockSize / a.typeSize();
+    std::vector< char > buffer;
+    std::vector< Bytef > compressed( compressBound( blockSize ) );
+    for ( size_t b = 0; b < numBlocks; b++ ) {
+        size_t n = std::min( perBlock , a.count - b * perBlock );
+        const char* bytes = getBytes( a , b * perBlock , n , buffer );
+
+        // favor speed, most of the size is gained at the lowest level
+        uLongf length = compressed.size();
+        int status = compress2( compressed.data() , &length , reinterpret_cast< const Bytef* >( bytes ) , n * a.typeSize() , Z_BEST_SPEED );
+        if ( status != Z_OK ) {
+            std::cout << " zlib could not compress VTK array " << a.name << " (error " << status << ")" << std::endl;
+            throw;
+        }
+        c.header.push_back( length );
+        c.data.append( reinterpret_cast< const char* >( compressed.data() ) , length );
+    }
+#endif
+    return c;
+}
+
+/* ****************************************************************************************************** *
+ * Appended data stream
+ *  writes bytes as they are (raw) or base64 encodes them, three bytes at a time
+ * ****************************************************************************************************** */
+
+class AppendedStream {
+  private:
+    std::ostream  &out;
+    bool           encode;
+    unsigned char  pending[3];
+    int            numPending;
+
+    void encodePending() {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        char quad[4];
+        quad[0] = table[ pending[0] >> 2 ];
+        quad[1] = table[ ( ( pending[0] & 0x03 ) << 4 ) | ( pending[1] >> 4 ) ];
+        quad[2] = numPending > 1 ? table[ ( ( pending[1] & 0x0f ) << 2 ) | ( pending[2] >> 6 ) ] : '=';
+        quad[3] = numPending > 2 ? table[ pending[2] & 0x3f ] : '=';
+        out.write( quad , 4 );
+        numPending = 0;
+    }
+
+  public:
+    AppendedStream( std::ostream &outin , bool encodein ) : out(outin) , encode(encodein) , numPending(0) {};
+
+    void write( const char* data , size_t n ) {
+        if ( ! encode ) {
+            out.write( data , n );
+            return;
+        }
+        for ( size_t i = 0; i < n; i++ ) {
+            pending[ numPending++ ] = data[i];
+            if ( numPending == 3 ) { encodePending(); }
+        }
+    }
+
+    // pad the last partial group, the next write starts a new base64 encoding
+    void finish() {
+        if ( numPending > 0 ) {
+            for ( int i = numPending; i < 3; i++ ) { pending[i] = 0; }
+            encodePending();
+        }
+    }
+};
+
+// size of the array in the appended section, in bytes of the file
+static size_t appendedLength( const Array &a , const CompressedArray* c , bool encode ) {
+    if ( c ) {
+        size_t headerBytes = 8 * c->header.size();
+        return encode ? base64Length( headerBytes ) + base64Length( c->data.size() ) : headerBytes + c->data.size();
+    }
+    return encode ? base64Length( 8 + a.numBytes() ) : 8 + a.numBytes();
+}
+
+static void writeAppended( AppendedStream &stream , const Array &a , const CompressedArray* c ) {
+    if ( c ) {
+        // VTK decodes the compression header separately from the blocks
+        stream.write( reinterpret_cast< const char* >( c->header.data() ) , 8 * c->header.size() );
+        stream.finish();
+        stream.write( c->data.data() , c->data.size() );
+        stream.finish();
+        return;
+    }
+
+    uint64_t numBytes = a.numBytes();
+    stream.write( reinterpret_cast< const char* >( &numBytes ) , 8 );
+    size_t perBlock = blockSize / a.typeSize();
+    std::vector< char > buffer;
+    for ( size_t first = 0; first < a.count; first += perBlock ) {
+        size_t n = std::min( perBlock , a.count - first );
+        stream.write( getBytes( a , first , n , buffer ) , n * a.typeSize() );
+    }
+    stream.finish();
+}
+
+static void writeAscii( std::ostream &out , const Array &a , int level , int perLine ) {
+    TextWriter text( out );
+    text.writeArray( [&a]( size_t i ) { return a.value(i); }, a.count, perLine, std::string( 2*level+2 , ' ' ), a.type != "Float64" );
+    text << '\n';
+}
+
+/* ****************************************************************************************************** *
+ * Writer
+ * ****************************************************************************************************** */
+
+void VTK::setEncoding( Encoding encoding , bool compress ) {
+#ifndef HAMMER_ZLIB
+    if ( compress ) {
+        std::cout << " built without zlib, VTK files will not be compressed" << std::endl;
+        compress = false;
+    }
+#endif
+    vtkEncoding = encoding;
+    vtkCompress = compress && encoding != ascii;
+}
+
+void VTK::setEncoding( std::string encoding , std::string compressor ) {
+    Encoding e;
+    if      ( encoding == "ascii"  ) { e = ascii;  }
+    else if ( encoding == "base64" ) { e = base64; }
+    else if ( encoding == "raw"    ) { e = raw;    }
+    else {
+        std::cout << " unknown VTK encoding " << encoding << ", use ascii, base64 or raw" << std::endl;
+        throw;
+    }
+    if ( compressor != "none" && compressor != "zlib" ) {
+        std::cout << " unknown VTK compressor " << compressor << ", use none or zlib" << std::endl;
+        throw;
+    }
+    setEncoding( e , compressor == "zlib" );
+}
+
+void VTK::writeUnstructuredGrid( std::string filename , const std::vector< double > &points ,
+                                 const std::vector< double > &connectivity , int vertsPerCell , int cellType ,
+                                 const std::vector< CellData > &cellData ) {
+    std::vector< const CellData* > data;
+    for ( const auto &d : cellData ) {
+        data.push_back( &d );
+    }
+    writeUnstructuredGrid( filename, points, connectivity, vertsPerCell, cellType, data );
+}
+
+void VTK::writeUnstructuredGrid( std::string filename , const std::vector< double > &points ,
+                                 const std::vector< double > &connectivity , int vertsPerCell , int cellType ,
+                                 const std::vector< const CellData* > &cellData ) {
+
+    int numPoints = points.size() / 3;
+    int numCells  = connectivity.size() / vertsPerCell;
+
+    // every array in the order it is written, the cell data followed by the points and the cells
+    std::vector< Array > arrays;
+    for ( auto data : cellData ) {
+        arrays.push_back( Array( data->first, "Float64", 1, data->second ) );
+    }
+    arrays.push_back( Array( "Points", "Float64", 3, points ) );
+    arrays.push_back( Array( "connectivity", "Int64", 1, connectivity ) );
+    arrays.push_back( Array( "offsets", "Int64", numCells, vertsPerCell, vertsPerCell ) ); // tells vtk how to segment the the cell associations
+    arrays.push_back( Array( "types", "UInt8", numCells, cellType, 0.0 ) );                // tells vtk which type of cell to build
+    int firstPoints = cellData.size();
+
+    // compressed sizes are only known after compressing, so the compressed blocks are kept until written
+    bool binary = vtkEncoding != ascii;
+    bool encode = vtkEncoding == base64;
+    std::vector< CompressedArray > compressed;
+    if ( vtkCompress ) {
+        for ( const auto &a : arrays ) {
+            compressed.push_back( compressArray( a ) );
+        }
+    }
+    std::vector< size_t > offsets( 1 , 0 );
+    for ( size_t i = 0; i < arrays.size(); i++ ) {
+        offsets.push_back( offsets[i] + appendedLength( arrays[i], vtkCompress ? &compressed[i] : nullptr, encode ) );
+    }
+
+    std::ofstream vtkStream;
+    vtkStream.open( filename, std::ios::binary );
+
+    // Specify file type
+    XMLTag vtkfile( 0, "VTKFile" );
+    vtkfile.addAttribute( "type", "UnstructuredGrid" );
+    vtkfile.addAttribute( "version", "1.0" );
+    vtkfile.addAttribute( "byte_order", "LittleEndian" );
+    vtkfile.addAttribute( "header_type", "UInt64" );
+    if ( vtkCompress ) {
+        vtkfile.addAttribute( "compressor", "vtkZLibDataCompressor");
+    }
+
+    // Specify grid type
+    XMLTag unstGrid( 1, "UnstructuredGrid");
+
+    // Piece (has information for points and cells)
+    XMLTag piece( 2, "Piece" );
+    piece.addAttribute( "NumberOfPoints", std::to_string(numPoints) );
+    piece.addAttribute( "NumberOfCells", std::to_string(numCells) );
+
+    // Point Data (not currently using)
+    XMLTag pointData1( 3, "PointData" );
+
+    // CellData, one data array per tally
+    XMLTag cellDataTag( 3, "CellData" );
+    if ( ! cellData.empty() ) {
+        cellDataTag.addAttribute( "Scalars", cellData[0]->first );
+    }
+
+    XMLTag pointsTag( 3, "Points" );
+    XMLTag cells( 3, "Cells" );
+
+    // data array tag, followed by the values in ascii or pointing into the appended data
+    auto writeArray = [&]( int i, int perLine ) {
+        const Array &a = arrays[i];
+        XMLTag tag( 4, "DataArray" );
+        tag.addAttribute( "type", a.type );
+        tag.addAttribute( "Name", a.name );
+        if ( a.components > 1 ) {
+            tag.addAttribute( "NumberOfComponents", std::to_string( a.components ) );
+        }
+        tag.addAttribute( "format", binary ? "appended" : "ascii" );
+        if ( binary ) {
+            tag.addAttribute( "offset", std::to_string( offsets[i] ) );
+        }
+        if ( a.count > 0 ) {
+            double min = a.value(0);
+            double max = a.value(0);
+            for ( size_t j = 1; j < a.count; j++ ) {
+                min = std::min( min, a.value(j) );
+                max = std::max( max, a.value(j) );
+            }
+            tag.addAttribute( "RangeMin", toString( min ) );
+            tag.addAttribute( "RangeMax", toString( max ) );
+        }
+        vtkStream << tag.getTagOpen() << std::endl;
+        if ( ! binary ) {
+            writeAscii( vtkStream, a, 4, perLine );
+        }
+        vtkStream << tag.getTagClose() << std::endl;
+    };
+
+    // Write all XMLTags and Data Arrays to file
+    vtkStream << "<?xml version=\"1.0\"?>" << std::endl;
+    vtkStream << vtkfile.getTagOpen() << std::endl;
+    vtkStream << unstGrid.getTagOpen() << std::endl;
+    vtkStream << piece.getTagOpen() << std::endl;
+    vtkStream << pointData1.getTagOpen() << std::endl;
+    vtkStream << pointData1.getTagClose() << std::endl;
+    vtkStream << cellDataTag.getTagOpen() << std::endl;
+    // loop over the estimator tallies and write to file
+    for ( int i = 0; i < firstPoints; i++ ) {
+        writeArray( i, 24 );
+    }
+    vtkStream << cellDataTag.getTagClose() << std::endl;
+    vtkStream << pointsTag.getTagOpen() << std::endl;
+    writeArray( firstPoints, 12 );
+    vtkStream << pointsTag.getTagClose() << std::endl;
+    vtkStream << cells.getTagOpen() << std::endl;
+    writeArray( firstPoints + 1, 24 );
+    writeArray( firstPoints + 2, 16 );
+    writeArray( firstPoints + 3, 32 );
+    vtkStream << cells.getTagClose() << std::endl;
+    vtkStream << piece.getTagClose() << std::endl;
+    vtkStream << unstGrid.getTagClose() << std::endl;
+
+    // binary blocks follow the underscore, at the offsets given in the data array tags
+    if ( binary ) {
+        XMLTag appended( 1, "AppendedData" );
+        appended.addAttribute( "encoding", encode ? "base64" : "raw" );
+        vtkStream << appended.getTagOpen() << std::endl << "   _";
+        AppendedStream stream( vtkStream, encode );
+        for ( size_t i = 0; i < arrays.size(); i++ ) {
+            writeAppended( stream, arrays[i], vtkCompress ? &compressed[i] : nullptr );
+        }
+        vtkStream << std::endl << appended.getTagClose() << std::endl;
+    }
+    vtkStream << vtkfile.getTagClose() << std::endl;
+
+    vtkStream.close();
+}
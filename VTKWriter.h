@@ -0,0 +1,52 @@
+/*
+ VTK (xml) unstructured grid writer, shared by the tet mesh and the structured mesh tallies
+
+ Arrays are written either inline as ascii text (slow and large, but readable for debugging) or as
+ binary blocks in the appended data section, raw or base64 encoded and optionally zlib compressed.
+ Binary arrays are converted to the file type a block at a time straight from the caller's vectors.
+ */
+
+#ifndef __VTKWRITER_H__
+#define __VTKWRITER_H__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "XMLTag.h"
+#include "TextWriter.h"
+
+namespace VTK {
+
+  // VTK cell type numbers
+  const int tetrahedron = 10;
+  const int hexahedron  = 12;
+
+  // how the data arrays are stored in the file
+  enum Encoding { ascii , base64 , raw };
+
+  // a named array with one value per cell
+  typedef std::pair< std::string , std::vector< double > > CellData;
+
+  // encoding and compression of every file written afterwards, raw and zlib compressed by default
+  // (uncompressed if built without zlib)
+  void setEncoding( Encoding encoding , bool compress );
+  void setEncoding( std::string encoding , std::string compressor ); // "ascii" "base64" "raw" , "none" "zlib"
+
+  // write an unstructured grid of cells that all have vertsPerCell vertices and the same VTK cell type
+  // points are x y z triplets, connectivity holds vertsPerCell (0 based) point indices per cell
+  void writeUnstructuredGrid( std::string filename , const std::vector< double > &points ,
+                              const std::vector< double > &connectivity , int vertsPerCell , int cellType ,
+                              const std::vector< CellData > &cellData );
+
+  // the same with the cell data by pointer, for arrays the caller keeps in more than one place
+  void writeUnstructuredGrid( std::string filename , const std::vector< double > &points ,
+                              const std::vector< double > &connectivity , int vertsPerCell , int cellType ,
+                              const std::vector< const CellData* > &cellData );
+}
+
+#endif
@@ -18,20 +18,9 @@ void XMLTag::addDataArray( std::vector< double > newDataArray ) {
 }
 
 void XMLTag::arrayToFile( std::ofstream &outStream, int perLine, bool isInt ) {
-	int i = 0;
-	outStream << std::string( 2*level+2, ' ');
-	for ( auto element : dataArray ) {
-		if (i==perLine) {
-			i = 0;
-			outStream << "\n" << std::string( 2*level+2, ' ');
-		}
-		if (isInt) {
-			element = round(element);
-		}
-		outStream << element << " ";
-		i++;
-	}
-	outStream << std::endl;
+	TextWriter text( outStream );
+	text.writeArray( [this]( size_t i ) { return dataArray[i]; }, dataArray.size(), perLine, std::string( 2*level+2, ' '), isInt );
+	text << '\n';
 }
 
 std::string XMLTag::getTagOpen() {
@@ -13,6 +13,8 @@
 #include <fstream>
 #include <math.h>
 
+#include "TextWriter.h"
+
 /*
 XMLTag class can be used for generating and printing 
 xml-style tags by naming them and adding attributes